@@ -21,15 +21,20 @@
 #define OFPROTO_BCM_PROVIDER_H 1
 
 #include <ofproto/ofproto-provider.h>
+#include <ovs/dynamic-string.h>
 #include <opennsl/types.h>
 #include <opennsl/l3.h>
 
+#include "ops-pbmp.h"
+
 /* No bfd/cfm status change. */
 #define NO_STATUS_CHANGE -1
 
 /* vrf */
 #define BCM_MAX_VRFS 1024
 
+struct ops_route_table;
+
 struct bcmsdk_provider_rule {
     struct rule up;
     struct ovs_mutex stats_mutex;
@@ -51,6 +56,8 @@ struct ofbundle {
     char *name;                 /* Identifier for log messages. */
 
     /* Configuration. */
+    struct ds settings;         /* Key of the last settings applied, empty
+                                 * if they must be applied again. */
     struct ovs_list ports;      /* Contains "struct ofport"s. */
     enum port_vlan_mode vlan_mode; /* VLAN mode */
     int vlan;                   /* -1=trunk port, else a 12-bit VLAN ID. */
@@ -58,7 +65,7 @@ struct ofbundle {
                                  * NULL if all VLANs are trunked. */
     bool trunk_all_vlans;       /* Indicates whether this port is implicitly
                                    trunking all VLANs defined in VLAN table. */
-    opennsl_pbmp_t *pbm;        /* Bitmap of ports in this bundle that have
+    ops_pbmp_t pbm;             /* Bitmap of ports in this bundle that have
                                    VLANs configured. */
     struct lacp *lacp;          /* LACP if LACP is enabled, otherwise NULL. */
     struct bond *bond;          /* Nonnull iff more than one port. */
@@ -133,6 +140,8 @@ struct bcmsdk_provider_node {
     /* Bridging. */
     struct netflow *netflow;
     struct hmap bundles;        /* Contains "struct ofbundle"s. */
+    ops_pbmp_t trunk_all_pbm;   /* Ports of all bundles implicitly
+                                 * trunking all VLANs. */
     struct mac_learning *ml;
     struct mcast_snooping *ms;
     bool has_bonded_bundles;
@@ -147,6 +156,7 @@ struct bcmsdk_provider_node {
                                  * is backing up VRF and not bridge */
     size_t vrf_id;              /* If vrf is true, then specifies hw vrf_id
                                  * for the specific ofproto instance */
+    struct ops_route_table *rtable; /* If vrf is true, routes of the vrf */
 
 
     /* Spanning tree. */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2015 Hewlett-Packard Development Company, L.P.
+ * All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ *
+ * File: ops-hw-queue.h
+ *
+ * Purpose: This file provides public definitions for the OpenSwitch
+ *          hardware programming thread and its command queue.
+ */
+
+#ifndef __OPS_HW_QUEUE_H__
+#define __OPS_HW_QUEUE_H__ 1
+
+#include <ovs/dynamic-string.h>
+
+#include <opennsl/types.h>
+#include <opennsl/l3.h>
+#include <opennsl/trunk.h>
+
+enum ops_hw_cmd_type {
+    OPS_HW_CMD_ROUTE_DELETE,
+    OPS_HW_CMD_VLAN_PORT_ADD,
+    OPS_HW_CMD_VLAN_PORT_REMOVE,
+    OPS_HW_CMD_TRUNK_MEMBER_ADD,
+    OPS_HW_CMD_TRUNK_MEMBER_DELETE,
+};
+
+/* Command run by the programming thread. 'done' is called from the main
+ * loop once the command ran, with 'rc' set to its result. */
+struct ops_hw_cmd {
+    enum ops_hw_cmd_type type;
+    int hw_unit;
+    void (*done)(struct ops_hw_cmd *cmd);   /* NULL if not needed */
+    void *aux;                              /* for 'done' */
+    int rc;
+    union {
+        opennsl_l3_route_t route;
+        struct {
+            opennsl_vlan_t vid;
+            opennsl_pbmp_t pbmp;
+            opennsl_pbmp_t ubmp;            /* VLAN_PORT_ADD only */
+        } vlan;
+        struct {
+            opennsl_trunk_t tid;
+            opennsl_trunk_member_t member;
+        } trunk;
+    };
+    uint32_t seq;                           /* position in the queue */
+};
+
+/* Objects written by the commands, as passed to ops_hw_queue_sync() */
+extern uint32_t ops_hw_obj_route(const opennsl_l3_route_t *route);
+extern uint32_t ops_hw_obj_vlan(int hw_unit, opennsl_vlan_t vid);
+extern uint32_t ops_hw_obj_trunk(int hw_unit, opennsl_trunk_t tid);
+extern uint32_t ops_hw_obj_port(int hw_unit, opennsl_port_t hw_port);
+
+extern void ops_hw_queue_init(void);
+extern void ops_hw_cmd_init(struct ops_hw_cmd *cmd, enum ops_hw_cmd_type type,
+                            int hw_unit);
+extern void ops_hw_queue_submit(const struct ops_hw_cmd *cmd);
+extern void ops_hw_queue_sync(uint32_t obj);
+extern void ops_hw_queue_flush(void);
+extern void ops_hw_queue_async_set(bool enable);
+extern void ops_hw_queue_run(void);
+extern void ops_hw_queue_wait(void);
+extern void ops_hw_queue_dump(struct ds *ds);
+
+#endif /* __OPS_HW_QUEUE_H__ */
@@ -24,6 +24,29 @@
 
 #include <opennsl/types.h>
 
+#include "platform-defines.h"
+
+// Port bitmap for all switch chip units held by value, so it can live
+// on the stack or inside another structure.  'units' can be passed to
+// any of the functions below.
+typedef struct ops_pbmp {
+    opennsl_pbmp_t units[MAX_SWITCH_UNITS];
+} ops_pbmp_t;
+
+// Scratch port bitmaps for the duration of a single call.  The arena
+// sits on the caller's stack, so there is nothing to free on return.
+#define OPS_PBMP_ARENA_SIZE 4
+
+struct ops_pbmp_arena {
+    ops_pbmp_t pbmps[OPS_PBMP_ARENA_SIZE];
+    int n_used;
+};
+
+extern void ops_pbmp_arena_init(struct ops_pbmp_arena *arena);
+
+// Returns a cleared port bitmap from "arena".
+extern opennsl_pbmp_t * ops_pbmp_arena_get(struct ops_pbmp_arena *arena);
+
 // Allocates port bitmap structure for all switch chip units.
 extern opennsl_pbmp_t * bcmsdk_alloc_pbmp(void);
 extern void bcmsdk_destroy_pbmp(opennsl_pbmp_t *pbm);
@@ -48,4 +71,12 @@ extern void bcmsdk_pbmp_and(opennsl_pbmp_t *dst_pbm,
                             const opennsl_pbmp_t *src_pbm_1,
                             const opennsl_pbmp_t *src_pbm_2);
 
+// Copies "src_pbm" into "dst_pbm".
+extern void bcmsdk_pbmp_assign(opennsl_pbmp_t *dst_pbm,
+                               const opennsl_pbmp_t *src_pbm);
+
+// ORs "src_pbm" bits into "dst_pbm".
+extern void bcmsdk_pbmp_or(opennsl_pbmp_t *dst_pbm,
+                           const opennsl_pbmp_t *src_pbm);
+
 #endif /* __OPS_PBMP_H__ */
@@ -21,6 +21,7 @@
 #define __OPS_ROUTING_H__ 1
 
 #include <ovs/dynamic-string.h>
+#include <ovs/list.h>
 #include <opennsl/types.h>
 #include <opennsl/l2.h>
 #include <opennsl/l3.h>
@@ -33,32 +34,88 @@
 #define IPV4_BUFFER_LEN     32
 #define IPV6_BUFFER_LEN     64
 
-#define OPS_ROUTE_HASH_MAXSIZE 64
-
 #define OPS_FAILURE(rc) (((rc) < 0 ) || ((rc) == EINVAL))
 
+/* Number of flow buckets of an ecmp group in resilient hashing mode */
+#define OPS_ECMP_RESILIENT_BUCKETS  256
+
+/* Maximum number of members of an ecmp group, with the nexthops
+ * replicated according to their weight */
+#define OPS_ECMP_MAX_MEMBERS        256
+
+#ifndef OFPROTO_ECMP_HASH_RESILIENT
+#define OFPROTO_ECMP_HASH_RESILIENT 0x10
+#endif
+
 enum ops_route_state {
     OPS_ROUTE_STATE_NON_ECMP = 0,
     OPS_ROUTE_STATE_ECMP
 };
 
+/* ECMP group in the ASIC, shared by all routes that resolve to the same
+ * set of egress objects. Keyed by the sorted list of egress object ids. */
+struct ops_ecmp_group {
+    struct hmap_node node;          /* ops_ecmp_groups */
+    opennsl_if_t ecmp_intf;         /* ecmp object id in the ASIC */
+    int refcnt;                     /* number of routes using this group */
+    int n_egress;
+    opennsl_if_t egress_ids[OPS_ECMP_MAX_MEMBERS]; /* sorted egress ids */
+    struct ovs_list members;        /* members on a port (ops_ecmp_member) */
+    int n_down;                     /* members removed on link down */
+    bool reconciled;                /* taken over on a warm restart */
+};
+
+/* Binary route key. Fixed size so that it is hashed and compared as a
+ * block of words. The prefix is stored in network order with the host
+ * bits cleared, IPv4 uses the first 4 bytes. */
+struct ops_route_key {
+    uint32_t vrf;
+    uint8_t  is_ipv6;               /* IP V4/V6 */
+    uint8_t  prefixlen;
+    uint16_t pad;                   /* always zero */
+    uint8_t  prefix[16];            /* route prefix */
+};
+
+struct ops_nexthop {
+    struct hmap_node node;            /* route->nexthops */
+    enum ofproto_nexthop_type type;   /* v4/v6 */
+    char *id;                         /* IP address or Port name */
+    int  l3_egress_id;
+    struct ops_route *route;          /* route using this nexthop */
+    struct ops_vrf_nexthop *vrf_nh;   /* nexthop in ops_nexthop_table */
+    struct ovs_list vrf_nh_node;      /* in vrf_nh->nexthops */
+};
+
+/* Routes of a vrf, opaque to the provider */
+struct ops_route_table;
+
+/* Route in the fib compression trie of its vrf */
+struct ops_fib_node;
+
 struct ops_route {
     struct hmap_node node;          /* all_routes */
-    int vrf;
-    char *prefix;                   /* route prefix */
-    char *from;                     /* routing protocol (BGP, OSPF) using this route */
-    bool is_ipv6;                   /* IP V4/V6 */
+    struct ops_route_key key;       /* vrf, family and prefix */
     int n_nexthops;
     struct hmap nexthops;           /* list of selected next hops */
     enum ops_route_state rstate;     /* state of route */
-    int  nh_index;                  /* next hop index ecmp*/
+    struct ops_ecmp_group *ecmp_grp; /* shared ecmp group, NULL if non-ecmp */
+    bool in_host_table;             /* host-length prefix programmed in the
+                                     * host table instead of the lpm */
+    struct ops_fib_node *fib_node;  /* NULL if the vrf is not compressed */
+    struct ops_nexthop nh_inline;   /* next hop stored in the route, free
+                                     * if its route is NULL */
 };
 
-struct ops_nexthop {
-    struct hmap_node node;            /* route->nexthops */
-    enum ofproto_nexthop_type type;   /* v4/v6 */
+/* Nexthop of a vrf, shared by all routes using it. Reverse index from
+ * the nexthop to its routes (and through them to their ecmp groups),
+ * used to move the routes to a new egress object when the nexthop
+ * resolves or unresolves, without waiting for every route to be pushed
+ * again. */
+struct ops_vrf_nexthop {
+    struct hmap_node node;            /* ops_nexthop_table */
+    int vrf;
     char *id;                         /* IP address or Port name */
-    int  l3_egress_id;
+    struct ovs_list nexthops;         /* route nexthops (ops_nexthop) */
 };
 
 struct net_address {
@@ -66,18 +123,6 @@ struct net_address {
     char *address;
 };
 
-/* Node keeping track of egress_object id's. Used only for mac-move scenarios */
-struct ops_mac_move_egress_id {
-    struct  hmap_node node;
-    int     egress_object_id;
-};
-
-/* Hashmap of egress object ID's. Only used for mac-moves.
- * key = vlan_id + mac_addr
- * val = ID of the row in Egress table (in ASIC) for given vlan_id and mac_addr.
- */
-extern struct hmap ops_mac_move_egress_id_map;
-
 extern int ops_l3_init(int);
 
 extern opennsl_l3_intf_t *ops_routing_enable_l3_interface(int hw_unit,
@@ -126,6 +171,34 @@ extern int ops_routing_route_entry_action(int hw_unit,
                                          enum ofproto_route_action action,
                                          struct ofproto_route *routep);
 
+extern int ops_routing_route_audit(int hw_unit, struct ds *ds, bool repair);
+extern void ops_routing_route_audit_set_interval(int seconds);
+extern int ops_routing_route_audit_get_interval(void);
+extern void ops_routing_route_audit_run(void);
+extern void ops_routing_route_audit_wait(void);
+extern struct ops_route_table *ops_routing_route_table_create(int hw_unit,
+                                                              opennsl_vrf_t vrf);
+extern void ops_routing_route_table_destroy(struct ops_route_table *rtable);
+extern void ops_routing_route_table_run(void);
+extern void ops_routing_route_table_wait(void);
+extern void ops_routing_reconcile_run(void);
+extern void ops_routing_reconcile_wait(void);
+extern void ops_routing_reconcile_done(void);
+extern void ops_routing_reconcile_dump(struct ds *ds);
+extern void ops_routing_perf_dump(struct ds *ds);
+extern void ops_routing_perf_reset(void);
+extern void ops_routing_host_routes_set(bool enable);
+extern bool ops_routing_host_routes_get(void);
+extern int ops_routing_fib_compress_set(opennsl_vrf_t vrf, bool enable);
+extern void ops_routing_fib_run(void);
+extern void ops_routing_fib_wait(void);
+extern void ops_routing_fib_dump(struct ds *ds, int vrf);
+
+extern int ops_routing_nexthop_weight_set(int hw_unit, int vrf,
+                                          const char *id, int weight);
+extern int ops_routing_ecmp_max_members_set(int hw_unit, int max_members);
+extern void ops_routing_wcmp_dump(struct ds *ds);
+
 extern int ops_routing_host_entry_action(int hw_unit, opennsl_vrf_t vrf_id,
                                          enum ofproto_host_action action,
                                          struct ofproto_l3_host *host_info);
@@ -141,7 +214,12 @@ extern void ops_l3route_dump(struct ds *ds, int ipv6_enabled);
 extern void ops_l3egress_dump(struct ds *ds, int egressid);
 extern void ops_l3ecmp_egress_dump(struct ds *ds, int ecmpid);
 
+extern void ops_routing_link_state_change(int unit, opennsl_port_t hw_port,
+                                          bool link_up);
+
 extern void ops_l3_mac_move_cb(int unit, opennsl_l2_addr_t *l2addr,
                                 int operation, void *userdata);
+extern void ops_routing_mac_move_run(void);
+extern void ops_routing_mac_move_wait(void);
 
 #endif /* __OPS_ROUTING_H__ */
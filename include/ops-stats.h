@@ -16,12 +16,44 @@
  *
  * File: ops-stats.h
  *
- * Purpose: This file provides public definitions for Interface statistics API.
+ * Purpose: This file provides public definitions for Interface statistics
+ *          and hardware table occupancy API.
  */
 
 #ifndef __OPS_STAT_H__
 #define __OPS_STAT_H__ 1
 
+#include <ovs/dynamic-string.h>
+
+struct netdev_stats;
+
+// Hardware tables whose occupancy is tracked.
+enum ops_hw_table {
+    OPS_HW_TABLE_HOST = 0,
+    OPS_HW_TABLE_ROUTE_V4,
+    OPS_HW_TABLE_ROUTE_V6,
+    OPS_HW_TABLE_EGRESS,
+    OPS_HW_TABLE_ECMP_GROUP,
+    OPS_HW_TABLE_ECMP_MEMBER,
+    OPS_HW_TABLE_L3_INTF,
+    OPS_HW_TABLE_VLAN,
+    OPS_HW_TABLE_TRUNK,
+    OPS_HW_TABLE_MAX
+};
+
+struct ops_hw_table_usage {
+    int used;           // entries in use
+    int max;            // table size, 0 if unknown
+    int high_water;     // highest number of entries used
+};
+
 extern int bcmsdk_get_port_stats(int hw_unit, int hw_port, struct netdev_stats *stats);
 
+extern void ops_hw_table_init(int hw_unit);
+extern void ops_hw_table_update(int hw_unit, enum ops_hw_table table, int delta);
+extern int bcmsdk_get_hw_table_usage(int hw_unit, enum ops_hw_table table,
+                                     struct ops_hw_table_usage *usage);
+extern const char *ops_hw_table_name(enum ops_hw_table table);
+extern void ops_hw_table_dump(struct ds *ds);
+
 #endif /* __OPS_STAT_H__ */
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2015 Hewlett-Packard Development Company, L.P.
+ * All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ *
+ * File: ops-switch-control.h
+ *
+ * Purpose: This file provides public definitions for the OpenSwitch
+ *          switch control shadow cache.
+ */
+
+#ifndef __OPS_SWITCH_CONTROL_H__
+#define __OPS_SWITCH_CONTROL_H__ 1
+
+#include <ovs/dynamic-string.h>
+
+#include <opennsl/types.h>
+#include <opennsl/switch.h>
+
+/* FIXME : Remove once this control is exposed by opennsl */
+#define opennslSwitchHashMultipath ((opennsl_switch_control_t)135)
+
+extern int ops_switch_control_init(int hw_unit);
+extern int ops_switch_control_get(int hw_unit, opennsl_switch_control_t type,
+                                  int *value);
+extern int ops_switch_control_set(int hw_unit, opennsl_switch_control_t type,
+                                  int value);
+extern void ops_switch_control_dump(struct ds *ds);
+
+#endif /* __OPS_SWITCH_CONTROL_H__ */
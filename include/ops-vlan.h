@@ -35,6 +35,10 @@ extern int bcmsdk_add_access_ports(int vid, opennsl_pbmp_t *pbm);
 extern int bcmsdk_del_access_ports(int vid, opennsl_pbmp_t *pbm);
 extern void bcmsdk_add_trunk_ports(int vid, opennsl_pbmp_t *pbm);
 extern void bcmsdk_del_trunk_ports(int vid, opennsl_pbmp_t *pbm);
+extern void bcmsdk_add_trunk_ports_range(int first_vid, int last_vid,
+                                         opennsl_pbmp_t *pbm);
+extern void bcmsdk_del_trunk_ports_range(int first_vid, int last_vid,
+                                         opennsl_pbmp_t *pbm);
 extern void bcmsdk_add_native_tagged_ports(int vid, opennsl_pbmp_t *pbm);
 extern void bcmsdk_del_native_tagged_ports(int vid, opennsl_pbmp_t *pbm);
 extern void bcmsdk_add_native_untagged_ports(int vid, opennsl_pbmp_t *pbm, bool internal);
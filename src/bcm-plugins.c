@@ -24,6 +24,8 @@
 #include "bufmon-bcm-provider.h"
 #include "netdev-bcmsdk.h"
 #include "ofproto-bcm-provider.h"
+#include "ops-hw-queue.h"
+#include "ops-routing.h"
 
 #define init libovs_bcm_plugin_LTX_init
 #define run libovs_bcm_plugin_LTX_run
@@ -45,10 +47,22 @@ init(void) {
 
 void
 run(void) {
+    ops_hw_queue_run();
+    ops_routing_route_audit_run();
+    ops_routing_mac_move_run();
+    ops_routing_reconcile_run();
+    ops_routing_route_table_run();
+    ops_routing_fib_run();
 }
 
 void
 wait(void) {
+    ops_hw_queue_wait();
+    ops_routing_route_audit_wait();
+    ops_routing_mac_move_wait();
+    ops_routing_reconcile_wait();
+    ops_routing_route_table_wait();
+    ops_routing_fib_wait();
 }
 
 void
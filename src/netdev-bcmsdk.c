@@ -274,6 +274,7 @@ netdev_bcmsdk_set_config(struct netdev *netdev_, const struct smap *args)
                     netdev->subintf_vlan_id = 0;
                 }
                 netdev->knet_if_id = parent_netdev->knet_if_id;
+                netdev_change_seq_changed(netdev_);
             } else {
                 VLOG_ERR("Unable to cast parent port. "
                         "intf_name=%s parent_name=%s",
@@ -408,6 +409,8 @@ netdev_bcmsdk_set_hw_intf_info(struct netdev *netdev_, const struct smap *args)
         } else {
             netdev->intf_initialized = true;
         }
+        /* Hardware info changed, the bundle using it is applied again. */
+        netdev_change_seq_changed(netdev_);
     }
     ovs_mutex_unlock(&netdev->mutex);
     return 0;
@@ -979,6 +982,7 @@ netdev_internal_bcmsdk_set_hw_intf_info(struct netdev *netdev_, const struct sma
         } else {
             netdev->intf_initialized = true;
         }
+        netdev_change_seq_changed(netdev_);
     }
 
     ovs_mutex_unlock(&netdev->mutex);
@@ -34,6 +34,7 @@
 #include "ops-vlan.h"
 #include "ops-lag.h"
 #include "ops-routing.h"
+#include "ops-stats.h"
 #include "ops-knet.h"
 #include "netdev-bcmsdk.h"
 #include "platform-defines.h"
@@ -192,8 +193,10 @@ construct(struct ofproto *ofproto_)
 
         VLOG_DBG("Allocated VRF ID %zu for VRF %s\n",
                  ofproto->vrf_id, ofproto_->name);
+        ofproto->rtable = ops_routing_route_table_create(0, ofproto->vrf_id);
     } else {
         ofproto->vrf = false;
+        ofproto->rtable = NULL;
     }
 
     ofproto->netflow = NULL;
@@ -201,6 +204,7 @@ construct(struct ofproto *ofproto_)
     ofproto->rstp = NULL;
     ofproto->dump_seq = 0;
     hmap_init(&ofproto->bundles);
+    bcmsdk_clear_pbmp(ofproto->trunk_all_pbm.units);
     ofproto->ms = NULL;
     ofproto->has_bonded_bundles = false;
     ofproto->lacp_enabled = false;
@@ -244,6 +248,10 @@ destruct(struct ofproto *ofproto_ OVS_UNUSED)
     sset_destroy(&ofproto->port_poll_set);
 
     if (ofproto->vrf) {
+        /* the routes of the vrf are deleted from the asic in the
+         * background */
+        ops_routing_route_table_destroy(ofproto->rtable);
+        ofproto->rtable = NULL;
         release_vrf_id(ofproto->vrf_id);
     }
 
@@ -335,27 +343,84 @@ bfd_status_changed(struct ofport *ofport_ OVS_UNUSED)
 
 /* Bundles. */
 
+#define VLAN_BITMAP_LONGS BITMAP_N_LONGS(VLAN_BITMAP_SIZE)
+
+/* Calls 'apply' once per run of consecutive VLANs set in 'vlans', a
+ * word at a time, so that a full trunk is a single range. */
 static void
-add_trunked_vlans(unsigned long *vlan_list, opennsl_pbmp_t *pbm)
+vlan_bitmap_for_each_range(const unsigned long *vlans, opennsl_pbmp_t *pbm,
+                           void (*apply)(int first_vid, int last_vid,
+                                         opennsl_pbmp_t *pbm))
+{
+    unsigned long word, rest;
+    int first = -1;
+    int base, bit;
+    size_t i;
+
+    for (i = 0; i < VLAN_BITMAP_LONGS; i++) {
+        word = vlans[i];
+        /* Nothing starts or ends in this word. */
+        if ((first < 0) ? !word : (word == ~0UL)) {
+            continue;
+        }
+
+        base = i * BITMAP_ULONG_BITS;
+        bit = 0;
+        while (bit < BITMAP_ULONG_BITS) {
+            /* Look for the next bit that starts or ends a run. */
+            rest = ((first < 0) ? word : ~word) >> bit;
+            if (!rest) {
+                break;
+            }
+            bit += __builtin_ctzl(rest);
+            if (first < 0) {
+                first = base + bit;
+            } else {
+                apply(first, base + bit - 1, pbm);
+                first = -1;
+            }
+        }
+    }
+
+    if (first >= 0) {
+        apply(first, VLAN_BITMAP_SIZE - 1, pbm);
+    }
+}
+
+/* Sets 'a_only' to the VLANs set in 'a' but not in 'b', either of which
+ * may be NULL for no VLAN.  Returns true if there is any. */
+static bool
+vlan_bitmap_andnot(const unsigned long *a, const unsigned long *b,
+                   unsigned long *a_only)
 {
-    int vid;
+    unsigned long any = 0;
+    size_t i;
+
+    if (!a) {
+        return false;
+    }
+    for (i = 0; i < VLAN_BITMAP_LONGS; i++) {
+        a_only[i] = b ? (a[i] & ~b[i]) : a[i];
+        any |= a_only[i];
+    }
+    return any != 0;
+}
 
+static void
+add_trunked_vlans(unsigned long *vlan_list, opennsl_pbmp_t *pbm)
+{
     if (vlan_list) {
-        BITMAP_FOR_EACH_1(vid, VLAN_BITMAP_SIZE, vlan_list) {
-            bcmsdk_add_trunk_ports(vid, pbm);
-        }
+        vlan_bitmap_for_each_range(vlan_list, pbm,
+                                   bcmsdk_add_trunk_ports_range);
     }
 }
 
 static void
 del_trunked_vlans(unsigned long *vlan_list, opennsl_pbmp_t *pbm)
 {
-    int vid;
-
     if (vlan_list) {
-        BITMAP_FOR_EACH_1(vid, VLAN_BITMAP_SIZE, vlan_list) {
-            bcmsdk_del_trunk_ports(vid, pbm);
-        }
+        vlan_bitmap_for_each_range(vlan_list, pbm,
+                                   bcmsdk_del_trunk_ports_range);
     }
 }
 
@@ -456,43 +521,21 @@ handle_trunk_vlan_changes(unsigned long *old_trunks, unsigned long *new_trunks,
                           opennsl_pbmp_t *pbm, enum port_vlan_mode old_mode,
                           enum port_vlan_mode new_mode)
 {
-    int vid;
-    bool removed_vlans_found = false;
-    bool added_vlans_found = false;
-    unsigned long *removed_vlans = bitmap_allocate(VLAN_BITMAP_SIZE);
-    unsigned long *added_vlans = bitmap_allocate(VLAN_BITMAP_SIZE);
-
-    if (old_trunks) {
-        BITMAP_FOR_EACH_1(vid, VLAN_BITMAP_SIZE, old_trunks) {
-            if (!new_trunks || !bitmap_is_set(new_trunks, vid)) {
-                VLOG_DBG("Found a deleted VLAN %d", vid);
-                bitmap_set1(removed_vlans, vid);
-                removed_vlans_found = true;
-            }
-        }
-        /* Remove VLANs based on old mode. */
-        if (removed_vlans_found) {
-            unconfig_all_vlans(old_mode, -1, removed_vlans, pbm);
-        }
+    unsigned long delta[VLAN_BITMAP_LONGS];
+
+    if (old_trunks == new_trunks) {
+        return;
     }
 
-    if (new_trunks) {
-        BITMAP_FOR_EACH_1(vid, VLAN_BITMAP_SIZE, new_trunks) {
-            if (!old_trunks || !bitmap_is_set(old_trunks, vid)) {
-                VLOG_DBG("Found an added VLAN %d", vid);
-                bitmap_set1(added_vlans, vid);
-                added_vlans_found = true;
-            }
-        }
-        /* Configure new VLANs based on new mode. */
-        if (added_vlans_found) {
-            config_all_vlans(new_mode, -1, added_vlans, pbm);
-        }
+    /* Remove VLANs based on old mode. */
+    if (vlan_bitmap_andnot(old_trunks, new_trunks, delta)) {
+        unconfig_all_vlans(old_mode, -1, delta, pbm);
     }
 
-    /* Done with these bitmaps. */
-    bitmap_free(removed_vlans);
-    bitmap_free(added_vlans);
+    /* Configure new VLANs based on new mode. */
+    if (vlan_bitmap_andnot(new_trunks, old_trunks, delta)) {
+        config_all_vlans(new_mode, -1, delta, pbm);
+    }
 }
 
 static struct ofbundle *
@@ -509,6 +552,25 @@ bundle_lookup(const struct bcmsdk_provider_node *ofproto, void *aux)
     return NULL;
 }
 
+/* Updates the ports of the ofproto that trunk every VLAN of the VLAN
+ * table, so that set_vlan() programs them all in a single call, before
+ * 'bundle' takes 'new_pbm' and 'trunk_all_vlans'.  'new_pbm' is NULL if
+ * the bundle goes away.  A port is in a single bundle, so only the bits
+ * of 'bundle' change. */
+static void
+bundle_update_trunk_all(struct ofbundle *bundle, const opennsl_pbmp_t *new_pbm,
+                        bool trunk_all_vlans)
+{
+    opennsl_pbmp_t *trunk_all_pbm = bundle->ofproto->trunk_all_pbm.units;
+
+    if (bundle->trunk_all_vlans) {
+        bcmsdk_pbmp_remove(trunk_all_pbm, trunk_all_pbm, bundle->pbm.units);
+    }
+    if (new_pbm && trunk_all_vlans) {
+        bcmsdk_pbmp_or(trunk_all_pbm, new_pbm);
+    }
+}
+
 static void
 bundle_del_port(struct bcmsdk_provider_ofport_node *port)
 {
@@ -568,7 +630,7 @@ bundle_destroy(struct ofbundle *bundle)
 
             /* Unconfigure any existing VLAN in h/w. */
             unconfig_all_vlans(bundle->vlan_mode, bundle->vlan,
-                    bundle->trunks, bundle->pbm);
+                    bundle->trunks, bundle->pbm.units);
         } else if (strcmp(type, OVSREC_INTERFACE_TYPE_VLANSUBINT) == 0) {
             VLOG_DBG("destroy the subinterface\n");
             if (bundle->l3_intf) {
@@ -582,7 +644,11 @@ bundle_destroy(struct ofbundle *bundle)
         } else if (strcmp(type, OVSREC_INTERFACE_TYPE_INTERNAL) == 0) {
             VLOG_DBG("destroy the internal interface\n");
             if (bundle->l3_intf) {
-                opennsl_l3_intf_delete(bundle->hw_unit, bundle->l3_intf);
+                if (OPENNSL_SUCCESS(opennsl_l3_intf_delete(bundle->hw_unit,
+                                                           bundle->l3_intf))) {
+                    ops_hw_table_update(bundle->hw_unit,
+                                        OPS_HW_TABLE_L3_INTF, -1);
+                }
                 bundle->l3_intf = NULL;
             }
         }
@@ -602,7 +668,9 @@ bundle_destroy(struct ofbundle *bundle)
     }
 
     hmap_remove(&ofproto->bundles, &bundle->hmap_node);
+    bundle_update_trunk_all(bundle, NULL, false);
     bitmap_free(bundle->trunks);
+    ds_destroy(&bundle->settings);
     free(bundle->name);
     free(bundle);
 }
@@ -949,6 +1017,109 @@ port_ip_reconfigure(struct ofproto *ofproto, struct ofbundle *bundle,
     return 0;
 }
 
+/* Scratch buffer for the settings key of bundle_set(). */
+static struct ds bundle_settings_scratch = DS_EMPTY_INITIALIZER;
+
+static void
+bundle_key_put(struct ds *key, const void *data, size_t n)
+{
+    ds_put_buffer(key, data, n);
+}
+
+static void
+bundle_key_put_int(struct ds *key, int value)
+{
+    bundle_key_put(key, &value, sizeof value);
+}
+
+static void
+bundle_key_put_string(struct ds *key, const char *string)
+{
+    /* NULL and "" differ. */
+    if (string) {
+        ds_put_char(key, 's');
+        ds_put_buffer(key, string, strlen(string) + 1);
+    } else {
+        ds_put_char(key, '-');
+    }
+}
+
+static void
+bundle_key_put_strings(struct ds *key, char **strings, size_t n)
+{
+    size_t i;
+
+    bundle_key_put_int(key, n);
+    for (i = 0; i < n; i++) {
+        bundle_key_put_string(key, strings[i]);
+    }
+}
+
+static void
+bundle_key_put_smap(struct ds *key, const struct smap *smap)
+{
+    const struct smap_node *node;
+
+    /* Two equal smaps built in another order may walk differently, which
+     * only costs applying the same settings again. */
+    bundle_key_put_int(key, smap ? smap_count(smap) : -1);
+    if (smap) {
+        SMAP_FOR_EACH (node, smap) {
+            bundle_key_put_string(key, node->key);
+            bundle_key_put_string(key, node->value);
+        }
+    }
+}
+
+/* Builds in 'key' everything bundle_set() acts upon: the settings in 's'
+ * and the state of the slave netdevs it reads, like their hardware port
+ * and MAC.  A bundle pushed again with the same key can be skipped. */
+static void
+bundle_settings_key(struct bcmsdk_provider_node *ofproto,
+                    const struct ofproto_bundle_settings *s, struct ds *key)
+{
+    struct bcmsdk_provider_ofport_node *port;
+    struct netdev *netdev;
+    uint64_t change_seq;
+    size_t i;
+
+    ds_clear(key);
+    bundle_key_put_string(key, s->name);
+    bundle_key_put_int(key, s->n_slaves);
+    bundle_key_put(key, s->slaves, s->n_slaves * sizeof *s->slaves);
+    for (i = 0; i < s->n_slaves; i++) {
+        /* the netdev pointer and its change count cover its hardware
+         * info, its MAC and, for a subinterface, its parent and VLAN */
+        port = get_ofp_port(ofproto, s->slaves[i]);
+        netdev = port ? port->up.netdev : NULL;
+        change_seq = netdev ? netdev_get_change_seq(netdev) : 0;
+        bundle_key_put(key, &netdev, sizeof netdev);
+        bundle_key_put(key, &change_seq, sizeof change_seq);
+    }
+    bundle_key_put_int(key, s->n_slaves_tx_enable);
+    bundle_key_put(key, s->slaves_tx_enable,
+                   s->n_slaves_tx_enable * sizeof *s->slaves_tx_enable);
+    bundle_key_put_int(key, s->vlan_mode);
+    bundle_key_put_int(key, s->vlan);
+    bundle_key_put_int(key, s->trunks != NULL);
+    if (s->trunks) {
+        bundle_key_put(key, s->trunks, bitmap_n_bytes(VLAN_BITMAP_SIZE));
+    }
+    bundle_key_put_int(key, s->bond ? s->bond->balance : -1);
+    bundle_key_put_int(key, s->hw_bond_should_exist);
+    bundle_key_put_int(key, s->bond_handle_alloc_only);
+    bundle_key_put_int(key, s->enable);
+    for (i = 0; i < PORT_OPT_MAX; i++) {
+        bundle_key_put_smap(key, s->port_options[i]);
+    }
+    bundle_key_put_string(key, s->ip4_address);
+    bundle_key_put_string(key, s->ip6_address);
+    bundle_key_put_strings(key, s->ip4_address_secondary,
+                           s->n_ip4_address_secondary);
+    bundle_key_put_strings(key, s->ip6_address_secondary,
+                           s->n_ip6_address_secondary);
+}
+
 static int
 bundle_set(struct ofproto *ofproto_, void *aux,
            const struct ofproto_bundle_settings *s)
@@ -956,6 +1127,7 @@ bundle_set(struct ofproto *ofproto_, void *aux,
     struct bcmsdk_provider_node *ofproto = bcmsdk_provider_node_cast(ofproto_);
     int i;
     const char *opt_arg;
+    struct ops_pbmp_arena arena;
     opennsl_pbmp_t *all_pbm;
     opennsl_pbmp_t *temp_pbm;
     unsigned long *new_trunks = NULL;
@@ -963,6 +1135,8 @@ bundle_set(struct ofproto *ofproto_, void *aux,
     struct bcmsdk_provider_ofport_node *port;
     struct ofbundle *bundle;
     const char *type = NULL;
+    struct ds *key = &bundle_settings_scratch;
+    bool applied = true;    /* every hardware step succeeded */
     bool ok;
 
     VLOG_DBG("%s: entry, ofproto_=%p, aux=%p, s=%p",
@@ -998,7 +1172,7 @@ bundle_set(struct ofproto *ofproto_, void *aux,
         bundle->vlan = -1;
         bundle->trunks = NULL;
         bundle->trunk_all_vlans = false;
-        bundle->pbm = NULL;
+        bcmsdk_clear_pbmp(bundle->pbm.units);
         bundle->bond_hw_handle = -1;
         bundle->lacp = NULL;
         bundle->bond = NULL;
@@ -1007,7 +1181,18 @@ bundle_set(struct ofproto *ofproto_, void *aux,
         bundle->ip6_address = NULL;
         hmap_init(&bundle->secondary_ip4addr);
         hmap_init(&bundle->secondary_ip6addr);
+        ds_init(&bundle->settings);
+    }
+
+    /* Nothing to do if the settings are the ones last applied and none
+     * of the ports went away since. */
+    bundle_settings_key(ofproto, s, key);
+    if (!s->ip_change && list_size(&bundle->ports) == s->n_slaves
+        && bundle->settings.length == key->length
+        && !memcmp(bundle->settings.string, key->string, key->length)) {
+        return 0;
     }
+    ds_clear(&bundle->settings);
 
     if (!bundle->name || strcmp(s->name, bundle->name)) {
         free(bundle->name);
@@ -1023,11 +1208,10 @@ bundle_set(struct ofproto *ofproto_, void *aux,
              s->hw_bond_should_exist,
              s->bond_handle_alloc_only);
 
-    /* Allocate Broadcom hw port bitmap. */
-    all_pbm = bcmsdk_alloc_pbmp();
-    if (all_pbm == NULL) {
-        return ENOMEM;
-    }
+    /* Broadcom hw port bitmap, from the stack like the other scratch
+     * bitmaps of this call. */
+    ops_pbmp_arena_init(&arena);
+    all_pbm = ops_pbmp_arena_get(&arena);
 
     if ((-1 == bundle->bond_hw_handle) &&
         (s->hw_bond_should_exist || (s->bond_handle_alloc_only))) {
@@ -1036,6 +1220,9 @@ bundle_set(struct ofproto *ofproto_, void *aux,
         bcmsdk_create_lag(&bundle->bond_hw_handle);
         VLOG_DBG("%s: Allocated bond_hw_handle# %d for port %s",
                  __FUNCTION__, bundle->bond_hw_handle, s->name);
+        if (-1 == bundle->bond_hw_handle) {
+            applied = false;
+        }
         if (s->bond_handle_alloc_only) {
             return 0;
         }
@@ -1056,6 +1243,8 @@ bundle_set(struct ofproto *ofproto_, void *aux,
     if (!ok || list_size(&bundle->ports) != s->n_slaves) {
         struct bcmsdk_provider_ofport_node *next_port;
 
+        applied = false;
+
         LIST_FOR_EACH_SAFE (port, next_port, bundle_node, &bundle->ports) {
             for (i = 0; i < s->n_slaves; i++) {
                 if (s->slaves[i] == port->up.ofp_port) {
@@ -1134,7 +1323,10 @@ bundle_set(struct ofproto *ofproto_, void *aux,
                                                      bundle->l3_intf,
                                                      port->up.netdev);
                 } else if (strcmp(type, OVSREC_INTERFACE_TYPE_INTERNAL) == 0) {
-                    opennsl_l3_intf_delete(hw_unit, bundle->l3_intf);
+                    if (OPENNSL_SUCCESS(opennsl_l3_intf_delete(hw_unit,
+                                                        bundle->l3_intf))) {
+                        ops_hw_table_update(hw_unit, OPS_HW_TABLE_L3_INTF, -1);
+                    }
                 }
                 bundle->l3_intf = NULL;
                 bundle->hw_unit = 0;
@@ -1173,6 +1365,9 @@ bundle_set(struct ofproto *ofproto_, void *aux,
                             mac);
                 }
             }
+            if (!bundle->l3_intf) {
+                applied = false;
+            }
         }
     }
 
@@ -1223,19 +1418,14 @@ bundle_set(struct ofproto *ofproto_, void *aux,
         /* Attach ports to the LAG. */
         bcmsdk_attach_ports_to_lag(bundle->bond_hw_handle, all_pbm);
 
-        /* Allocate another port bitmap for LAG's tx_enabled members. */
-        tx_en_pbm = bcmsdk_alloc_pbmp();
-        if (NULL == tx_en_pbm) {
-            bcmsdk_destroy_pbmp(all_pbm);
-            return ENOMEM;
-        }
+        /* Another port bitmap for LAG's tx_enabled members. */
+        tx_en_pbm = ops_pbmp_arena_get(&arena);
 
         port_list_to_hw_pbm(ofproto_, tx_en_pbm, s->slaves_tx_enable,
                             s->n_slaves_tx_enable);
 
         bcmsdk_egress_enable_lag_ports(bundle->bond_hw_handle,
                                        tx_en_pbm);
-        bcmsdk_destroy_pbmp(tx_en_pbm);
     }
 
     /* NOTE: "bundle" holds previous VLAN configuration (if any).
@@ -1258,21 +1448,18 @@ bundle_set(struct ofproto *ofproto_, void *aux,
 
     /* If no interface was configured before, just
      * configure everything on the new ports. */
-    if (bundle->pbm == NULL || bcmsdk_pbmp_is_empty(bundle->pbm)) {
+    if (bcmsdk_pbmp_is_empty(bundle->pbm.units)) {
         config_all_vlans(s->vlan_mode, s->vlan, new_trunks, all_pbm);
         goto done;
     }
 
-    /* Allocate temporary port bitmap to figure out
+    /* Temporary port bitmap to figure out
      * what interfaces have been added/deleted from port. */
-    temp_pbm = bcmsdk_alloc_pbmp();
-    if (temp_pbm == NULL) {
-        return ENOMEM;
-    }
+    temp_pbm = ops_pbmp_arena_get(&arena);
 
     /* First, unconfigure any physical interface that has
      * been removed from this logical port. */
-    bcmsdk_pbmp_remove(temp_pbm, bundle->pbm, all_pbm);
+    bcmsdk_pbmp_remove(temp_pbm, bundle->pbm.units, all_pbm);
     if (!bcmsdk_pbmp_is_empty(temp_pbm)) {
         unconfig_all_vlans(bundle->vlan_mode, bundle->vlan,
                            bundle->trunks, temp_pbm);
@@ -1280,14 +1467,14 @@ bundle_set(struct ofproto *ofproto_, void *aux,
     }
 
     /* Next, configure all VLANs on any new interface. */
-    bcmsdk_pbmp_remove(temp_pbm, all_pbm, bundle->pbm);
+    bcmsdk_pbmp_remove(temp_pbm, all_pbm, bundle->pbm.units);
     if (!bcmsdk_pbmp_is_empty(temp_pbm)) {
         config_all_vlans(s->vlan_mode, s->vlan, new_trunks, temp_pbm);
         bcmsdk_clear_pbmp(temp_pbm);
     }
 
     /* For existing interfaces, configure only changed VLANs. */
-    bcmsdk_pbmp_and(temp_pbm, all_pbm, bundle->pbm);
+    bcmsdk_pbmp_and(temp_pbm, all_pbm, bundle->pbm.units);
     if (!bcmsdk_pbmp_is_empty(temp_pbm)) {
         int mode_changed = (bundle->vlan_mode != s->vlan_mode);
         int tag_changed = (bundle->vlan != s->vlan);
@@ -1427,24 +1614,27 @@ bundle_set(struct ofproto *ofproto_, void *aux,
         }
     }
 
-    /* Done with temp_pbm. */
-    bcmsdk_destroy_pbmp(temp_pbm);
-
 done:
     /* Save enable/dsiable on bundle */
     bundle->enable = s->enable;
     /* Done with VLAN configuration.  Save the new information. */
     bundle->vlan_mode = s->vlan_mode;
     bundle->vlan = s->vlan;
-    if (bundle->pbm != NULL) {
-        bcmsdk_destroy_pbmp(bundle->pbm);
-    }
-    bundle->pbm = all_pbm;
-    if (bundle->trunks != NULL) {
+    bundle_update_trunk_all(bundle, all_pbm, trunk_all_vlans);
+    bcmsdk_pbmp_assign(bundle->pbm.units, all_pbm);
+    if (bundle->trunks != NULL && new_trunks != NULL) {
+        /* Reuse the bitmap we already have. */
+        memcpy(bundle->trunks, new_trunks, bitmap_n_bytes(VLAN_BITMAP_SIZE));
+    } else {
         bitmap_free(bundle->trunks);
+        bundle->trunks = vlan_bitmap_clone(new_trunks);
     }
-    bundle->trunks = vlan_bitmap_clone(new_trunks);
     bundle->trunk_all_vlans = trunk_all_vlans;
+    /* Remember the settings only once they are all in the hardware, so
+     * that the next push of the same settings retries a failed step. */
+    if (applied) {
+        ds_put_buffer(&bundle->settings, key->string, key->length);
+    }
 
     return 0;
 }
@@ -1495,22 +1685,27 @@ set_vlan(struct ofproto *ofproto, int vid, bool add)
         bcmsdk_create_vlan(vid, false);
         set_created_by_user(vid, 1);
 
-        /* Add this VLAN to any port that's implicitly trunking all VLANs. */
+        /* Add this VLAN to any port that's implicitly trunking all VLANs,
+         * all of them at once. */
         HMAP_FOR_EACH (bundle, hmap_node, &bcm_ofproto->bundles) {
             if (bundle->trunk_all_vlans) {
-                bcmsdk_add_trunk_ports(vid, bundle->pbm);
                 bitmap_set1(bundle->trunks, vid);
             }
         }
+        if (!bcmsdk_pbmp_is_empty(bcm_ofproto->trunk_all_pbm.units)) {
+            bcmsdk_add_trunk_ports(vid, bcm_ofproto->trunk_all_pbm.units);
+        }
 
     } else {
         /* Delete this VLAN from any port that's implicitly trunking all VLANs. */
         HMAP_FOR_EACH (bundle, hmap_node, &bcm_ofproto->bundles) {
             if (bundle->trunk_all_vlans) {
                 bitmap_set0(bundle->trunks, vid);
-                bcmsdk_del_trunk_ports(vid, bundle->pbm);
             }
         }
+        if (!bcmsdk_pbmp_is_empty(bcm_ofproto->trunk_all_pbm.units)) {
+            bcmsdk_del_trunk_ports(vid, bcm_ofproto->trunk_all_pbm.units);
+        }
         set_created_by_user(vid, 0);
 
         /* Delete VLAN. */
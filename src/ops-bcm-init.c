@@ -33,6 +33,8 @@
 #include "ops-routing.h"
 #include "ops-vlan.h"
 #include "ops-debug.h"
+#include "ops-switch-control.h"
+#include "ops-hw-queue.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_bcm_init);
 
@@ -77,6 +79,12 @@ ops_bcm_appl_init(void)
 
     for (unit = 0; unit <= MAX_SWITCH_UNIT_ID; unit++) {
 
+        rc = ops_switch_control_init(unit);
+        if (rc) {
+            VLOG_ERR("Switch control init failed");
+            return 1;
+        }
+
         rc = ops_port_init(unit);
         if (rc) {
             VLOG_ERR("Port subsystem init failed");
@@ -108,6 +116,10 @@ ops_bcm_appl_init(void)
         }
     }
 
+    // The init above programmed the units directly, later writes can
+    // be queued to the programming thread.
+    ops_hw_queue_init();
+
     return 0;
 
 } // ops_bcm_appl_init
@@ -33,6 +33,7 @@
 #include "bufmon-bcm-provider.h"
 #include "platform-defines.h"
 #include "ops-debug.h"
+#include "ops-switch-control.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_bufmon);
 
@@ -72,10 +73,10 @@ static int trigger_user_data[MAX_SWITCH_UNITS];
 
 /* Opennsl Mapping functions */
 #define BCM_API_SWITCH_CONTROL_GET(_unit, _control_type, _arg_ptr)      \
-        opennsl_switch_control_get((_unit), (_control_type), (_arg_ptr))
+        ops_switch_control_get((_unit), (_control_type), (_arg_ptr))
 
 #define BCM_API_SWITCH_CONTROL_SET(_unit, _control_type, _arg)      \
-        opennsl_switch_control_set((_unit), (_control_type), (_arg))
+        ops_switch_control_set((_unit), (_control_type), (_arg))
 
 #define BCM_API_BST_STAT_GET(_unit, _gport, _cosq, _bid,    \
                              _options, _data_ptr)     \
@@ -520,18 +521,13 @@ bst_switch_control_get(int unit, opennsl_switch_control_t type, int *value)
 void
 bst_switch_control_set(opennsl_switch_control_t  type, int arg)
 {
-    int old_value = 0;
     opennsl_error_t rv = OPENNSL_E_NONE;
     int hw_unit = 0;
 
+    /* Unchanged values are filtered by the switch control cache */
     for (hw_unit = 0; hw_unit <= MAX_SWITCH_UNIT_ID; hw_unit++) {
-
-        bst_switch_control_get(hw_unit, type, &old_value);
-
-        if (old_value != arg) {
-            rv = BCM_API_SWITCH_CONTROL_SET(hw_unit, type, arg);
-            OPENNSL_RV_ERROR_CHECK(rv, " %d %d %d", hw_unit, type, arg);
-        }
+        rv = BCM_API_SWITCH_CONTROL_SET(hw_unit, type, arg);
+        OPENNSL_RV_ERROR_CHECK(rv, " %d %d %d", hw_unit, type, arg);
     }
 }/* bst_switch_control_set */
 
@@ -43,6 +43,9 @@
 #include "ops-knet.h"
 #include "ofproto-bcm-provider.h"
 #include "ops-port.h"
+#include "ops-stats.h"
+#include "ops-switch-control.h"
+#include "ops-hw-queue.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_debug);
 
@@ -77,7 +80,16 @@ char cmd_hp_usage[] =
 "   l3v6route - display OpenSwitch l3 IPv6 Routes.\n"
 "   l3egress [<entry>] - display an egress object info.\n"
 "   l3ecmp [<entry>] - display an ecmp egress object info.\n"
+"   l3audit [repair | interval <seconds>] - compare OpenSwitch l3 routes with the ASIC.\n"
+"   l3wcmp [weight <vrf> <nexthop> <weight> | max-size <members>] - displays or sets weighted ECMP nexthops.\n"
+"   l3warm [done] - displays or ends the warm restart reconciliation of the l3 tables.\n"
+"   l3perf [reset] - displays or clears the l3 programming latency histograms.\n"
+"   l3hostroute [on | off] - displays or sets the placement of /32 and /128 routes in the host table.\n"
+"   l3compress [<vrf> [on | off]] - displays or sets the fib compression of a vrf.\n"
 "   lag [<lagid>] - displays OpenSwitch LAG info.\n"
+"   hwtables - displays hardware table occupancy and high-water marks.\n"
+"   switchctl - displays the cached switch control values.\n"
+"   hwqueue [on | off] - displays or sets the hardware programming thread.\n"
 "   help - displays this help text.\n"
 ;
 
@@ -288,6 +300,118 @@ bcm_plugin_debug(struct unixctl_conn *conn, int argc,
             ops_l3ecmp_egress_dump(&ds, ecmpid);
             goto done;
 
+        } else if (!strcmp(ch, "l3audit")) {
+            if (NULL != (ch = NEXT_ARG())) {
+                if (!strcmp(ch, "repair")) {
+                    ops_routing_route_audit(0, &ds, true);
+                } else if (!strcmp(ch, "interval")) {
+                    if (NULL != (ch = NEXT_ARG())) {
+                        ops_routing_route_audit_set_interval(atoi(ch));
+                    }
+                    ds_put_format(&ds, "Route audit interval: %d seconds\n",
+                                  ops_routing_route_audit_get_interval());
+                } else {
+                    ds_put_format(&ds, "Unsupported l3audit command - %s.\n", ch);
+                }
+            } else {
+                ops_routing_route_audit(0, &ds, false);
+            }
+            goto done;
+
+        } else if (!strcmp(ch, "l3wcmp")) {
+            if (NULL != (ch = NEXT_ARG())) {
+                if (!strcmp(ch, "weight")) {
+                    const char *vrf = NEXT_ARG();
+                    const char *nexthop = NEXT_ARG();
+                    const char *weight = NEXT_ARG();
+
+                    if (!vrf || !nexthop || !weight) {
+                        ds_put_format(&ds, "Missing l3wcmp weight parameters.\n");
+                        goto done;
+                    }
+                    if (ops_routing_nexthop_weight_set(0, atoi(vrf), nexthop,
+                                                       atoi(weight))) {
+                        ds_put_format(&ds, "Failed to set weight of %s.\n",
+                                      nexthop);
+                        goto done;
+                    }
+                } else if (!strcmp(ch, "max-size")) {
+                    if ((NULL == (ch = NEXT_ARG())) ||
+                        ops_routing_ecmp_max_members_set(0, atoi(ch))) {
+                        ds_put_format(&ds, "Invalid ECMP group size.\n");
+                        goto done;
+                    }
+                } else {
+                    ds_put_format(&ds, "Unsupported l3wcmp command - %s.\n", ch);
+                    goto done;
+                }
+            }
+            ops_routing_wcmp_dump(&ds);
+            goto done;
+
+        } else if (!strcmp(ch, "l3warm")) {
+            if (NULL != (ch = NEXT_ARG())) {
+                if (!strcmp(ch, "done")) {
+                    ops_routing_reconcile_done();
+                } else {
+                    ds_put_format(&ds, "Unsupported l3warm command - %s.\n", ch);
+                    goto done;
+                }
+            }
+            ops_routing_reconcile_dump(&ds);
+            goto done;
+
+        } else if (!strcmp(ch, "l3perf")) {
+            if (NULL != (ch = NEXT_ARG())) {
+                if (!strcmp(ch, "reset")) {
+                    ops_routing_perf_reset();
+                } else {
+                    ds_put_format(&ds, "Unsupported l3perf command - %s.\n", ch);
+                    goto done;
+                }
+            }
+            ops_routing_perf_dump(&ds);
+            goto done;
+
+        } else if (!strcmp(ch, "l3hostroute")) {
+            if (NULL != (ch = NEXT_ARG())) {
+                if (!strcmp(ch, "on")) {
+                    ops_routing_host_routes_set(true);
+                } else if (!strcmp(ch, "off")) {
+                    ops_routing_host_routes_set(false);
+                } else {
+                    ds_put_format(&ds, "Unsupported l3hostroute command - %s.\n", ch);
+                    goto done;
+                }
+            }
+            ds_put_format(&ds, "Host routes in host table : %s\n",
+                          ops_routing_host_routes_get() ? "on" : "off");
+            goto done;
+
+        } else if (!strcmp(ch, "l3compress")) {
+            int vrf = -1;
+            int rc;
+
+            if (NULL != (ch = NEXT_ARG())) {
+                vrf = atoi(ch);
+                if (NULL != (ch = NEXT_ARG())) {
+                    if (!strcmp(ch, "on") || !strcmp(ch, "off")) {
+                        rc = ops_routing_fib_compress_set(vrf,
+                                                          !strcmp(ch, "on"));
+                        if (OPENNSL_FAILURE(rc)) {
+                            ds_put_format(&ds, "Failed to set the fib compression of vrf %d - %s.\n",
+                                          vrf, opennsl_errmsg(rc));
+                            goto done;
+                        }
+                    } else {
+                        ds_put_format(&ds, "Unsupported l3compress command - %s.\n", ch);
+                        goto done;
+                    }
+                }
+            }
+            ops_routing_fib_dump(&ds, vrf);
+            goto done;
+
         } else if (!strcmp(ch, "lag")) {
             opennsl_trunk_t lagid = -1;
 
@@ -297,6 +421,28 @@ bcm_plugin_debug(struct unixctl_conn *conn, int argc,
             ops_lag_dump(&ds, lagid);
             goto done;
 
+        } else if (!strcmp(ch, "hwtables")) {
+            ops_hw_table_dump(&ds);
+            goto done;
+
+        } else if (!strcmp(ch, "hwqueue")) {
+            if (NULL != (ch = NEXT_ARG())) {
+                if (!strcmp(ch, "on")) {
+                    ops_hw_queue_async_set(true);
+                } else if (!strcmp(ch, "off")) {
+                    ops_hw_queue_async_set(false);
+                } else {
+                    ds_put_format(&ds, "Unsupported hwqueue command - %s.\n", ch);
+                    goto done;
+                }
+            }
+            ops_hw_queue_dump(&ds);
+            goto done;
+
+        } else if (!strcmp(ch, "switchctl")) {
+            ops_switch_control_dump(&ds);
+            goto done;
+
         } else if (!strcmp(ch, "help")) {
             ds_put_format(&ds, "%s", cmd_hp_usage);
             goto done;
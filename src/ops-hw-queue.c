@@ -0,0 +1,628 @@
+/*
+ * Copyright (C) 2015 Hewlett-Packard Development Company, L.P.
+ * All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ *
+ * File: ops-hw-queue.c
+ *
+ * Purpose: This file contains the hardware programming thread. The main
+ *          thread and the linkscan thread queue the asic writes whose
+ *          result they do not wait for in a multi producer single consumer
+ *          ring, and the main thread gets their results back from its run
+ *          loop.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <openvswitch/vlog.h>
+#include <ovs/hash.h>
+#include <ovs/list.h>
+#include <ovs/util.h>
+#include <latch.h>
+#include <ovs-atomic.h>
+#include <ovs-rcu.h>
+#include <ovs-thread.h>
+
+#include <opennsl/error.h>
+#include <opennsl/l3.h>
+#include <opennsl/vlan.h>
+#include <opennsl/trunk.h>
+
+#include "ops-hw-queue.h"
+
+VLOG_DEFINE_THIS_MODULE(ops_hw_queue);
+
+/* The submitters add commands at 'hwq_head', the programming thread
+ * runs them up to 'hwq_exec', and the main thread calls their completion
+ * and frees their slot up to 'hwq_tail'. The commands run in the order
+ * they were submitted, so two commands on the same object never swap.
+ * 'hwq_exec_seq' and 'hwq_retired' count the commands run and retired,
+ * the ring and the overflow list together. */
+#define OPS_HW_QUEUE_SIZE       1024    /* power of 2 */
+
+enum ops_hw_obj_type {
+    OPS_HW_OBJ_ROUTE = 1,
+    OPS_HW_OBJ_VLAN,
+    OPS_HW_OBJ_TRUNK,
+    OPS_HW_OBJ_PORT,
+};
+
+/* Any thread may submit, 'hwq_submit_mutex' serializes the submitters
+ * with each other and with the main thread retiring. It is taken before
+ * 'hwq_mutex' when both are needed. */
+static struct ovs_mutex hwq_submit_mutex = OVS_MUTEX_INITIALIZER;
+
+static struct ops_hw_cmd hwq_ring[OPS_HW_QUEUE_SIZE];
+static atomic_uint hwq_head;        /* written under hwq_submit_mutex */
+static atomic_uint hwq_exec;        /* written by the programming thread */
+static unsigned int hwq_tail OVS_GUARDED_BY(hwq_submit_mutex);
+static uint32_t hwq_next_seq OVS_GUARDED_BY(hwq_submit_mutex);
+static atomic_uint hwq_exec_seq;    /* written by the programming thread */
+static uint32_t hwq_retired OVS_GUARDED_BY(hwq_submit_mutex);
+static pthread_t hwq_main_thread;   /* the only one calling completions */
+
+/* The programming thread sleeps on 'hwq_cond' when the ring is empty,
+ * a submitter waits on 'hwq_done_cond' to sync with an object. */
+static struct ovs_mutex hwq_mutex = OVS_MUTEX_INITIALIZER;
+static pthread_cond_t hwq_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t hwq_done_cond = PTHREAD_COND_INITIALIZER;
+static atomic_bool hwq_sleeping;
+static struct latch hwq_done_latch;
+static bool hwq_started;
+static bool hwq_async = true;
+
+/* Commands submitted while the ring is full, in order. When the ring is
+ * drained, the programming thread runs them from the list itself, so that
+ * a sync from another thread never waits for the main thread to make
+ * room in the ring. */
+struct ops_hw_cmd_entry {
+    struct ovs_list node;           /* hwq_overflow */
+    struct ops_hw_cmd cmd;
+    bool claimed;                   /* run by the programming thread */
+    bool ran;                       /* 'cmd.rc' is set */
+};
+
+static struct ovs_list hwq_overflow OVS_GUARDED_BY(hwq_submit_mutex)
+    = OVS_LIST_INITIALIZER(&hwq_overflow);
+static size_t hwq_n_overflow OVS_GUARDED_BY(hwq_submit_mutex);
+
+/* Last command queued on each object, indexed by the object hash. Two
+ * objects may share an entry, a sync then waits for the later of their
+ * commands, which is longer than needed but never too short. An entry
+ * is pending while its command is between 'hwq_tail' and the head. */
+#define OPS_HW_PENDING_SIZE     4096    /* power of 2 */
+
+static uint32_t hwq_pending[OPS_HW_PENDING_SIZE]
+    OVS_GUARDED_BY(hwq_submit_mutex);
+
+static struct {
+    unsigned long long submitted;
+    unsigned long long failed;
+    unsigned long long overflowed;
+    unsigned long long syncs;       /* a submitter waited on an object */
+    size_t max_depth;
+} hwq_stats OVS_GUARDED_BY(hwq_submit_mutex);
+
+uint32_t
+ops_hw_obj_route(const opennsl_l3_route_t *route)
+{
+    uint32_t hash;
+
+    hash = hash_2words(OPS_HW_OBJ_ROUTE, route->l3a_vrf);
+    if (route->l3a_flags & OPENNSL_L3_IP6) {
+        hash = hash_bytes(route->l3a_ip6_net, sizeof(route->l3a_ip6_net),
+                          hash);
+        return hash_bytes(route->l3a_ip6_mask, sizeof(route->l3a_ip6_mask),
+                          hash);
+    }
+    return hash_2words(hash_2words(route->l3a_subnet, route->l3a_ip_mask),
+                       hash);
+} /* ops_hw_obj_route */
+
+uint32_t
+ops_hw_obj_vlan(int hw_unit, opennsl_vlan_t vid)
+{
+    return hash_2words(OPS_HW_OBJ_VLAN, hash_2words(hw_unit, vid));
+} /* ops_hw_obj_vlan */
+
+uint32_t
+ops_hw_obj_trunk(int hw_unit, opennsl_trunk_t tid)
+{
+    return hash_2words(OPS_HW_OBJ_TRUNK, hash_2words(hw_unit, tid));
+} /* ops_hw_obj_trunk */
+
+uint32_t
+ops_hw_obj_port(int hw_unit, opennsl_port_t hw_port)
+{
+    return hash_2words(OPS_HW_OBJ_PORT, hash_2words(hw_unit, hw_port));
+} /* ops_hw_obj_port */
+
+static void
+ops_hw_pending_set(uint32_t obj, uint32_t seq)
+    OVS_REQUIRES(hwq_submit_mutex)
+{
+    hwq_pending[obj & (OPS_HW_PENDING_SIZE - 1)] = seq;
+} /* ops_hw_pending_set */
+
+/* Mark the objects a command writes as pending until 'seq' retires. A
+ * VLAN command also writes the membership of each of its ports. */
+static void
+ops_hw_cmd_pending_set(const struct ops_hw_cmd *cmd, uint32_t seq)
+    OVS_REQUIRES(hwq_submit_mutex)
+{
+    opennsl_port_t hw_port;
+
+    switch (cmd->type) {
+    case OPS_HW_CMD_ROUTE_DELETE:
+        ops_hw_pending_set(ops_hw_obj_route(&cmd->route), seq);
+        break;
+    case OPS_HW_CMD_VLAN_PORT_ADD:
+    case OPS_HW_CMD_VLAN_PORT_REMOVE:
+        ops_hw_pending_set(ops_hw_obj_vlan(cmd->hw_unit, cmd->vlan.vid), seq);
+        OPENNSL_PBMP_ITER(cmd->vlan.pbmp, hw_port) {
+            ops_hw_pending_set(ops_hw_obj_port(cmd->hw_unit, hw_port), seq);
+        }
+        break;
+    case OPS_HW_CMD_TRUNK_MEMBER_ADD:
+    case OPS_HW_CMD_TRUNK_MEMBER_DELETE:
+        ops_hw_pending_set(ops_hw_obj_trunk(cmd->hw_unit, cmd->trunk.tid),
+                           seq);
+        ops_hw_pending_set(ops_hw_obj_port(cmd->hw_unit,
+                        OPENNSL_GPORT_MODPORT_PORT_GET(cmd->trunk.member.gport)),
+                           seq);
+        break;
+    }
+} /* ops_hw_cmd_pending_set */
+
+static int
+ops_hw_cmd_execute(struct ops_hw_cmd *cmd)
+{
+    switch (cmd->type) {
+    case OPS_HW_CMD_ROUTE_DELETE:
+        return opennsl_l3_route_delete(cmd->hw_unit, &cmd->route);
+    case OPS_HW_CMD_VLAN_PORT_ADD:
+        return opennsl_vlan_port_add(cmd->hw_unit, cmd->vlan.vid,
+                                     cmd->vlan.pbmp, cmd->vlan.ubmp);
+    case OPS_HW_CMD_VLAN_PORT_REMOVE:
+        return opennsl_vlan_port_remove(cmd->hw_unit, cmd->vlan.vid,
+                                        cmd->vlan.pbmp);
+    case OPS_HW_CMD_TRUNK_MEMBER_ADD:
+        return opennsl_trunk_member_add(cmd->hw_unit, cmd->trunk.tid,
+                                        &cmd->trunk.member);
+    case OPS_HW_CMD_TRUNK_MEMBER_DELETE:
+        return opennsl_trunk_member_delete(cmd->hw_unit, cmd->trunk.tid,
+                                           &cmd->trunk.member);
+    }
+    return OPENNSL_E_PARAM;
+} /* ops_hw_cmd_execute */
+
+/* Take the first command of the overflow list not run yet, once every
+ * command of the ring ran */
+static struct ops_hw_cmd_entry *
+ops_hw_overflow_claim(void)
+    OVS_REQUIRES(hwq_submit_mutex)
+{
+    struct ops_hw_cmd_entry *entry;
+
+    LIST_FOR_EACH (entry, node, &hwq_overflow) {
+        if (!entry->claimed) {
+            entry->claimed = true;
+            return entry;
+        }
+    }
+    return NULL;
+} /* ops_hw_overflow_claim */
+
+static void *
+ops_hw_queue_main(void *args OVS_UNUSED)
+{
+    struct ops_hw_cmd_entry *entry;
+    struct ops_hw_cmd *cmd;
+    unsigned int head, exec;
+    bool empty;
+
+    /* never holds rcu protected pointers */
+    ovsrcu_quiesce_start();
+
+    atomic_read_explicit(&hwq_exec, &exec, memory_order_relaxed);
+    for (;;) {
+        atomic_read_explicit(&hwq_head, &head, memory_order_acquire);
+        if (exec == head) {
+            ovs_mutex_lock(&hwq_submit_mutex);
+            atomic_read(&hwq_head, &head);
+            entry = (exec == head) ? ops_hw_overflow_claim() : NULL;
+            if (entry) {
+                ovs_mutex_unlock(&hwq_submit_mutex);
+                entry->cmd.rc = ops_hw_cmd_execute(&entry->cmd);
+                ovs_mutex_lock(&hwq_submit_mutex);
+                entry->ran = true;
+                atomic_store_explicit(&hwq_exec_seq, entry->cmd.seq + 1,
+                                      memory_order_release);
+                ovs_mutex_unlock(&hwq_submit_mutex);
+                goto done;
+            }
+
+            /* a submitter seeing 'hwq_sleeping' signals under 'hwq_mutex',
+             * which is taken before 'hwq_submit_mutex' is released */
+            ovs_mutex_lock(&hwq_mutex);
+            atomic_store(&hwq_sleeping, true);
+            ovs_mutex_unlock(&hwq_submit_mutex);
+            atomic_read(&hwq_head, &head);
+            empty = (exec == head);
+            if (empty) {
+                ovs_mutex_cond_wait(&hwq_cond, &hwq_mutex);
+            }
+            atomic_store(&hwq_sleeping, false);
+            ovs_mutex_unlock(&hwq_mutex);
+            continue;
+        }
+
+        while (exec != head) {
+            cmd = &hwq_ring[exec & (OPS_HW_QUEUE_SIZE - 1)];
+            cmd->rc = ops_hw_cmd_execute(cmd);
+            /* the slot may be reused once 'hwq_exec' moves past it */
+            atomic_store_explicit(&hwq_exec_seq, cmd->seq + 1,
+                                  memory_order_release);
+            exec++;
+            atomic_store_explicit(&hwq_exec, exec, memory_order_release);
+        }
+
+done:
+        latch_set(&hwq_done_latch);
+        ovs_mutex_lock(&hwq_mutex);
+        xpthread_cond_broadcast(&hwq_done_cond);
+        ovs_mutex_unlock(&hwq_mutex);
+    }
+
+    return NULL;
+} /* ops_hw_queue_main */
+
+void
+ops_hw_queue_init(void)
+{
+    if (hwq_started) {
+        return;
+    }
+    hwq_main_thread = pthread_self();
+    latch_init(&hwq_done_latch);
+    ovs_thread_create("ops-hw-program", ops_hw_queue_main, NULL);
+    hwq_started = true;
+} /* ops_hw_queue_init */
+
+void
+ops_hw_cmd_init(struct ops_hw_cmd *cmd, enum ops_hw_cmd_type type,
+                int hw_unit)
+{
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->type = type;
+    cmd->hw_unit = hw_unit;
+} /* ops_hw_cmd_init */
+
+static size_t
+ops_hw_queue_depth(void)
+    OVS_REQUIRES(hwq_submit_mutex)
+{
+    unsigned int head;
+
+    atomic_read_explicit(&hwq_head, &head, memory_order_relaxed);
+    return (head - hwq_tail) + hwq_n_overflow;
+} /* ops_hw_queue_depth */
+
+/* Wake up the programming thread if it sleeps */
+static void
+ops_hw_queue_kick(void)
+    OVS_REQUIRES(hwq_submit_mutex)
+{
+    bool sleeping;
+
+    atomic_read(&hwq_sleeping, &sleeping);
+    if (sleeping) {
+        ovs_mutex_lock(&hwq_mutex);
+        xpthread_cond_signal(&hwq_cond);
+        ovs_mutex_unlock(&hwq_mutex);
+    }
+} /* ops_hw_queue_kick */
+
+/* Hand the command written in the ring slot at 'head' to the
+ * programming thread */
+static void
+ops_hw_queue_push(unsigned int head)
+    OVS_REQUIRES(hwq_submit_mutex)
+{
+    atomic_store(&hwq_head, head + 1);
+    ops_hw_queue_kick();
+} /* ops_hw_queue_push */
+
+/* Move the commands submitted while the ring was full to the ring,
+ * except the ones the programming thread took from the list */
+static void
+ops_hw_queue_push_overflow(void)
+    OVS_REQUIRES(hwq_submit_mutex)
+{
+    struct ops_hw_cmd_entry *entry, *next;
+    unsigned int head;
+
+    LIST_FOR_EACH_SAFE (entry, next, node, &hwq_overflow) {
+        if (entry->claimed) {
+            continue;
+        }
+        atomic_read_explicit(&hwq_head, &head, memory_order_relaxed);
+        if ((head - hwq_tail) >= OPS_HW_QUEUE_SIZE) {
+            return;
+        }
+        list_remove(&entry->node);
+        hwq_n_overflow--;
+        hwq_ring[head & (OPS_HW_QUEUE_SIZE - 1)] = entry->cmd;
+        ops_hw_queue_push(head);
+        free(entry);
+    }
+} /* ops_hw_queue_push_overflow */
+
+/* Returns true and the sequence number of the last command queued on
+ * 'obj' in '*seq' if it is not retired yet */
+static bool
+ops_hw_pending_get(uint32_t obj, uint32_t *seq)
+    OVS_REQUIRES(hwq_submit_mutex)
+{
+    *seq = hwq_pending[obj & (OPS_HW_PENDING_SIZE - 1)];
+    return (uint32_t) (*seq - hwq_retired)
+           < (uint32_t) (hwq_next_seq - hwq_retired);
+} /* ops_hw_pending_get */
+
+static bool
+ops_hw_queue_is_main_thread(void)
+{
+    return pthread_equal(pthread_self(), hwq_main_thread);
+} /* ops_hw_queue_is_main_thread */
+
+/* Call the completion of the commands the programming thread ran, in the
+ * order they were submitted, whether they ran from the ring or from the
+ * overflow list. Main thread only, the completions are not thread safe. */
+static void
+ops_hw_queue_retire(void)
+{
+    struct ops_hw_cmd_entry *entry;
+    struct ops_hw_cmd cmd;
+    unsigned int exec;
+
+    for (;;) {
+        ovs_mutex_lock(&hwq_submit_mutex);
+        atomic_read_explicit(&hwq_exec, &exec, memory_order_acquire);
+        entry = list_is_empty(&hwq_overflow) ? NULL :
+                CONTAINER_OF(list_front(&hwq_overflow),
+                             struct ops_hw_cmd_entry, node);
+
+        /* the completion may submit, free the slot first */
+        if ((hwq_tail != exec) &&
+            (hwq_ring[hwq_tail & (OPS_HW_QUEUE_SIZE - 1)].seq
+             == hwq_retired)) {
+            cmd = hwq_ring[hwq_tail & (OPS_HW_QUEUE_SIZE - 1)];
+            hwq_tail++;
+        } else if (entry && entry->ran && (entry->cmd.seq == hwq_retired)) {
+            cmd = entry->cmd;
+            list_remove(&entry->node);
+            hwq_n_overflow--;
+            free(entry);
+        } else {
+            ops_hw_queue_push_overflow();
+            ovs_mutex_unlock(&hwq_submit_mutex);
+            return;
+        }
+        hwq_retired++;
+        if (OPENNSL_FAILURE(cmd.rc)) {
+            hwq_stats.failed++;
+        }
+        ovs_mutex_unlock(&hwq_submit_mutex);
+
+        if (cmd.done) {
+            cmd.done(&cmd);
+        }
+    }
+} /* ops_hw_queue_retire */
+
+/* Queue a command. It runs in the calling thread if the programming
+ * thread is not started or is turned off. Any thread may submit, a
+ * queued command's completion is called from the main thread. */
+void
+ops_hw_queue_submit(const struct ops_hw_cmd *cmd)
+{
+    struct ops_hw_cmd_entry *entry;
+    struct ops_hw_cmd inline_cmd;
+    unsigned int head;
+    uint32_t seq;
+
+    if (!hwq_started || !hwq_async) {
+        inline_cmd = *cmd;
+        inline_cmd.rc = ops_hw_cmd_execute(&inline_cmd);
+        ovs_mutex_lock(&hwq_submit_mutex);
+        hwq_stats.submitted++;
+        if (OPENNSL_FAILURE(inline_cmd.rc)) {
+            hwq_stats.failed++;
+        }
+        ovs_mutex_unlock(&hwq_submit_mutex);
+        if (inline_cmd.done) {
+            inline_cmd.done(&inline_cmd);
+        }
+        return;
+    }
+
+    ovs_mutex_lock(&hwq_submit_mutex);
+    hwq_stats.submitted++;
+    seq = hwq_next_seq++;
+    ops_hw_cmd_pending_set(cmd, seq);
+
+    /* only a full ring costs an allocation */
+    atomic_read_explicit(&hwq_head, &head, memory_order_relaxed);
+    if (list_is_empty(&hwq_overflow) &&
+        ((head - hwq_tail) < OPS_HW_QUEUE_SIZE)) {
+        hwq_ring[head & (OPS_HW_QUEUE_SIZE - 1)] = *cmd;
+        hwq_ring[head & (OPS_HW_QUEUE_SIZE - 1)].seq = seq;
+        ops_hw_queue_push(head);
+    } else {
+        entry = xzalloc(sizeof(*entry));
+        entry->cmd = *cmd;
+        entry->cmd.seq = seq;
+        list_push_back(&hwq_overflow, &entry->node);
+        hwq_n_overflow++;
+        hwq_stats.overflowed++;
+        ops_hw_queue_kick();
+    }
+
+    hwq_stats.max_depth = MAX(hwq_stats.max_depth, ops_hw_queue_depth());
+    ovs_mutex_unlock(&hwq_submit_mutex);
+} /* ops_hw_queue_submit */
+
+/* Block until the programming thread ran past 'seq', or until every
+ * queued command ran if 'all'. The main thread also calls the completions
+ * on the way. Other threads only wait for the programming thread, which
+ * runs the commands waiting for room in the ring itself. */
+static void
+ops_hw_queue_wait_for(uint32_t seq, bool all)
+{
+    unsigned int exec_seq;
+    uint32_t last;
+    bool done;
+
+    ovs_mutex_lock(&hwq_submit_mutex);
+    hwq_stats.syncs++;
+    if (all) {
+        seq = hwq_next_seq - 1;
+    }
+    ovs_mutex_unlock(&hwq_submit_mutex);
+
+    if (!ops_hw_queue_is_main_thread()) {
+        ovs_mutex_lock(&hwq_mutex);
+        for (;;) {
+            atomic_read_explicit(&hwq_exec_seq, &exec_seq,
+                                 memory_order_acquire);
+            if ((int32_t) (exec_seq - (seq + 1)) >= 0) {
+                break;
+            }
+            ovs_mutex_cond_wait(&hwq_done_cond, &hwq_mutex);
+        }
+        ovs_mutex_unlock(&hwq_mutex);
+        return;
+    }
+
+    for (;;) {
+        ops_hw_queue_retire();
+
+        ovs_mutex_lock(&hwq_submit_mutex);
+        done = (int32_t) (hwq_retired - (seq + 1)) >= 0;
+        last = hwq_retired;
+        ovs_mutex_unlock(&hwq_submit_mutex);
+        if (done) {
+            return;
+        }
+
+        ovs_mutex_lock(&hwq_mutex);
+        atomic_read_explicit(&hwq_exec_seq, &exec_seq, memory_order_acquire);
+        if (exec_seq == last) {
+            ovs_mutex_cond_wait(&hwq_done_cond, &hwq_mutex);
+        }
+        ovs_mutex_unlock(&hwq_mutex);
+    }
+} /* ops_hw_queue_wait_for */
+
+/* Wait for the queued commands on an object to run, before the caller
+ * reads or writes the object directly */
+void
+ops_hw_queue_sync(uint32_t obj)
+{
+    uint32_t seq;
+    bool pending;
+
+    ovs_mutex_lock(&hwq_submit_mutex);
+    pending = ops_hw_pending_get(obj, &seq);
+    ovs_mutex_unlock(&hwq_submit_mutex);
+
+    if (pending) {
+        ops_hw_queue_wait_for(seq, false);
+    }
+} /* ops_hw_queue_sync */
+
+/* Wait for every queued command to run */
+void
+ops_hw_queue_flush(void)
+{
+    size_t depth;
+
+    if (!hwq_started) {
+        return;
+    }
+
+    ovs_mutex_lock(&hwq_submit_mutex);
+    depth = ops_hw_queue_depth();
+    ovs_mutex_unlock(&hwq_submit_mutex);
+
+    if (depth) {
+        ops_hw_queue_wait_for(0, true);
+    }
+} /* ops_hw_queue_flush */
+
+void
+ops_hw_queue_async_set(bool enable)
+{
+    if (!enable) {
+        ops_hw_queue_flush();
+    }
+    hwq_async = enable;
+} /* ops_hw_queue_async_set */
+
+void
+ops_hw_queue_run(void)
+{
+    if (!hwq_started) {
+        return;
+    }
+    latch_poll(&hwq_done_latch);
+    ops_hw_queue_retire();
+} /* ops_hw_queue_run */
+
+void
+ops_hw_queue_wait(void)
+{
+    size_t depth;
+
+    if (!hwq_started) {
+        return;
+    }
+
+    ovs_mutex_lock(&hwq_submit_mutex);
+    depth = ops_hw_queue_depth();
+    ovs_mutex_unlock(&hwq_submit_mutex);
+
+    if (depth) {
+        latch_wait(&hwq_done_latch);
+    }
+} /* ops_hw_queue_wait */
+
+void
+ops_hw_queue_dump(struct ds *ds)
+{
+    ds_put_format(ds, "Hardware programming thread : %s\n",
+                  !hwq_started ? "not started" :
+                  hwq_async ? "on" : "off");
+
+    ovs_mutex_lock(&hwq_submit_mutex);
+    ds_put_format(ds, "  Queued commands  : %zu (%zu waiting for room)\n",
+                  ops_hw_queue_depth(), hwq_n_overflow);
+    ds_put_format(ds, "  Max queued       : %zu\n", hwq_stats.max_depth);
+    ds_put_format(ds, "  Submitted        : %llu\n", hwq_stats.submitted);
+    ds_put_format(ds, "  Failed           : %llu\n", hwq_stats.failed);
+    ds_put_format(ds, "  Ring full        : %llu\n", hwq_stats.overflowed);
+    ds_put_format(ds, "  Syncs            : %llu\n", hwq_stats.syncs);
+    ovs_mutex_unlock(&hwq_submit_mutex);
+} /* ops_hw_queue_dump */
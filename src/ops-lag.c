@@ -29,7 +29,9 @@
 
 #include "platform-defines.h"
 #include "ops-debug.h"
+#include "ops-hw-queue.h"
 #include "ops-lag.h"
+#include "ops-stats.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_lag);
 
@@ -131,6 +133,7 @@ hw_create_lag(int unit, opennsl_trunk_t *lag_id)
 
     if (OPENNSL_SUCCESS(rc)) {
 
+        ops_hw_table_update(unit, OPS_HW_TABLE_TRUNK, 1);
         opennsl_trunk_info_t_init(&group_info);
 
         // Configure the trunk group.
@@ -166,10 +169,14 @@ hw_destroy_lag(int unit, opennsl_trunk_t lag_id)
 
     SW_LAG_DBG("entry: unit=%d, lag_id=%d", unit, lag_id);
 
+    // Member changes still queued must not land on a later LAG.
+    ops_hw_queue_sync(ops_hw_obj_trunk(unit, lag_id));
     rc = opennsl_trunk_destroy(unit, lag_id);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Unit %d, LAGID %d destroy error, rc=%d (%s)",
                  unit, lag_id, rc, opennsl_errmsg(rc));
+    } else {
+        ops_hw_table_update(unit, OPS_HW_TABLE_TRUNK, -1);
     }
 
     SW_LAG_DBG("done: rc=%s", opennsl_errmsg(rc));
@@ -181,6 +188,7 @@ is_port_attached_to_lag(int unit, opennsl_port_t hw_port, opennsl_trunk_t *trunk
 {
     int rc = OPENNSL_E_NONE;
 
+    ops_hw_queue_sync(ops_hw_obj_port(unit, hw_port));
     rc = opennsl_trunk_find(unit, MODID_0, hw_port, trunk_id);
     if (OPENNSL_SUCCESS(rc)) {
         return 1;
@@ -190,11 +198,32 @@ is_port_attached_to_lag(int unit, opennsl_port_t hw_port, opennsl_trunk_t *trunk
 
 } // is_port_attached_to_lag
 
+static void
+hw_lag_member_done(struct ops_hw_cmd *cmd)
+{
+    opennsl_port_t hw_port;
+
+    hw_port = OPENNSL_GPORT_MODPORT_PORT_GET(cmd->trunk.member.gport);
+    if (OPENNSL_SUCCESS(cmd->rc)) {
+        SW_LAG_DBG("trunk member %s succeeds unit %d, hw_port=%d, tid %d",
+                   (cmd->type == OPS_HW_CMD_TRUNK_MEMBER_ADD) ?
+                   "add" : "delete", cmd->hw_unit, hw_port, cmd->trunk.tid);
+    } else if (cmd->type == OPS_HW_CMD_TRUNK_MEMBER_ADD) {
+        VLOG_ERR("Trunk port attach error, hw_port %d, tid %d, "
+                 "rc=%d (%s)", hw_port, cmd->trunk.tid, cmd->rc,
+                 opennsl_errmsg(cmd->rc));
+    } else {
+        VLOG_ERR("Failed to delete hw_port %d from tid %d, "
+                 "rc=%d (%s)", hw_port, cmd->trunk.tid, cmd->rc,
+                 opennsl_errmsg(cmd->rc));
+    }
+
+} // hw_lag_member_done
+
 static void
 hw_lag_attach_port(int unit, opennsl_trunk_t lag_id, opennsl_port_t hw_port)
 {
-    opennsl_trunk_member_t member_element;
-    opennsl_error_t rc = OPENNSL_E_NONE;
+    struct ops_hw_cmd cmd;
     opennsl_trunk_t exist_lag_id;
 
     SW_LAG_DBG("Trunk Attach: unit=%d, hw_port=%d, tid=%d",
@@ -227,22 +256,18 @@ hw_lag_attach_port(int unit, opennsl_trunk_t lag_id, opennsl_port_t hw_port)
         }
     }
 
-    opennsl_trunk_member_t_init(&member_element);
-    OPENNSL_GPORT_MODPORT_SET(member_element.gport, MODID_0, hw_port);
+    // The programming thread adds the member, after any queued detach.
+    ops_hw_cmd_init(&cmd, OPS_HW_CMD_TRUNK_MEMBER_ADD, unit);
+    cmd.trunk.tid = lag_id;
+    opennsl_trunk_member_t_init(&cmd.trunk.member);
+    OPENNSL_GPORT_MODPORT_SET(cmd.trunk.member.gport, MODID_0, hw_port);
 
     // Always disable egress while attaching the port to trunk.
     // Later LACPd will unset this flag, when port is ready to transmit.
-    member_element.flags = OPENNSL_TRUNK_MEMBER_EGRESS_DISABLE;
+    cmd.trunk.member.flags = OPENNSL_TRUNK_MEMBER_EGRESS_DISABLE;
 
-    rc = opennsl_trunk_member_add(unit, lag_id, &member_element);
-    if (OPENNSL_SUCCESS(rc)) {
-        SW_LAG_DBG("trunk member add succeeds unit %d, hw_port=%d, "
-                   "tid %d", unit, hw_port, lag_id);
-    } else {
-        VLOG_ERR("Trunk port attach error, hw_port %d, tid %d, "
-                 "rc=%d (%s)", hw_port, lag_id, rc, opennsl_errmsg(rc));
-        goto done;
-    }
+    cmd.done = hw_lag_member_done;
+    ops_hw_queue_submit(&cmd);
 
 done:
     SW_LAG_DBG("Done.");
@@ -262,6 +287,8 @@ hw_lag_egress_enable_port(int unit, opennsl_trunk_t trunk_id, opennsl_port_t hw_
     SW_LAG_DBG("Trunk port egress enable: unit=%d, hw_port=%d, "
                "tid=%d enable=%d", unit, hw_port, trunk_id, enable);
 
+    // The member must be in the trunk before it is enabled.
+    ops_hw_queue_sync(ops_hw_obj_trunk(unit, trunk_id));
     rc = opennsl_trunk_get(unit, trunk_id, &trunk_info,
                            OPENNSL_TRUNK_MAX_PORTCNT,
                            member_array, &member_count);
@@ -298,21 +325,17 @@ hw_lag_egress_enable_port(int unit, opennsl_trunk_t trunk_id, opennsl_port_t hw_
 static void
 hw_lag_detach_port(int unit, opennsl_trunk_t lag_id, opennsl_port_t hw_port)
 {
-    opennsl_trunk_member_t member_element;
-    opennsl_error_t rc = OPENNSL_E_NONE;
+    struct ops_hw_cmd cmd;
 
     SW_LAG_DBG("Trunk Detach: lagid=%d, unit=%d, hw_port=%d",
                lag_id, unit, hw_port);
 
-    opennsl_trunk_member_t_init(&member_element);
-    OPENNSL_GPORT_MODPORT_SET(member_element.gport, MODID_0, hw_port);
-
-    rc = opennsl_trunk_member_delete(unit, lag_id, &member_element);
-
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Failed to delete hw_port %d from tid %d, "
-                 "rc=%d (%s)", hw_port, lag_id, rc, opennsl_errmsg(rc));
-    }
+    ops_hw_cmd_init(&cmd, OPS_HW_CMD_TRUNK_MEMBER_DELETE, unit);
+    cmd.trunk.tid = lag_id;
+    opennsl_trunk_member_t_init(&cmd.trunk.member);
+    OPENNSL_GPORT_MODPORT_SET(cmd.trunk.member.gport, MODID_0, hw_port);
+    cmd.done = hw_lag_member_done;
+    ops_hw_queue_submit(&cmd);
 
     SW_LAG_DBG("Done.");
 
@@ -42,6 +42,28 @@ bcmsdk_alloc_pbmp(void)
 
 } // bcmsdk_alloc_pbmp
 
+void
+ops_pbmp_arena_init(struct ops_pbmp_arena *arena)
+{
+    arena->n_used = 0;
+
+} // ops_pbmp_arena_init
+
+opennsl_pbmp_t *
+ops_pbmp_arena_get(struct ops_pbmp_arena *arena)
+{
+    opennsl_pbmp_t *pbm;
+
+    // The arena is sized for the callers, running out is a bug.
+    ovs_assert(arena->n_used < OPS_PBMP_ARENA_SIZE);
+
+    pbm = arena->pbmps[arena->n_used++].units;
+    bcmsdk_clear_pbmp(pbm);
+
+    return pbm;
+
+} // ops_pbmp_arena_get
+
 void
 bcmsdk_clear_pbmp(opennsl_pbmp_t *pbm)
 {
@@ -123,3 +145,25 @@ bcmsdk_pbmp_and(opennsl_pbmp_t *dst_pbm, const opennsl_pbmp_t *src_pbm_1,
     }
 
 } // bcmsdk_pbmp_and
+
+void
+bcmsdk_pbmp_assign(opennsl_pbmp_t *dst_pbm, const opennsl_pbmp_t *src_pbm)
+{
+    int unit;
+
+    for (unit = 0; unit <= MAX_SWITCH_UNIT_ID; unit++) {
+        OPENNSL_PBMP_ASSIGN(dst_pbm[unit], src_pbm[unit]);
+    }
+
+} // bcmsdk_pbmp_assign
+
+void
+bcmsdk_pbmp_or(opennsl_pbmp_t *dst_pbm, const opennsl_pbmp_t *src_pbm)
+{
+    int unit;
+
+    for (unit = 0; unit <= MAX_SWITCH_UNIT_ID; unit++) {
+        OPENNSL_PBMP_OR(dst_pbm[unit], src_pbm[unit]);
+    }
+
+} // bcmsdk_pbmp_or
@@ -33,6 +33,7 @@
 #include "ops-knet.h"
 #include "ops-vlan.h"
 #include "ops-port.h"
+#include "ops-routing.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_port);
 
@@ -71,6 +72,9 @@ ops_link_state_callback(int unit, opennsl_port_t hw_port, opennsl_port_info_t *i
         // OPS_TODO: need MUTEX since this is a different thread?
         vlan_reconfig_on_link_change(unit, hw_port, 1);
 
+        // Put the port's nexthops back in their ECMP groups.
+        ops_routing_link_state_change(unit, hw_port, true);
+
     } else {
         // OPS_TODO: Flush MACs on link down.
         //flush_learned_macs(unit, hw_port);
@@ -79,6 +83,10 @@ ops_link_state_callback(int unit, opennsl_port_t hw_port, opennsl_port_info_t *i
 
         // OPS_TODO: need MUTEX since this is a different thread?
         vlan_reconfig_on_link_change(unit, hw_port, 0);
+
+        // Stop hashing ECMP traffic onto the dead link right away,
+        // without waiting for routing to withdraw the nexthops.
+        ops_routing_link_state_change(unit, hw_port, false);
     }
 
     netdev_bcmsdk_link_state_callback(unit, (int)hw_port, link_status);
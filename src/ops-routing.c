@@ -18,13 +18,23 @@
  * in the Broadcom ASIC.
  */
 
+#include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <limits.h>
 #include <errno.h>
 #include <assert.h>
 #include <util.h>
 #include <netinet/ether.h>
 #include <arpa/inet.h>
 #include <linux/if_ether.h>
+#include <timeval.h>
+#include <poll-loop.h>
+#include <ovs-thread.h>
+#include <bitmap.h>
+#include <latch.h>
+#include <ovs-atomic.h>
 #include <openvswitch/vlog.h>
 #include <opennsl/error.h>
 #include <opennsl/types.h>
@@ -40,6 +50,10 @@
 #include "platform-defines.h"
 #include "openswitch-dflt.h"
 #include "netdev-bcmsdk.h"
+#include "ops-port.h"
+#include "ops-stats.h"
+#include "ops-switch-control.h"
+#include "ops-hw-queue.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_routing);
 
@@ -47,16 +61,305 @@ opennsl_if_t local_nhid;
 /* fake MAC to create a local_nhid */
 opennsl_mac_t LOCAL_MAC =  {0x0,0x0,0x01,0x02,0x03,0x04};
 
-/* KEY in ops_mac_move_egress_id_map */
-char    egress_id_key[24];
-struct hmap ops_mac_move_egress_id_map;
+/* Routes of a vrf in asic. The tables of the vrfs in use are indexed by
+ * vrf id. A destroyed vrf is unlinked at once and its routes are deleted
+ * from the asic in batches from the main loop. */
+struct ops_route_table {
+    struct hmap_node node;          /* ops_route_tables */
+    struct ovs_list dying_node;     /* ops_dying_route_tables */
+    opennsl_vrf_t vrf;
+    int hw_unit;
+    struct hmap routes;
+    bool compress;                  /* fib compression enabled */
+    struct ops_fib_node *fib[2];    /* compression tries, ipv4 and ipv6 */
+    struct ovs_list fib_recheck;    /* nodes which may have become
+                                     * redundant (ops_fib_node) */
+};
+
+#define OPS_ROUTE_TABLE_FLUSH_BATCH 1024    /* routes deleted per run */
+
+static struct hmap ops_route_tables = HMAP_INITIALIZER(&ops_route_tables);
+static struct ovs_list ops_dying_route_tables =
+                            OVS_LIST_INITIALIZER(&ops_dying_route_tables);
+
+/* Pool of fixed size objects. Objects are carved out of large chunks,
+ * which are kept for the life of the process, and freed objects are put
+ * on a free list, so route churn does not go through malloc and the
+ * objects carry no allocator header. */
+struct ops_slab {
+    const char *name;
+    size_t size;                    /* object size */
+    size_t n_per_chunk;             /* objects per chunk */
+    void *free_list;                /* freed objects, linked through their
+                                     * first word */
+    size_t n_chunks;
+    size_t n_used;
+};
+
+#define OPS_SLAB_CHUNK_SIZE     (64 * 1024)
+#define OPS_SLAB_INITIALIZER(NAME, TYPE)                     \
+    { NAME, sizeof(TYPE), OPS_SLAB_CHUNK_SIZE / sizeof(TYPE), \
+      NULL, 0, 0 }
+
+static struct ops_slab ops_route_slab =
+                        OPS_SLAB_INITIALIZER("route", struct ops_route);
+static struct ops_slab ops_nexthop_slab =
+                        OPS_SLAB_INITIALIZER("nexthop", struct ops_nexthop);
+
+/* all ecmp groups in asic, shared between routes with the same nexthops */
+struct hmap ops_ecmp_groups = HMAP_INITIALIZER(&ops_ecmp_groups);
+
+/* all nexthops in use by routes, keyed by vrf and nexthop id */
+struct hmap ops_nexthop_table = HMAP_INITIALIZER(&ops_nexthop_table);
+
+static int ops_nexthop_egress_set(int hw_unit, int vrf, const char *id,
+                                  opennsl_if_t l3_egress_id);
+static bool ops_route_to_l3_route(struct ops_route *ops_routep,
+                                  opennsl_l3_route_t *routep);
+static struct ops_route_table *ops_route_table_lookup(opennsl_vrf_t vrf);
+
+/* Get a zeroed object from a pool */
+static void *
+ops_slab_alloc(struct ops_slab *slab)
+{
+    char *chunk;
+    void *obj;
+    size_t i;
+
+    if (!slab->free_list) {
+        chunk = xmalloc(slab->size * slab->n_per_chunk);
+        for (i = 0; i < slab->n_per_chunk; i++) {
+            obj = chunk + (i * slab->size);
+            *(void **)obj = slab->free_list;
+            slab->free_list = obj;
+        }
+        slab->n_chunks++;
+    }
+
+    obj = slab->free_list;
+    slab->free_list = *(void **)obj;
+    slab->n_used++;
+    memset(obj, 0, slab->size);
+    return obj;
+} /* ops_slab_alloc */
+
+/* Return an object to its pool */
+static void
+ops_slab_free(struct ops_slab *slab, void *obj)
+{
+    *(void **)obj = slab->free_list;
+    slab->free_list = obj;
+    slab->n_used--;
+} /* ops_slab_free */
+
+/* Latency of the l3 programming operations, from the request to the
+ * asic being updated. Samples are kept in log2 buckets of nanoseconds.
+ * All of them are taken on the main thread. */
+enum ops_l3_perf_op {
+    OPS_L3_PERF_ROUTE_ADD,
+    OPS_L3_PERF_ROUTE_REPLACE,
+    OPS_L3_PERF_ROUTE_DELETE,
+    OPS_L3_PERF_HOST_ADD,
+    OPS_L3_PERF_HOST_DELETE,
+    OPS_L3_PERF_ECMP_CREATE,
+    OPS_L3_PERF_ECMP_UPDATE,
+    OPS_L3_PERF_ECMP_DESTROY,
+    OPS_L3_PERF_MAX
+};
+
+#define OPS_L3_PERF_BUCKETS 40      /* last bucket holds 275 s and more */
+
+struct ops_l3_perf {
+    uint64_t count;
+    uint64_t errors;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[OPS_L3_PERF_BUCKETS]; /* [2^(i-1), 2^i) ns */
+};
+
+static const char *ops_l3_perf_names[OPS_L3_PERF_MAX] = {
+    "route add",
+    "route replace",
+    "route delete",
+    "host add",
+    "host delete",
+    "ecmp create",
+    "ecmp update",
+    "ecmp destroy",
+};
+
+static struct ops_l3_perf ops_l3_perf[OPS_L3_PERF_MAX];
+
+/* Monotonic time in nanoseconds, served by the vdso */
+static inline uint64_t
+ops_l3_perf_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+} /* ops_l3_perf_now */
+
+/* Account an operation started at 'start' */
+static void
+ops_l3_perf_record(enum ops_l3_perf_op op, uint64_t start, bool failed)
+{
+    struct ops_l3_perf *perf = &ops_l3_perf[op];
+    uint64_t ns = ops_l3_perf_now() - start;
+    int bucket;
+
+    bucket = ns ? (64 - __builtin_clzll(ns)) : 0;
+    if (bucket >= OPS_L3_PERF_BUCKETS) {
+        bucket = OPS_L3_PERF_BUCKETS - 1;
+    }
+
+    perf->count++;
+    perf->errors += failed;
+    perf->total_ns += ns;
+    perf->max_ns = MAX(perf->max_ns, ns);
+    perf->buckets[bucket]++;
+} /* ops_l3_perf_record */
+
+/* Attributes an egress object of a neighbor is shared on */
+struct ops_egress_key {
+    opennsl_if_t intf;
+    opennsl_port_t port;
+    opennsl_vlan_t vlan;
+    opennsl_mac_t mac;
+};
+
+/* Egress object of a neighbor, shared by the host entries, route
+ * nexthops and ecmp groups using it and destroyed once the last of them
+ * is gone. Indexed by egress id, by key, by port so that the linkscan
+ * thread can find the ecmp groups to prune when a port goes down, and by
+ * (vlan, mac) to move it to the new port of the neighbor on a mac move. */
+struct ops_egress {
+    struct hmap_node node;          /* ops_egresses */
+    struct hmap_node key_node;      /* ops_egresses_by_key */
+    struct hmap_node port_node;     /* ops_egresses_by_port */
+    struct hmap_node mac_node;      /* ops_egresses_by_mac */
+    struct ops_egress_key key;
+    opennsl_if_t egress_id;
+    int hw_unit;
+    int refcnt;
+    struct ovs_list unused_node;    /* in ops_egresses_unused if unused */
+    struct ovs_list members;        /* ecmp groups using it */
+};
+
+/* Membership of an egress object in an ecmp group */
+struct ops_ecmp_member {
+    struct ovs_list grp_node;       /* in ops_ecmp_group->members */
+    struct ovs_list egress_node;    /* in ops_egress->members */
+    struct ops_ecmp_group *grp;
+    struct ops_egress *egress;
+    int count;                      /* copies of the egress in the group */
+    int n_removed;                  /* copies removed on link down */
+};
+
+/* Protects the egress object cache and the ecmp group members in the
+ * asic, which are also updated from the linkscan and l2 callback
+ * threads. */
+static struct ovs_mutex egress_mutex = OVS_MUTEX_INITIALIZER;
+static struct hmap ops_egresses = HMAP_INITIALIZER(&ops_egresses);
+static struct hmap ops_egresses_by_key = HMAP_INITIALIZER(&ops_egresses_by_key);
+static struct hmap ops_egresses_by_port =
+                            HMAP_INITIALIZER(&ops_egresses_by_port);
+static struct hmap ops_egresses_by_mac = HMAP_INITIALIZER(&ops_egresses_by_mac);
+/* egress objects with no user left, destroyed by ops_egress_gc() */
+static struct ovs_list ops_egresses_unused =
+                            OVS_LIST_INITIALIZER(&ops_egresses_unused);
+
+static int ops_egress_acquire(int hw_unit, const struct ops_egress_key *key,
+                              opennsl_if_t *egress_id);
+static void ops_egress_ref(opennsl_if_t egress_id);
+static void ops_egress_unref(opennsl_if_t egress_id);
+static void ops_egress_gc(void);
+
+/* routes deleted by the programming thread released egress objects */
+static bool egress_gc_pending;
+
+/* Resilient hashing of ecmp groups, set with OFPROTO_ECMP_HASH_RESILIENT */
+static bool ecmp_resilient = false;
+
+/* Mac moves reported by the l2 callback thread, queued in a single
+ * producer single consumer ring and applied by the main thread once the
+ * mac settled on a port. */
+#define OPS_MAC_MOVE_RING_SIZE      1024    /* power of 2 */
+#define OPS_MAC_MOVE_SETTLE_MSEC    200
+
+struct ops_mac_move_event {
+    opennsl_vlan_t vid;
+    opennsl_mac_t mac;
+    opennsl_port_t port;            /* new port */
+};
+
+static struct ops_mac_move_event mac_move_ring[OPS_MAC_MOVE_RING_SIZE];
+static atomic_uint mac_move_head;   /* written by the l2 callback thread */
+static atomic_uint mac_move_tail;   /* written by the main thread */
+static atomic_bool mac_move_overflow;
+static struct latch mac_move_latch;
+static bool mac_move_latch_initialized;
+
+/* Moves of a mac coalesced until it settles */
+struct ops_mac_move {
+    struct hmap_node node;          /* ops_mac_moves */
+    opennsl_vlan_t vid;
+    opennsl_mac_t mac;
+    opennsl_port_t port;            /* last port the mac moved to */
+    long long int deadline;         /* time to move the egress objects */
+};
+
+static struct hmap ops_mac_moves = HMAP_INITIALIZER(&ops_mac_moves);
+
+/* periodic audit of the route table against the asic, 0 disables */
+static long long int route_audit_interval;   /* msec */
+static long long int route_audit_next;
+
+/* Warm restart. The host, route, egress and ecmp tables left in the asic
+ * by the previous run are read back at init and marked stale. Entries
+ * replayed from the configuration claim them in place, and whatever is
+ * still stale once the replay settled is deleted. */
+#define OPS_BOOT_F_WARM_BOOT        0x200000    /* in OPENNSL_BOOT_FLAGS */
+#define OPS_RECONCILE_IDLE_MSEC     10000       /* no claim for that long */
+#define OPS_RECONCILE_MAX_MSEC      300000
+
+/* Host or route entry of the previous run not claimed yet */
+struct ops_stale_entry {
+    struct hmap_node node;          /* ops_stale_hosts or ops_stale_routes */
+    struct ops_route_key key;       /* hosts use a full length prefix */
+    union {
+        opennsl_l3_host_t host;
+        opennsl_l3_route_t route;
+    };
+};
 
-/* all routes in asic*/
-struct ops_route_table{
-   struct hmap routes;
+static struct hmap ops_stale_hosts = HMAP_INITIALIZER(&ops_stale_hosts);
+static struct hmap ops_stale_routes = HMAP_INITIALIZER(&ops_stale_routes);
+static bool reconcile_active;
+static int reconcile_unit;
+static long long int reconcile_start;
+static long long int reconcile_last_claim;   /* 0 until the first claim */
+static int reconcile_claimed;
+static bool reconcile_ran;
+static int reconcile_ecmp_taken;            /* ecmp groups taken over */
+static int reconcile_ecmp_reused;           /* of those, used at the end */
+
+static bool ops_reconcile_start(int unit);
+
+/* Weight of a nexthop in the ecmp groups, nexthops not in the registry
+ * have a weight of 1 */
+struct ops_nexthop_weight {
+    struct hmap_node node;          /* ops_nexthop_weights */
+    int vrf;
+    char *id;                       /* nexthop ip address */
+    int weight;
 };
 
-struct ops_route_table ops_rtable;
+static struct hmap ops_nexthop_weights =
+                            HMAP_INITIALIZER(&ops_nexthop_weights);
+
+/* Maximum number of members of an ecmp group after weight replication */
+static int ecmp_max_members = OPS_ECMP_MAX_MEMBERS;
 
 int
 ops_l3_init(int unit)
@@ -64,45 +367,59 @@ ops_l3_init(int unit)
     int hash_cfg = 0;
     opennsl_error_t rc = OPENNSL_E_NONE;
     opennsl_l3_egress_t egress_object;
+    const char *boot_flags;
+    bool have_local_nhid = false;
 
-    rc = opennsl_switch_control_set(unit, opennslSwitchL3IngressMode, 1);
+    rc = ops_switch_control_set(unit, opennslSwitchL3IngressMode, 1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchL3IngressMode: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
 
-    rc = opennsl_switch_control_set(unit, opennslSwitchL3EgressMode, 1);
+    rc = ops_switch_control_set(unit, opennslSwitchL3EgressMode, 1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchL3EgressMode: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
 
+    /* Take over the l3 tables of the previous run on a warm restart,
+     * including its egress object for unresolved NH */
+    boot_flags = getenv("OPENNSL_BOOT_FLAGS");
+    if (boot_flags && (strtoul(boot_flags, NULL, 0) & OPS_BOOT_F_WARM_BOOT)) {
+        have_local_nhid = ops_reconcile_start(unit);
+    }
+
     /* Create a system wide egress object for unresolved NH */
-    opennsl_l3_egress_t_init(&egress_object);
+    if (!have_local_nhid) {
+        opennsl_l3_egress_t_init(&egress_object);
 
-    egress_object.intf = -1;
-    egress_object.port = 0; /* CPU port */
-    egress_object.flags = OPENNSL_L3_COPY_TO_CPU;
-    memcpy(egress_object.mac_addr, LOCAL_MAC, ETH_ALEN);
-    rc = opennsl_l3_egress_create(unit, OPENNSL_L3_COPY_TO_CPU,
-                                  &egress_object, &local_nhid);
+        egress_object.intf = -1;
+        egress_object.port = 0; /* CPU port */
+        egress_object.flags = OPENNSL_L3_COPY_TO_CPU;
+        memcpy(egress_object.mac_addr, LOCAL_MAC, ETH_ALEN);
+        rc = opennsl_l3_egress_create(unit, OPENNSL_L3_COPY_TO_CPU,
+                                      &egress_object, &local_nhid);
 
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Error, create a local egress object, rc=%s", opennsl_errmsg(rc));
-        return rc;
+        if (OPENNSL_FAILURE(rc)) {
+            VLOG_ERR("Error, create a local egress object, rc=%s", opennsl_errmsg(rc));
+            return rc;
+        }
     }
 
+    /* Seed the table occupancy with what is programmed so far */
+    ops_hw_table_init(unit);
+
     /* Send ARP to CPU */
-    rc = opennsl_switch_control_set(unit, opennslSwitchArpRequestToCpu, 1);
+    rc = ops_switch_control_set(unit, opennslSwitchArpRequestToCpu, 1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchArpRequestToCpu: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
 
-    rc = opennsl_switch_control_set(unit, opennslSwitchArpReplyToCpu, 1);
+    rc = ops_switch_control_set(unit, opennslSwitchArpReplyToCpu, 1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchArpReplyToCpu: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
@@ -110,7 +427,7 @@ ops_l3_init(int unit)
     }
 
 
-    rc = opennsl_switch_control_set(unit, opennslSwitchDhcpPktToCpu, 1);
+    rc = ops_switch_control_set(unit, opennslSwitchDhcpPktToCpu, 1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchDhcpPktToCpu: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
@@ -118,7 +435,7 @@ ops_l3_init(int unit)
     }
 
     /* IPv6 ND packets */
-    rc = opennsl_switch_control_set(unit, opennslSwitchNdPktToCpu, 1);
+    rc = ops_switch_control_set(unit, opennslSwitchNdPktToCpu, 1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchNdPktToCpu: unit=%d  rc=%s",
                  unit, opennsl_errmsg(rc));
@@ -126,14 +443,14 @@ ops_l3_init(int unit)
     }
 
     /* Send IPv4 and IPv6 to CPU */
-    rc = opennsl_switch_control_set(unit,opennslSwitchUnknownL3DestToCpu, 1);
+    rc = ops_switch_control_set(unit,opennslSwitchUnknownL3DestToCpu, 1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchUnknownL3DestToCpu: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
 
-    rc = opennsl_switch_control_set(unit, opennslSwitchV6L3DstMissToCpu, 1);
+    rc = ops_switch_control_set(unit, opennslSwitchV6L3DstMissToCpu, 1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchV6L3DstMissToCpu: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
@@ -141,8 +458,8 @@ ops_l3_init(int unit)
     }
 
     /* Enable ECMP enhanced hash method */
-    rc = opennsl_switch_control_set(unit, opennslSwitchHashControl,
-                                    OPENNSL_HASH_CONTROL_ECMP_ENHANCE);
+    rc = ops_switch_control_set(unit, opennslSwitchHashControl,
+                                OPENNSL_HASH_CONTROL_ECMP_ENHANCE);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set OPENNSL_HASH_CONTROL_ECMP_ENHANCE: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
@@ -154,25 +471,25 @@ ops_l3_init(int unit)
                OPENNSL_HASH_FIELD_SRCL4 | OPENNSL_HASH_FIELD_IP4DST_LO |
                OPENNSL_HASH_FIELD_IP4DST_HI | OPENNSL_HASH_FIELD_DSTL4;
 
-    rc = opennsl_switch_control_set(unit,
-                                    opennslSwitchHashIP4TcpUdpPortsEqualField0,
-                                    hash_cfg);
+    rc = ops_switch_control_set(unit,
+                                opennslSwitchHashIP4TcpUdpPortsEqualField0,
+                                hash_cfg);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP4TcpUdpPortsEqualField0: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit,
-                                    opennslSwitchHashIP4TcpUdpField0,
-                                    hash_cfg);
+    rc = ops_switch_control_set(unit,
+                                opennslSwitchHashIP4TcpUdpField0,
+                                hash_cfg);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP4TcpUdpPortsEqualField0: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit,
-                                    opennslSwitchHashIP4Field0,
-                                    hash_cfg);
+    rc = ops_switch_control_set(unit,
+                                opennslSwitchHashIP4Field0,
+                                hash_cfg);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP4Field0: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
@@ -184,25 +501,25 @@ ops_l3_init(int unit)
                OPENNSL_HASH_FIELD_SRCL4 | OPENNSL_HASH_FIELD_IP6DST_LO |
                OPENNSL_HASH_FIELD_IP6DST_HI | OPENNSL_HASH_FIELD_DSTL4;
 
-    rc = opennsl_switch_control_set(unit,
-                                    opennslSwitchHashIP6TcpUdpPortsEqualField0,
-                                    hash_cfg);
+    rc = ops_switch_control_set(unit,
+                                opennslSwitchHashIP6TcpUdpPortsEqualField0,
+                                hash_cfg);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP6TcpUdpPortsEqualField0: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit,
-                                    opennslSwitchHashIP6TcpUdpField0,
-                                    hash_cfg);
+    rc = ops_switch_control_set(unit,
+                                opennslSwitchHashIP6TcpUdpField0,
+                                hash_cfg);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP6TcpUdpPortsEqualField0: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit,
-                                    opennslSwitchHashIP6Field0,
-                                    hash_cfg);
+    rc = ops_switch_control_set(unit,
+                                opennslSwitchHashIP6Field0,
+                                hash_cfg);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP6Field0: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
@@ -210,51 +527,50 @@ ops_l3_init(int unit)
     }
 
     /* FIXME : Generate the seed from the system MAC? */
-    rc = opennsl_switch_control_set(unit, opennslSwitchHashSeed0, 0x12345678);
+    rc = ops_switch_control_set(unit, opennslSwitchHashSeed0, 0x12345678);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashSeed0: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit, opennslSwitchHashField0PreProcessEnable,
-                                    1);
+    rc = ops_switch_control_set(unit, opennslSwitchHashField0PreProcessEnable,
+                                1);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashField0PreProcessEnable: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit, opennslSwitchHashField0Config,
-                                    OPENNSL_HASH_FIELD_CONFIG_CRC16CCITT);
+    rc = ops_switch_control_set(unit, opennslSwitchHashField0Config,
+                                OPENNSL_HASH_FIELD_CONFIG_CRC16CCITT);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashField0Config: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit, opennslSwitchHashField0Config1,
-                                    OPENNSL_HASH_FIELD_CONFIG_CRC16CCITT);
+    rc = ops_switch_control_set(unit, opennslSwitchHashField0Config1,
+                                OPENNSL_HASH_FIELD_CONFIG_CRC16CCITT);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashField0Config1: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit, opennslSwitchECMPHashSet0Offset, 0);
+    rc = ops_switch_control_set(unit, opennslSwitchECMPHashSet0Offset, 0);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchECMPHashSet0Offset: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(unit, opennslSwitchHashSelectControl, 0);
+    rc = ops_switch_control_set(unit, opennslSwitchHashSelectControl, 0);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashSelectControl: unit=%d rc=%s",
                  unit, opennsl_errmsg(rc));
         return 1;
     }
 
-    /* initialize route table hash map */
-    hmap_init(&ops_rtable.routes);
-
-    /* Initialize egress-id hash map. Used only during mac-move. */
-    hmap_init(&ops_mac_move_egress_id_map);
+    if (!mac_move_latch_initialized) {
+        latch_init(&mac_move_latch);
+        mac_move_latch_initialized = true;
+    }
 
     /* register for mac-move. When move happens, ASIC sends a MAC delete
      * message followed by MAC add message. There will be MOVE flag set in
@@ -269,6 +585,35 @@ ops_l3_init(int unit)
     return 0;
 }
 
+/* Create an l3 interface. On a warm restart the interface of the
+ * previous run with the same mac and vlan is still in the asic, it is
+ * updated in place and kept. */
+static opennsl_error_t
+ops_l3_intf_create(int hw_unit, opennsl_l3_intf_t *l3_intf)
+{
+    opennsl_l3_intf_t old_intf;
+    opennsl_error_t rc;
+
+    rc = opennsl_l3_intf_create(hw_unit, l3_intf);
+    if ((rc == OPENNSL_E_EXISTS) && reconcile_active) {
+        opennsl_l3_intf_t_init(&old_intf);
+        memcpy(old_intf.l3a_mac_addr, l3_intf->l3a_mac_addr, ETH_ALEN);
+        old_intf.l3a_vid = l3_intf->l3a_vid;
+        rc = opennsl_l3_intf_find(hw_unit, &old_intf);
+        if (OPENNSL_FAILURE(rc)) {
+            return rc;
+        }
+        l3_intf->l3a_intf_id = old_intf.l3a_intf_id;
+        l3_intf->l3a_flags |= (OPENNSL_L3_REPLACE | OPENNSL_L3_WITH_ID);
+        return opennsl_l3_intf_create(hw_unit, l3_intf);
+    }
+    if (OPENNSL_SUCCESS(rc)) {
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_L3_INTF, 1);
+    }
+
+    return rc;
+} /* ops_l3_intf_create */
+
 opennsl_l3_intf_t *
 ops_routing_enable_l3_interface(int hw_unit, opennsl_port_t hw_port,
                                 opennsl_vrf_t vrf_id, opennsl_vlan_t vlan_id,
@@ -308,7 +653,7 @@ ops_routing_enable_l3_interface(int hw_unit, opennsl_port_t hw_port,
     memcpy(l3_intf->l3a_mac_addr, mac, ETH_ALEN);
     l3_intf->l3a_vid = vlan_id;
 
-    rc = opennsl_l3_intf_create(hw_unit, l3_intf);
+    rc = ops_l3_intf_create(hw_unit, l3_intf);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed at opennsl_l3_intf_create: unit=%d port=%d vlan=%d vrf=%d rc=%s",
                  hw_unit, hw_port, vlan_id, vrf_id, opennsl_errmsg(rc));
@@ -382,7 +727,7 @@ ops_routing_enable_l3_subinterface(int hw_unit, opennsl_port_t hw_port,
     l3_intf->l3a_vid = vlan_id;
 
     VLOG_DBG("opennsl l3 create() for subinterface\n");
-    rc = opennsl_l3_intf_create(hw_unit, l3_intf);
+    rc = ops_l3_intf_create(hw_unit, l3_intf);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed at opennsl_l3_intf_create: unit=%d port=%d vlan=%d vrf=%d rc=%s",
                  hw_unit, hw_port, vlan_id, vrf_id, opennsl_errmsg(rc));
@@ -429,6 +774,8 @@ ops_routing_disable_l3_interface(int hw_unit, opennsl_port_t hw_port,
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed at opennsl_l3_intf_delete: unit=%d port=%d vlan=%d vrf=%d rc=%s",
                  hw_unit, hw_port, vlan_id, vrf_id, opennsl_errmsg(rc));
+    } else {
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_L3_INTF, -1);
     }
 
     /* Reset VLAN on port back to default and destroy the VLAN */
@@ -462,6 +809,8 @@ ops_routing_disable_l3_subinterface(int hw_unit, opennsl_port_t hw_port,
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed at opennsl_l3_intf_delete: unit=%d port=%d vlan=%d vrf=%d rc=%s",
                  hw_unit, hw_port, vlan_id, vrf_id, opennsl_errmsg(rc));
+    } else {
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_L3_INTF, -1);
     }
 
     /* Reset VLAN on port back to default and destroy the VLAN */
@@ -509,7 +858,7 @@ ops_routing_enable_l3_vlan_interface(int hw_unit, opennsl_vrf_t vrf_id,
     memcpy(l3_intf->l3a_mac_addr, mac, ETH_ALEN);
     l3_intf->l3a_vid = vlan_id;
 
-    rc = opennsl_l3_intf_create(hw_unit, l3_intf);
+    rc = ops_l3_intf_create(hw_unit, l3_intf);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed at opennsl_l3_intf_create: unit=%d vlan=%d vrf=%d rc=%s",
                  hw_unit, vlan_id, vrf_id, opennsl_errmsg(rc));
@@ -523,867 +872,4113 @@ ops_routing_enable_l3_vlan_interface(int hw_unit, opennsl_vrf_t vrf_id,
     return l3_intf;
 } /* ops_routing_enable_l3_vlan_interface */
 
-/* Add nexthop into the route entry */
-static void
-ops_nexthop_add(struct ops_route *route,  struct ofproto_route_nexthop *of_nh)
+/* Parse "address/prefixlen" into a binary route key. The address is
+ * copied into a stack buffer, nothing is allocated. */
+static int
+ops_route_key_from_string(opennsl_vrf_t vrf_id, int family,
+                          const char *prefix_str, struct ops_route_key *key)
 {
-    char *hashstr;
-    struct ops_nexthop *nh;
+    char addr_str[INET6_ADDRSTRLEN];
+    const char *p;
+    size_t len;
+    int maxlen = (family == AF_INET) ? IPV4_PREFIX_LEN :
+                                       IPV6_PREFIX_LEN;
+    int prefixlen = maxlen;
+    int nbytes;
 
-    if (!route || !of_nh) {
-        return;
+    memset(key, 0, sizeof(*key));
+
+    p = strchr(prefix_str, '/');
+    len = p ? (size_t)(p - prefix_str) : strlen(prefix_str);
+    if (len >= sizeof(addr_str)) {
+        VLOG_ERR("Invalid ip address %s", prefix_str);
+        return EINVAL;
     }
+    memcpy(addr_str, prefix_str, len);
+    addr_str[len] = '\0';
 
-    nh = xzalloc(sizeof(*nh));
-    nh->type = of_nh->type;
-    /* NOTE: Either IP or Port, not both */
-    if (of_nh->id) {
-        nh->id = xstrdup(of_nh->id);
+    if (p) {
+        prefixlen = atoi(p + 1);
     }
 
-    nh->l3_egress_id = (of_nh->state == OFPROTO_NH_RESOLVED) ?
-                        of_nh->l3_egress_id : local_nhid ;
+    if ((prefixlen < 0) || (prefixlen > maxlen)) {
+        VLOG_DBG("Bad prefixlen %d > %d", prefixlen, maxlen);
+        return EINVAL;
+    }
 
-    hashstr = of_nh->id;
-    hmap_insert(&route->nexthops, &nh->node, hash_string(hashstr, 0));
-    route->n_nexthops++;
+    if (inet_pton(family, addr_str, key->prefix) != 1) {
+        VLOG_ERR("Invalid ip address %s", prefix_str);
+        return EINVAL;
+    }
 
-    VLOG_DBG("Add NH %s, egress_id %d, for route %s",
-              nh->id, nh->l3_egress_id, route->prefix);
-} /* ops_nexthop_add */
+    /* clear the host bits, equal prefixes must have equal keys */
+    nbytes = prefixlen / 8;
+    if (prefixlen % 8) {
+        key->prefix[nbytes++] &= (0xff << (8 - (prefixlen % 8))) & 0xff;
+    }
+    memset(&key->prefix[nbytes], 0, sizeof(key->prefix) - nbytes);
 
-/* Delete nexthop into route entry */
-static void
-ops_nexthop_delete(struct ops_route *route, struct ops_nexthop *nh)
+    key->vrf = vrf_id;
+    key->is_ipv6 = (family == AF_INET6);
+    key->prefixlen = prefixlen;
+
+    return 0;
+} /* ops_route_key_from_string */
+
+/* Format a route key as "address/prefixlen" */
+static const char *
+ops_route_key_to_string(const struct ops_route_key *key, char *buf,
+                        size_t len)
 {
-    if (!route || !nh) {
-        return;
-    }
+    char addr_str[INET6_ADDRSTRLEN];
 
-    VLOG_DBG("Delete NH %s in route %s", nh->id, route->prefix);
+    inet_ntop(key->is_ipv6 ? AF_INET6 : AF_INET, key->prefix,
+              addr_str, sizeof(addr_str));
+    snprintf(buf, len, "%s/%d", addr_str, key->prefixlen);
 
-    hmap_remove(&route->nexthops, &nh->node);
-    if (nh->id) {
-        free(nh->id);
-    }
-    free(nh);
-    route->n_nexthops--;
-} /* ops_nexthop_delete */
+    return buf;
+} /* ops_route_key_to_string */
 
-/* Find nexthop entry in the route's nexthops hash */
-static struct ops_nexthop*
-ops_nexthop_lookup(struct ops_route *route, struct ofproto_route_nexthop *of_nh)
+/* Fill the vrf and prefix of an opennsl route from a route key */
+static void
+ops_route_key_to_l3_route(const struct ops_route_key *key,
+                          opennsl_l3_route_t *route)
 {
-    char *hashstr;
-    struct ops_nexthop *nh;
+    uint32_t ipv4_addr;
 
-    hashstr = of_nh->id;
-    HMAP_FOR_EACH_WITH_HASH(nh, node, hash_string(hashstr, 0),
-                            &route->nexthops) {
-        if ((strcmp(nh->id, of_nh->id) == 0)){
-            return nh;
-        }
+    if (key->is_ipv6) {
+        route->l3a_flags |= OPENNSL_L3_IP6;
+        memcpy(route->l3a_ip6_net, key->prefix, sizeof(struct in6_addr));
+        opennsl_ip6_mask_create(route->l3a_ip6_mask, key->prefixlen);
+    } else {
+        /* ipv4 address in host order */
+        memcpy(&ipv4_addr, key->prefix, sizeof(ipv4_addr));
+        route->l3a_subnet = ntohl(ipv4_addr);
+        route->l3a_ip_mask = opennsl_ip_mask_create(key->prefixlen);
     }
-    return NULL;
-} /* ops_nexthop_lookup */
+    route->l3a_vrf = key->vrf;
+} /* ops_route_key_to_l3_route */
 
-/* Create route hash */
+/* Build a route key from an opennsl route read from the asic */
 static void
-ops_route_hash(int vrf, char *prefix, char *hashstr, int hashlen)
+ops_route_key_from_l3_route(const opennsl_l3_route_t *route,
+                            struct ops_route_key *key)
 {
-    snprintf(hashstr, hashlen, "%d:%s", vrf, prefix);
-} /* ops_route_hash */
+    uint32_t ipv4_addr;
+    int i;
 
-/* Find a route entry matching the prefix */
-static struct ops_route *
-ops_route_lookup(int vrf, struct ofproto_route *of_routep)
-{
-    struct ops_route *route;
-    char hashstr[OPS_ROUTE_HASH_MAXSIZE];
+    memset(key, 0, sizeof(*key));
+    key->vrf = route->l3a_vrf;
 
-    ops_route_hash(vrf, of_routep->prefix, hashstr, sizeof(hashstr));
-    HMAP_FOR_EACH_WITH_HASH(route, node, hash_string(hashstr, 0),
-                            &ops_rtable.routes) {
-        if ((strcmp(route->prefix, of_routep->prefix) == 0) &&
-            (route->vrf == vrf)) {
-            return route;
+    if (route->l3a_flags & OPENNSL_L3_IP6) {
+        key->is_ipv6 = 1;
+        for (i = 0; i < sizeof(struct in6_addr); i++) {
+            key->prefix[i] = route->l3a_ip6_net[i] & route->l3a_ip6_mask[i];
+            key->prefixlen += count_1bits(route->l3a_ip6_mask[i]);
         }
+    } else {
+        ipv4_addr = htonl(route->l3a_subnet & route->l3a_ip_mask);
+        memcpy(key->prefix, &ipv4_addr, sizeof(ipv4_addr));
+        key->prefixlen = count_1bits(route->l3a_ip_mask);
     }
-    return NULL;
-} /* ops_route_lookup */
+} /* ops_route_key_from_l3_route */
 
-/* Add new route and NHs */
-static struct ops_route*
-ops_route_add(int vrf, struct ofproto_route *of_routep)
+/* Account an added or deleted route in the occupancy of the table it is
+ * programmed in */
+static void
+ops_route_table_update(int hw_unit, const opennsl_l3_route_t *route,
+                       bool in_host_table, int delta)
 {
-    int i;
-    struct ops_route *routep;
-    struct ofproto_route_nexthop *of_nh;
-    char hashstr[OPS_ROUTE_HASH_MAXSIZE];
-
-    if (!of_routep) {
-        return NULL;
+    if (in_host_table) {
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_HOST, delta);
+        return;
     }
+    ops_hw_table_update(hw_unit, (route->l3a_flags & OPENNSL_L3_IP6) ?
+                        OPS_HW_TABLE_ROUTE_V6 : OPS_HW_TABLE_ROUTE_V4, delta);
+} /* ops_route_table_update */
 
-    routep = xzalloc(sizeof(*routep));
-    routep->vrf = vrf;
-    routep->prefix = xstrdup(of_routep->prefix);
-    routep->is_ipv6 = (of_routep->family == OFPROTO_ROUTE_IPV6) ? true : false;
-    routep->n_nexthops = 0;
+/* Host-length prefixes (/32 and /128) of new routes are programmed in the
+ * host table, which is hashed and much larger than the lpm tcam. A route
+ * stays in the table it was first programmed in. */
+static bool ops_host_routes = false;
 
-    hmap_init(&routep->nexthops);
+static bool
+ops_route_key_is_host(const struct ops_route_key *key)
+{
+    return key->prefixlen == (key->is_ipv6 ? 128 : 32);
+} /* ops_route_key_is_host */
 
-    for (i = 0; i < of_routep->n_nexthops; i++) {
-        of_nh = &of_routep->nexthops[i];
-        ops_nexthop_add(routep, of_nh);
+/* Fill the host entry holding a host-length route */
+static void
+ops_l3_route_to_l3_host(const opennsl_l3_route_t *route,
+                        opennsl_l3_host_t *l3host)
+{
+    opennsl_l3_host_t_init(l3host);
+    l3host->l3a_vrf = route->l3a_vrf;
+    l3host->l3a_intf = route->l3a_intf;
+    l3host->l3a_flags = route->l3a_flags & (OPENNSL_L3_IP6 |
+                                            OPENNSL_L3_MULTIPATH |
+                                            OPENNSL_L3_REPLACE);
+    if (route->l3a_flags & OPENNSL_L3_IP6) {
+        memcpy(l3host->l3a_ip6_addr, route->l3a_ip6_net,
+               sizeof(struct in6_addr));
+    } else {
+        l3host->l3a_ip_addr = route->l3a_subnet;
     }
+} /* ops_l3_route_to_l3_host */
 
-    ops_route_hash(vrf, of_routep->prefix, hashstr, sizeof(hashstr));
-    hmap_insert(&ops_rtable.routes, &routep->node, hash_string(hashstr, 0));
-    VLOG_DBG("Add route %s", of_routep->prefix);
-    return routep;
-} /* ops_route_add */
-
-/* Update route nexthop: add, delete, resolve and unresolve nh */
-static void
-ops_route_update(int vrf, struct ops_route *routep,
-                 struct ofproto_route *of_routep,
-                 bool is_delete_nh)
+/* Add or replace a route in the lpm */
+static int
+ops_route_lpm_add(int hw_unit, opennsl_l3_route_t *route)
 {
-    struct ops_nexthop* nh;
-    struct ofproto_route_nexthop *of_nh;
-    int i;
+    int rc;
 
-    for (i = 0; i < of_routep->n_nexthops; i++) {
-        of_nh = &of_routep->nexthops[i];
-        nh = ops_nexthop_lookup(routep, of_nh);
-        if (is_delete_nh) {
-            ops_nexthop_delete(routep, nh);
-        } else {
-            /* add or update */
-            if (!nh) {
-                ops_nexthop_add(routep, of_nh);
-            } else {
-                /* update is currently resolved on unreoslved */
-                nh->l3_egress_id = (of_nh->state == OFPROTO_NH_RESOLVED) ?
-                                    of_nh->l3_egress_id : local_nhid ;
-            }
-        }
+    ops_hw_queue_sync(ops_hw_obj_route(route));
+    rc = opennsl_l3_route_add(hw_unit, route);
+    if (OPENNSL_SUCCESS(rc) && !(route->l3a_flags & OPENNSL_L3_REPLACE)) {
+        ops_route_table_update(hw_unit, route, false, 1);
     }
-} /* ops_route_update */
+    return rc;
+} /* ops_route_lpm_add */
 
-/* Delete route in system*/
-static void
-ops_route_delete(struct ops_route *routep)
+/* Delete a route from the lpm */
+static int
+ops_route_lpm_delete(int hw_unit, opennsl_l3_route_t *route)
 {
-    struct ops_nexthop *nh, *next;
+    int rc;
 
-    if (!routep) {
-        return;
+    ops_hw_queue_sync(ops_hw_obj_route(route));
+    rc = opennsl_l3_route_delete(hw_unit, route);
+    if (OPENNSL_SUCCESS(rc)) {
+        ops_route_table_update(hw_unit, route, false, -1);
     }
+    return rc;
+} /* ops_route_lpm_delete */
 
-    VLOG_DBG("delete route %s", routep->prefix);
+/* Fib compression. The lpm of a compressed vrf only holds the routes
+ * whose egress differs from the one of their closest covering route, the
+ * traffic of the others is forwarded the same by that route. The routes
+ * of the vrf are kept in a path compressed binary trie per family, where
+ * each node records the egress of its route and whether it is in the lpm.
+ *
+ * An update first programs the routes below it which the lpm would
+ * otherwise forward elsewhere, so the lpm always forwards like the route
+ * table. Routes made redundant by an update are queued, and deleted from
+ * the lpm by ops_routing_fib_run() a batch at a time, except an updated
+ * route whose own lpm entry went stale, which is deleted right away.
+ * Routes in the host table are left out of the trie. */
+struct ops_fib_node {
+    struct ops_fib_node *parent;
+    struct ops_fib_node *child[2];
+    struct ovs_list recheck_node;   /* in ops_route_table->fib_recheck */
+    uint8_t prefix[16];             /* network order, host bits cleared */
+    uint8_t prefixlen;
+    bool is_ipv6;
+    bool is_route;                  /* branch node otherwise */
+    bool installed;                 /* route programmed in the lpm */
+    bool multipath;
+    opennsl_if_t intf;              /* egress of the route */
+};
 
-    hmap_remove(&ops_rtable.routes, &routep->node);
+#define OPS_FIB_RECHECK_BATCH 1024      /* redundant routes checked per run */
 
-    HMAP_FOR_EACH_SAFE(nh, next, node, &routep->nexthops) {
-        ops_nexthop_delete(routep, nh);
-    }
+static struct ops_slab ops_fib_slab =
+                        OPS_SLAB_INITIALIZER("fib node", struct ops_fib_node);
 
-    if (routep->prefix) {
-        free(routep->prefix);
-    }
-    free(routep);
-} /* ops_route_delete */
+/* Egress expected for the routes below a node after an update */
+struct ops_fib_update {
+    struct ops_route_table *rtable;
+    bool covered;                   /* false if no route covers them */
+    opennsl_if_t intf;
+    bool multipath;
+};
 
-/* Function to add l3 host entry via ofproto */
-int
-ops_routing_add_host_entry(int hw_unit, opennsl_port_t hw_port,
-                           opennsl_vrf_t vrf_id, bool is_ipv6_addr,
-                           char *ip_addr, char *next_hop_mac_addr,
-                           opennsl_if_t l3_intf_id,
-                           opennsl_if_t *l3_egress_id,
-                           opennsl_vlan_t vlan_id)
+static inline int
+ops_fib_bit(const uint8_t *prefix, int bit)
 {
-    opennsl_error_t rc = OPENNSL_E_NONE;
-    opennsl_l3_egress_t egress_object;
-    opennsl_l3_host_t l3host;
-    in_addr_t ipv4_dest_addr;
-    char ipv6_dest_addr[sizeof(struct in6_addr)];
-    int flags = 0;
-    struct ether_addr *ether_mac = ether_aton(next_hop_mac_addr);
-    opennsl_port_t port = hw_port;
-    opennsl_l2_addr_t addr;
+    return (prefix[bit / 8] >> (7 - (bit % 8))) & 1;
+} /* ops_fib_bit */
 
-    /* If we dont have a hw_port, this is likely a vlan interface
-     * Look it up.
-     */
-    if(hw_port == -1) {
-        opennsl_mac_t host_mac;
-        if (ether_mac != NULL)
-           memcpy(host_mac, ether_mac, ETH_ALEN);
-        opennsl_l2_addr_get(hw_unit, host_mac, vlan_id, &addr);
-        port = addr.port;
-    }
+/* Number of leading bits two prefixes have in common, up to 'max' */
+static int
+ops_fib_common_len(const uint8_t *a, const uint8_t *b, int max)
+{
+    int len = 0;
 
-    /* Create the l3_egress object which gives the index to l3 interface
-     * during lookup */
-    VLOG_DBG("In ops_routing_add_host_entry for ip %s", ip_addr);
-    opennsl_l3_egress_t_init(&egress_object);
+    while ((len + 8 <= max) && (a[len / 8] == b[len / 8])) {
+        len += 8;
+    }
+    while ((len < max) && (ops_fib_bit(a, len) == ops_fib_bit(b, len))) {
+        len++;
+    }
+    return len;
+} /* ops_fib_common_len */
 
-    /* Copy the nexthop destmac, set dest port and index of L3_INTF table
-     * which is created above */
-    egress_object.intf = l3_intf_id;
-    egress_object.port = port;
+static struct ops_fib_node *
+ops_fib_node_alloc(const uint8_t *prefix, int prefixlen, bool is_ipv6)
+{
+    struct ops_fib_node *node;
 
-    if (ether_mac != NULL) {
-        memcpy(egress_object.mac_addr, ether_mac, ETH_ALEN);
-    } else {
-        VLOG_ERR("Invalid mac-%s", next_hop_mac_addr);
-        return 1; /* Return error */
+    node = ops_slab_alloc(&ops_fib_slab);
+    memcpy(node->prefix, prefix, prefixlen / 8);
+    if (prefixlen % 8) {
+        node->prefix[prefixlen / 8] = prefix[prefixlen / 8] &
+                                      (0xff << (8 - (prefixlen % 8)));
+    }
+    node->prefixlen = prefixlen;
+    node->is_ipv6 = is_ipv6;
+    list_init(&node->recheck_node);
+    return node;
+} /* ops_fib_node_alloc */
+
+/* Find or add the node of a route key */
+static struct ops_fib_node *
+ops_fib_insert(struct ops_route_table *rtable, const struct ops_route_key *key)
+{
+    struct ops_fib_node **link = &rtable->fib[key->is_ipv6];
+    struct ops_fib_node *parent = NULL;
+    struct ops_fib_node *node, *new, *branch;
+    int common = 0;
+
+    while ((node = *link)) {
+        common = ops_fib_common_len(node->prefix, key->prefix,
+                                    MIN(node->prefixlen, key->prefixlen));
+        if (common < node->prefixlen) {
+            break;
+        }
+        if (node->prefixlen == key->prefixlen) {
+            return node;
+        }
+        parent = node;
+        link = &node->child[ops_fib_bit(key->prefix, node->prefixlen)];
     }
 
-    rc = opennsl_l3_egress_find(hw_unit, &egress_object, l3_egress_id);
-    if (rc == OPENNSL_E_NONE) {
-        /* An entry exists. Use OPENNSL_L3_REPLACE flag to replace it. */
-        flags = (OPENNSL_L3_REPLACE | OPENNSL_L3_WITH_ID);
-    } else if (rc != OPENNSL_E_NOT_FOUND) {
-        VLOG_ERR("Error, finding an egress entry: rc=%s", opennsl_errmsg(rc));
-    } else {
-        /* no entry found in egress table. */
+    new = ops_fib_node_alloc(key->prefix, key->prefixlen, key->is_ipv6);
+    new->parent = parent;
+    if (!node) {
+        *link = new;
+        return new;
     }
 
-    rc = opennsl_l3_egress_create(hw_unit, flags, &egress_object, l3_egress_id);
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Error, create egress object, out_port=%d, rc=%s", hw_port,
-                 opennsl_errmsg(rc));
-        return rc;
+    if (common == key->prefixlen) {
+        /* the new prefix covers the node */
+        new->child[ops_fib_bit(node->prefix, common)] = node;
+        node->parent = new;
+        *link = new;
+        return new;
     }
 
-    VLOG_DBG("Created L3 egress ID %d for out_port: %d intf_id: %d ",
-          *l3_egress_id, port, l3_intf_id);
+    /* the prefixes diverge, branch where they stop matching */
+    branch = ops_fib_node_alloc(key->prefix, common, key->is_ipv6);
+    branch->parent = parent;
+    branch->child[ops_fib_bit(node->prefix, common)] = node;
+    branch->child[ops_fib_bit(key->prefix, common)] = new;
+    node->parent = branch;
+    new->parent = branch;
+    *link = branch;
+    return new;
+} /* ops_fib_insert */
+
+/* Drop the route of a node, and the nodes no longer needed to branch */
+static void
+ops_fib_remove(struct ops_route_table *rtable, struct ops_fib_node *node)
+{
+    struct ops_fib_node **link;
+    struct ops_fib_node *child, *parent;
+
+    node->is_route = false;
+    node->installed = false;
+    list_remove(&node->recheck_node);
+    list_init(&node->recheck_node);
+    while (node && !node->is_route && !(node->child[0] && node->child[1])) {
+        child = node->child[0] ? node->child[0] : node->child[1];
+        parent = node->parent;
+        link = parent ? &parent->child[parent->child[1] == node]
+                      : &rtable->fib[node->is_ipv6];
+        *link = child;
+        if (child) {
+            child->parent = parent;
+        }
+        list_remove(&node->recheck_node);
+        ops_slab_free(&ops_fib_slab, node);
+        /* the parent keeps as many children if one moved up */
+        node = child ? NULL : parent;
+    }
+} /* ops_fib_remove */
 
-    /* Create Host Entry */
-    opennsl_l3_host_t_init(&l3host);
-    if( is_ipv6_addr ) {
-        flags |= OPENNSL_L3_IP6;
-
-        /* convert string ip into host format */
-        rc = inet_pton(AF_INET6, ip_addr, ipv6_dest_addr);
-        if ( rc != 1 ) {
-            VLOG_ERR("Failed to create L3 host entry. Invalid ipv6 address %s", ip_addr);
-            return 1; /* Return error */
-        }
-
-        memcpy(l3host.l3a_ip6_addr, ipv6_dest_addr, sizeof(struct in6_addr));
-    } else {
-        /* convert string ip into host format */
-        ipv4_dest_addr = inet_network(ip_addr);
-        if ( ipv4_dest_addr == -1 ) {
-            VLOG_ERR("Failed to create L3 host entry. Invalid ipv4 address %s", ip_addr);
-            return 1; /* Return error */
-        }
-
-        VLOG_DBG("ipv4 addr converted = 0x%x", ipv4_dest_addr);
-        l3host.l3a_ip_addr = ipv4_dest_addr;
+static void
+ops_fib_free(struct ops_fib_node *node)
+{
+    if (!node) {
+        return;
     }
+    ops_fib_free(node->child[0]);
+    ops_fib_free(node->child[1]);
+    ops_slab_free(&ops_fib_slab, node);
+} /* ops_fib_free */
+
+/* Closest route covering a node */
+static struct ops_fib_node *
+ops_fib_cover(const struct ops_fib_node *node)
+{
+    struct ops_fib_node *cover;
 
-    l3host.l3a_intf = *l3_egress_id;
-    l3host.l3a_vrf = vrf_id;
-    l3host.l3a_flags = flags;
-    rc = opennsl_l3_host_add(hw_unit, &l3host);
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR ("opennsl_l3_host_add failed: rc=%s", opennsl_errmsg(rc));
-        return rc;
+    for (cover = node->parent; cover && !cover->is_route;
+         cover = cover->parent) {
+        continue;
     }
+    return cover;
+} /* ops_fib_cover */
 
-    return rc;
-} /* ops_routing_add_host_entry */
+static void
+ops_fib_update_init(struct ops_fib_update *update,
+                    struct ops_route_table *rtable,
+                    const struct ops_fib_node *cover)
+{
+    update->rtable = rtable;
+    update->covered = (cover != NULL);
+    update->intf = cover ? cover->intf : 0;
+    update->multipath = cover ? cover->multipath : false;
+} /* ops_fib_update_init */
+
+/* True if a node is forwarded by its cover as by its own route */
+static bool
+ops_fib_redundant(const struct ops_fib_node *node,
+                  const struct ops_fib_update *update)
+{
+    return update->covered && (node->intf == update->intf) &&
+           (node->multipath == update->multipath);
+} /* ops_fib_redundant */
 
-/* Function to delete l3 host entry via ofproto */
-int
-ops_routing_delete_host_entry(int hw_unit, opennsl_port_t hw_port,
-                              opennsl_vrf_t vrf_id, bool is_ipv6_addr,
-                              char *ip_addr, opennsl_if_t *l3_egress_id)
+/* Add, replace or delete the lpm entry of a node */
+static int
+ops_fib_program(struct ops_route_table *rtable, struct ops_fib_node *node,
+                bool install)
 {
-    opennsl_error_t rc = OPENNSL_E_NONE;
-    opennsl_l3_host_t l3host;
-    in_addr_t ipv4_dest_addr;
-    char ipv6_dest_addr[sizeof(struct in6_addr)];
-    int flags = 0;
+    struct ops_route_key key;
+    opennsl_l3_route_t route;
+    int rc;
 
+    memset(&key, 0, sizeof(key));
+    key.vrf = rtable->vrf;
+    key.is_ipv6 = node->is_ipv6;
+    key.prefixlen = node->prefixlen;
+    memcpy(key.prefix, node->prefix, sizeof(key.prefix));
 
-    /* Delete an IP route / Host Entry */
-    VLOG_DBG("In ops_routing_delete_host_entry for ip %s", ip_addr);
-    opennsl_l3_host_t_init(&l3host);
-    if( is_ipv6_addr ) {
-        VLOG_DBG("ipv6 addr type");
-        flags |= OPENNSL_L3_IP6;
+    opennsl_l3_route_t_init(&route);
+    ops_route_key_to_l3_route(&key, &route);
+    route.l3a_intf = node->intf;
+    if (node->multipath) {
+        route.l3a_flags |= OPENNSL_L3_MULTIPATH;
+    }
 
-        /* convert string ip into host format */
-        rc = inet_pton(AF_INET6, ip_addr, ipv6_dest_addr);
-        if ( rc != 1 ) {
-            VLOG_ERR("invalid ipv6-%s", ip_addr);
-            return 1; /* Return error */
+    if (install) {
+        if (node->installed) {
+            route.l3a_flags |= OPENNSL_L3_REPLACE;
+        }
+        rc = ops_route_lpm_add(rtable->hw_unit, &route);
+        if (OPENNSL_SUCCESS(rc)) {
+            node->installed = true;
         }
-
-        memcpy(l3host.l3a_ip6_addr, ipv6_dest_addr, sizeof(struct in6_addr));
     } else {
-        /* convert string ip into host format */
-        ipv4_dest_addr = inet_network(ip_addr);
-        if ( ipv4_dest_addr == -1 ) {
-            VLOG_ERR("Invalid ip-%s", ip_addr);
-            return 1; /* Return error */
+        if (!node->installed) {
+            return OPENNSL_E_NONE;
+        }
+        rc = ops_route_lpm_delete(rtable->hw_unit, &route);
+        if (OPENNSL_SUCCESS(rc) || (rc == OPENNSL_E_NOT_FOUND)) {
+            node->installed = false;
+            rc = OPENNSL_E_NONE;
         }
-
-        VLOG_DBG("ipv4 addr converted =0x%x", ipv4_dest_addr);
-        l3host.l3a_ip_addr = ipv4_dest_addr;
-    }
-
-    l3host.l3a_intf = *l3_egress_id;
-    l3host.l3a_vrf = vrf_id;
-    l3host.l3a_flags = flags;
-    rc = opennsl_l3_host_delete(hw_unit, &l3host);
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR ("opennsl_l3_host_delete failed: %s", opennsl_errmsg(rc));
-        return rc;
-    }
-
-    /* Delete the egress object */
-    VLOG_DBG("Deleting egress object for egress-id %d", *l3_egress_id);
-    rc = opennsl_l3_egress_destroy(hw_unit, *l3_egress_id);
-    if (OPENNSL_FAILURE(rc)) {
-       VLOG_ERR ("opennsl_egress_destroy failed: %s", opennsl_errmsg(rc));
-        return rc;
     }
-
-    *l3_egress_id = -1;
     return rc;
-} /* ops_routing_delete_host_entry */
+} /* ops_fib_program */
 
-/* Ft to read and reset the host hit-bit */
-int
-ops_routing_get_host_hit(int hw_unit, opennsl_vrf_t vrf_id,
-                         bool is_ipv6_addr, char *ip_addr, bool *hit_bit)
+/* Call 'cb' on the routes a node covers directly */
+static int
+ops_fib_walk_children(struct ops_fib_node *node,
+                      int (*cb)(struct ops_fib_node *,
+                                struct ops_fib_update *),
+                      struct ops_fib_update *update)
 {
-    opennsl_error_t rc = OPENNSL_E_NONE;
-    opennsl_l3_host_t l3host;
-    in_addr_t ipv4_dest_addr;
-    char ipv6_dest_addr[sizeof(struct in6_addr)];
-    int flags = 0;
-
-    VLOG_DBG("In ops_routing_get_host_hit for ip %s", ip_addr);
-    opennsl_l3_host_t_init(&l3host);
-    if( is_ipv6_addr ) {
-        VLOG_DBG("ipv6 addr type");
-        flags |= OPENNSL_L3_IP6;
+    struct ops_fib_node *child;
+    int rc;
+    int i;
 
-        /* convert string ip into host format */
-        rc = inet_pton(AF_INET6, ip_addr, ipv6_dest_addr);
-        if ( rc != 1 ) {
-            VLOG_ERR("invalid ipv6-%s", ip_addr);
-            return 1;
+    for (i = 0; i < 2; i++) {
+        child = node->child[i];
+        if (!child) {
+            continue;
         }
-
-        memcpy(l3host.l3a_ip6_addr, ipv6_dest_addr, sizeof(struct in6_addr));
-    } else {
-        /* convert string ip into host format */
-        ipv4_dest_addr = inet_network(ip_addr);
-        if ( ipv4_dest_addr == -1 ) {
-            VLOG_ERR("Invalid ip-%s", ip_addr);
-            return 1;
+        rc = child->is_route ? cb(child, update)
+                             : ops_fib_walk_children(child, cb, update);
+        if (rc) {
+            return rc;
         }
-
-        VLOG_DBG("ipv4 addr converted =0x%x", ipv4_dest_addr);
-        l3host.l3a_ip_addr = ipv4_dest_addr;
     }
+    return 0;
+} /* ops_fib_walk_children */
 
-    /* Get Host Entry */
-    l3host.l3a_vrf = vrf_id;
-    l3host.l3a_flags = flags;
-    rc = opennsl_l3_host_find(hw_unit, &l3host);
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR ("opennsl_l3_host_find failed: %s", opennsl_errmsg(rc));
-        return rc;
-    } else {
-        *hit_bit = (l3host.l3a_flags & OPENNSL_L3_HIT);
-        VLOG_DBG("Got the hit-bit =0x%x", *hit_bit);
-        if(*hit_bit) {
-            l3host.l3a_flags = flags | OPENNSL_L3_HIT_CLEAR;
-            /* Reset the hit-bit */
-            rc = opennsl_l3_host_find(hw_unit, &l3host);
-            if (OPENNSL_FAILURE(rc)) {
-                VLOG_ERR ("Reset hit-bit failed: %s", opennsl_errmsg(rc));
-                return rc;
-            }
-        }
+/* Program a route the lpm would no longer forward like the route table */
+static int
+ops_fib_expand_cb(struct ops_fib_node *node, struct ops_fib_update *update)
+{
+    if (node->installed || ops_fib_redundant(node, update)) {
+        return 0;
     }
+    return ops_fib_program(update->rtable, node, true);
+} /* ops_fib_expand_cb */
 
-    return rc;
-} /* ops_routing_get_host_hit */
+/* Queue a programmed route which may have become redundant */
+static int
+ops_fib_queue_cb(struct ops_fib_node *node, struct ops_fib_update *update)
+{
+    if (node->installed && ops_fib_redundant(node, update) &&
+        list_is_empty(&node->recheck_node)) {
+        list_push_back(&update->rtable->fib_recheck, &node->recheck_node);
+    }
+    return 0;
+} /* ops_fib_queue_cb */
 
-/* Convert from string to ipv4/ipv6 prefix */
+/* Add or update the route of a compressed vrf */
 static int
-ops_string_to_prefix(int family, char *ip_address, void *prefix,
-                     unsigned char *prefixlen)
+ops_fib_route_set(struct ops_route_table *rtable, struct ops_route *ops_routep,
+                  const opennsl_l3_route_t *route)
 {
-    char *p;
-    char *tmp_ip_addr;
-    int maxlen = (family == AF_INET) ? IPV4_PREFIX_LEN :
-                                       IPV6_PREFIX_LEN;
-    *prefixlen = maxlen;
-    tmp_ip_addr = strdup(ip_address);
+    struct ops_fib_update update;
+    struct ops_fib_node *node, *cover;
+    opennsl_if_t old_intf;
+    bool old_multipath;
+    bool added = false;
+    int rc;
 
-    if ((p = strchr(tmp_ip_addr, '/'))) {
-        *p++ = '\0';
-        *prefixlen = atoi(p);
+    node = ops_routep->fib_node;
+    if (!node) {
+        node = ops_fib_insert(rtable, &ops_routep->key);
+        node->is_route = true;
+        ops_routep->fib_node = node;
+        added = true;
     }
 
-    if (*prefixlen > maxlen) {
-        VLOG_DBG("Bad prefixlen %d > %d", *prefixlen, maxlen);
-        free(tmp_ip_addr);
-        return EINVAL;
+    /* the routes below now fall back to this one */
+    update.rtable = rtable;
+    update.covered = true;
+    update.intf = route->l3a_intf;
+    update.multipath = !!(route->l3a_flags & OPENNSL_L3_MULTIPATH);
+    rc = ops_fib_walk_children(node, ops_fib_expand_cb, &update);
+    if (rc) {
+        goto error;
     }
 
-    if (family == AF_INET) {
-        /* ipv4 address in host order */
-        in_addr_t *addr = (in_addr_t*)prefix;
-        *addr = inet_network(tmp_ip_addr);
-        if (*addr == -1) {
-            VLOG_ERR("Invalid ip address %s", ip_address);
-            free(tmp_ip_addr);
-            return EINVAL;
+    old_intf = node->intf;
+    old_multipath = node->multipath;
+    node->intf = update.intf;
+    node->multipath = update.multipath;
+
+    cover = ops_fib_cover(node);
+    ops_fib_update_init(&update, rtable, cover);
+    if (!ops_fib_redundant(node, &update)) {
+        rc = ops_fib_program(rtable, node, true);
+    } else if (!node->installed) {
+        /* the cover already forwards it */
+        rc = 0;
+    } else if ((node->intf == old_intf) &&
+               (node->multipath == old_multipath)) {
+        /* its lpm entry still forwards right, delete it later */
+        rc = 0;
+        if (list_is_empty(&node->recheck_node)) {
+            list_push_back(&rtable->fib_recheck, &node->recheck_node);
         }
     } else {
-        /* ipv6 address */
-        if (inet_pton(family, tmp_ip_addr, prefix) == 0) {
-            VLOG_DBG("%d inet_pton failed with %s", family, strerror(errno));
-            free(tmp_ip_addr);
-            return EINVAL;
-        }
+        /* its lpm entry forwards to the old egress */
+        rc = ops_fib_program(rtable, node, false);
+    }
+    if (rc) {
+        node->intf = old_intf;
+        node->multipath = old_multipath;
+        goto error;
     }
 
-    free(tmp_ip_addr);
+    ops_fib_update_init(&update, rtable, node);
+    ops_fib_walk_children(node, ops_fib_queue_cb, &update);
     return 0;
-} /* ops_string_to_prefix */
 
-/* Find or create and ecmp egress object */
+error:
+    if (added) {
+        /* children programmed on the way are redundant again */
+        ops_fib_update_init(&update, rtable, ops_fib_cover(node));
+        ops_fib_walk_children(node, ops_fib_queue_cb, &update);
+        ops_fib_remove(rtable, node);
+        ops_routep->fib_node = NULL;
+    }
+    return rc;
+} /* ops_fib_route_set */
+
+/* Delete the route of a compressed vrf. The route leaves the trie even
+ * if the asic could not be updated, as it leaves the route table. */
 static int
-ops_create_or_update_ecmp_object(int hw_unit, struct ops_route *routep,
-                                 opennsl_if_t *ecmp_intfp, bool update)
+ops_fib_route_unset(struct ops_route_table *rtable,
+                    struct ops_route *ops_routep)
 {
-    int nh_count = 0;
-    struct ops_nexthop *nh;
-    opennsl_if_t egress_obj[MAX_NEXTHOPS_PER_ROUTE];
-    opennsl_error_t rc = OPENNSL_E_NONE;
-    opennsl_l3_egress_ecmp_t ecmp_grp;
+    struct ops_fib_node *node = ops_routep->fib_node;
+    struct ops_fib_update update;
+    int rc, rc2;
 
-    if(!routep) {
-        return EINVAL;
+    /* the routes below now fall back to the cover of this one */
+    ops_fib_update_init(&update, rtable, ops_fib_cover(node));
+    rc = ops_fib_walk_children(node, ops_fib_expand_cb, &update);
+
+    if (node->installed) {
+        rc2 = ops_fib_program(rtable, node, false);
+        rc = rc ? rc : rc2;
     }
 
-    HMAP_FOR_EACH(nh, node, &routep->nexthops) {
-        egress_obj[nh_count++] = nh->l3_egress_id;
-        /* break once max ecmp is reached */
-        if (nh_count == MAX_NEXTHOPS_PER_ROUTE) {
-            break;
+    ops_fib_walk_children(node, ops_fib_queue_cb, &update);
+    ops_fib_remove(rtable, node);
+    ops_routep->fib_node = NULL;
+    return rc;
+} /* ops_fib_route_unset */
+
+/* Delete from the lpm up to 'budget' queued routes found redundant */
+static void
+ops_fib_recheck(struct ops_route_table *rtable, int *budget)
+{
+    struct ops_fib_update update;
+    struct ops_fib_node *node;
+
+    while ((*budget > 0) && !list_is_empty(&rtable->fib_recheck)) {
+        node = CONTAINER_OF(list_pop_front(&rtable->fib_recheck),
+                            struct ops_fib_node, recheck_node);
+        list_init(&node->recheck_node);
+        (*budget)--;
+
+        ops_fib_update_init(&update, rtable, ops_fib_cover(node));
+        if (node->installed && ops_fib_redundant(node, &update)) {
+            ops_fib_program(rtable, node, false);
         }
     }
+} /* ops_fib_recheck */
 
-    if (update){
-        opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
-        ecmp_grp.flags = (OPENNSL_L3_REPLACE | OPENNSL_L3_WITH_ID);
-        ecmp_grp.ecmp_intf = *ecmp_intfp;
-        rc = opennsl_l3_egress_ecmp_create(hw_unit, &ecmp_grp, nh_count,
-                                           egress_obj);
-        if (OPENNSL_FAILURE(rc)) {
-            VLOG_ERR("Failed to update ecmp object for route %s: rc=%s",
-                     routep->prefix, opennsl_errmsg(rc));
+/* Queue every programmed route below a node for a redundancy check */
+static void
+ops_fib_queue_all(struct ops_route_table *rtable, struct ops_fib_node *node)
+{
+    if (!node) {
+        return;
+    }
+    if (node->installed && list_is_empty(&node->recheck_node)) {
+        list_push_back(&rtable->fib_recheck, &node->recheck_node);
+    }
+    ops_fib_queue_all(rtable, node->child[0]);
+    ops_fib_queue_all(rtable, node->child[1]);
+} /* ops_fib_queue_all */
+
+/* Add or replace a route in the asic. A new route placed in the host
+ * table falls back to the lpm when its hash bucket is full, or when a
+ * neighbor already holds the entry. */
+static int
+ops_route_hw_add(int hw_unit, struct ops_route *ops_routep,
+                 opennsl_l3_route_t *route)
+{
+    struct ops_route_table *rtable;
+    opennsl_l3_host_t l3host;
+    int rc;
+
+    if (ops_routep->in_host_table) {
+        ops_l3_route_to_l3_host(route, &l3host);
+        rc = opennsl_l3_host_add(hw_unit, &l3host);
+        if (OPENNSL_SUCCESS(rc)) {
+            if (!(route->l3a_flags & OPENNSL_L3_REPLACE)) {
+                ops_route_table_update(hw_unit, route, true, 1);
+            }
             return rc;
         }
-    } else {
-        opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
-        rc = opennsl_l3_egress_ecmp_create(hw_unit, &ecmp_grp, nh_count,
-                                           egress_obj);
-        if (OPENNSL_FAILURE(rc)) {
-            VLOG_ERR("Failed to create ecmp object for route %s: rc=%s",
-                     routep->prefix, opennsl_errmsg(rc));
+        if ((route->l3a_flags & OPENNSL_L3_REPLACE) ||
+            ((rc != OPENNSL_E_FULL) && (rc != OPENNSL_E_EXISTS))) {
             return rc;
         }
-        *ecmp_intfp = ecmp_grp.ecmp_intf;
+        ops_routep->in_host_table = false;
     }
-    return rc;
-} /* ops_create_or_update_ecmp_object */
 
-/* Delete ecmp object */
+    rtable = ops_route_table_lookup(ops_routep->key.vrf);
+    if (rtable && rtable->compress) {
+        return ops_fib_route_set(rtable, ops_routep, route);
+    }
+
+    return ops_route_lpm_add(hw_unit, route);
+} /* ops_route_hw_add */
+
+/* Delete a route from the table of the asic it is programmed in */
 static int
-ops_delete_ecmp_object(int hw_unit, opennsl_if_t ecmp_intf)
+ops_route_hw_delete(int hw_unit, struct ops_route *ops_routep,
+                    opennsl_l3_route_t *route)
 {
-    opennsl_error_t rc = OPENNSL_E_NONE;
-    opennsl_l3_egress_ecmp_t ecmp_grp;
-
-    opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
-    ecmp_grp.ecmp_intf = ecmp_intf;
+    opennsl_l3_host_t l3host;
+    int rc;
 
-    rc = opennsl_l3_egress_ecmp_destroy(hw_unit, &ecmp_grp);
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Failed to delete ecmp egress object %d: %s",
-                  ecmp_intf, opennsl_errmsg(rc));
+    if (ops_routep->in_host_table) {
+        ops_l3_route_to_l3_host(route, &l3host);
+        rc = opennsl_l3_host_delete(hw_unit, &l3host);
+        if (OPENNSL_SUCCESS(rc)) {
+            ops_route_table_update(hw_unit, route, true, -1);
+        }
         return rc;
     }
-    return rc;
-} /* ops_delete_ecmp_object */
 
-/* add or update ECMP or non-ECMP route */
+    if (ops_routep->fib_node) {
+        return ops_fib_route_unset(
+                        ops_route_table_lookup(ops_routep->key.vrf),
+                        ops_routep);
+    }
+
+    return ops_route_lpm_delete(hw_unit, route);
+} /* ops_route_hw_delete */
+
+/* Read back a route from the table of the asic it is programmed in. Only
+ * the egress object and the multipath flag are filled. */
 static int
-ops_add_route_entry(int hw_unit, opennsl_vrf_t vrf_id,
-                    struct ofproto_route *of_routep,
-                    opennsl_l3_route_t *routep)
+ops_route_hw_get(int hw_unit, struct ops_route *ops_routep,
+                 opennsl_l3_route_t *route)
 {
-    struct ops_route *ops_routep;
-    struct ops_nexthop *ops_nh;
-    opennsl_if_t l3_intf;
+    opennsl_l3_host_t l3host;
     int rc;
-    bool add_route = false;
 
-    /* assert for zero nexthop */
-    assert(of_routep && (of_routep->n_nexthops > 0));
+    opennsl_l3_route_t_init(route);
+    ops_route_key_to_l3_route(&ops_routep->key, route);
 
-    /* look for prefix in LPM table*/
-    rc = opennsl_l3_route_get(hw_unit, routep);
+    if (!ops_routep->in_host_table) {
+        ops_hw_queue_sync(ops_hw_obj_route(route));
+        return opennsl_l3_route_get(hw_unit, route);
+    }
+
+    ops_l3_route_to_l3_host(route, &l3host);
+    rc = opennsl_l3_host_find(hw_unit, &l3host);
+    if (OPENNSL_SUCCESS(rc)) {
+        route->l3a_intf = l3host.l3a_intf;
+        route->l3a_flags |= (l3host.l3a_flags & OPENNSL_L3_MULTIPATH);
+    }
+    return rc;
+} /* ops_route_hw_get */
+
+void
+ops_routing_host_routes_set(bool enable)
+{
+    ops_host_routes = enable;
+} /* ops_routing_host_routes_set */
+
+bool
+ops_routing_host_routes_get(void)
+{
+    return ops_host_routes;
+} /* ops_routing_host_routes_get */
+
+/* Find a nexthop of a vrf */
+static struct ops_vrf_nexthop *
+ops_vrf_nexthop_lookup(int vrf, const char *id)
+{
+    struct ops_vrf_nexthop *vrf_nh;
+
+    HMAP_FOR_EACH_WITH_HASH(vrf_nh, node, hash_string(id, vrf),
+                            &ops_nexthop_table) {
+        if ((vrf_nh->vrf == vrf) && (strcmp(vrf_nh->id, id) == 0)) {
+            return vrf_nh;
+        }
+    }
+    return NULL;
+} /* ops_vrf_nexthop_lookup */
+
+/* Find the weight registry entry of a nexthop */
+static struct ops_nexthop_weight *
+ops_nexthop_weight_lookup(int vrf, const char *id)
+{
+    struct ops_nexthop_weight *nh_weight;
+
+    HMAP_FOR_EACH_WITH_HASH(nh_weight, node, hash_string(id, vrf),
+                            &ops_nexthop_weights) {
+        if ((nh_weight->vrf == vrf) && (strcmp(nh_weight->id, id) == 0)) {
+            return nh_weight;
+        }
+    }
+    return NULL;
+} /* ops_nexthop_weight_lookup */
+
+/* Get the weight of a nexthop */
+static int
+ops_nexthop_weight_get(int vrf, const char *id)
+{
+    struct ops_nexthop_weight *nh_weight;
+
+    if (hmap_is_empty(&ops_nexthop_weights)) {
+        return 1;
+    }
+    nh_weight = ops_nexthop_weight_lookup(vrf, id);
+    return nh_weight ? nh_weight->weight : 1;
+} /* ops_nexthop_weight_get */
+
+/* Link a route nexthop to the nexthop of its vrf, creating it if needed */
+static void
+ops_vrf_nexthop_ref(struct ops_nexthop *nh, int vrf, const char *id)
+{
+    struct ops_vrf_nexthop *vrf_nh;
+
+    vrf_nh = ops_vrf_nexthop_lookup(vrf, id);
+    if (!vrf_nh) {
+        vrf_nh = xzalloc(sizeof(*vrf_nh));
+        vrf_nh->vrf = vrf;
+        vrf_nh->id = xstrdup(id);
+        list_init(&vrf_nh->nexthops);
+        hmap_insert(&ops_nexthop_table, &vrf_nh->node, hash_string(id, vrf));
+    }
+
+    nh->vrf_nh = vrf_nh;
+    nh->id = vrf_nh->id;
+    list_push_back(&vrf_nh->nexthops, &nh->vrf_nh_node);
+} /* ops_vrf_nexthop_ref */
+
+/* Unlink a route nexthop, the vrf nexthop goes with its last route */
+static void
+ops_vrf_nexthop_unref(struct ops_nexthop *nh)
+{
+    struct ops_vrf_nexthop *vrf_nh = nh->vrf_nh;
+
+    if (!vrf_nh) {
+        return;
+    }
+
+    list_remove(&nh->vrf_nh_node);
+    nh->vrf_nh = NULL;
+    nh->id = NULL;
+
+    if (list_is_empty(&vrf_nh->nexthops)) {
+        hmap_remove(&ops_nexthop_table, &vrf_nh->node);
+        free(vrf_nh->id);
+        free(vrf_nh);
+    }
+} /* ops_vrf_nexthop_unref */
+
+/* Point a route nexthop to an egress object, moving its reference */
+static void
+ops_nexthop_egress_id_set(struct ops_nexthop *nh, opennsl_if_t l3_egress_id)
+{
+    if (nh->l3_egress_id != l3_egress_id) {
+        ops_egress_ref(l3_egress_id);
+        ops_egress_unref(nh->l3_egress_id);
+        nh->l3_egress_id = l3_egress_id;
+    }
+} /* ops_nexthop_egress_id_set */
+
+/* Add nexthop into the route entry */
+static void
+ops_nexthop_add(struct ops_route *route,  struct ofproto_route_nexthop *of_nh)
+{
+    char *hashstr;
+    struct ops_nexthop *nh;
+
+    if (!route || !of_nh) {
+        return;
+    }
+
+    /* the first nexthop is stored in the route */
+    if (!route->nh_inline.route) {
+        nh = &route->nh_inline;
+    } else {
+        nh = ops_slab_alloc(&ops_nexthop_slab);
+    }
+    nh->type = of_nh->type;
+    nh->route = route;
+    /* NOTE: Either IP or Port, not both */
+    if (of_nh->id) {
+        ops_vrf_nexthop_ref(nh, route->key.vrf, of_nh->id);
+    }
+
+    ops_nexthop_egress_id_set(nh, (of_nh->state == OFPROTO_NH_RESOLVED) ?
+                                  of_nh->l3_egress_id : local_nhid);
+
+    hashstr = of_nh->id;
+    hmap_insert(&route->nexthops, &nh->node, hash_string(hashstr, 0));
+    route->n_nexthops++;
+
+    if (VLOG_IS_DBG_ENABLED()) {
+        char buf[IPV6_BUFFER_LEN];
+
+        VLOG_DBG("Add NH %s, egress_id %d, for route %s", nh->id,
+                 nh->l3_egress_id,
+                 ops_route_key_to_string(&route->key, buf, sizeof(buf)));
+    }
+} /* ops_nexthop_add */
+
+/* Delete nexthop into route entry */
+static void
+ops_nexthop_delete(struct ops_route *route, struct ops_nexthop *nh)
+{
+    if (!route || !nh) {
+        return;
+    }
+
+    if (VLOG_IS_DBG_ENABLED()) {
+        char buf[IPV6_BUFFER_LEN];
+
+        VLOG_DBG("Delete NH %s in route %s", nh->id,
+                 ops_route_key_to_string(&route->key, buf, sizeof(buf)));
+    }
+
+    hmap_remove(&route->nexthops, &nh->node);
+    ops_vrf_nexthop_unref(nh);
+    ops_egress_unref(nh->l3_egress_id);
+    if (nh == &route->nh_inline) {
+        memset(nh, 0, sizeof(*nh));
+    } else {
+        ops_slab_free(&ops_nexthop_slab, nh);
+    }
+    route->n_nexthops--;
+} /* ops_nexthop_delete */
+
+/* Find nexthop entry in the route's nexthops hash */
+static struct ops_nexthop*
+ops_nexthop_lookup(struct ops_route *route, struct ofproto_route_nexthop *of_nh)
+{
+    char *hashstr;
+    struct ops_nexthop *nh;
+
+    hashstr = of_nh->id;
+    HMAP_FOR_EACH_WITH_HASH(nh, node, hash_string(hashstr, 0),
+                            &route->nexthops) {
+        if ((strcmp(nh->id, of_nh->id) == 0)){
+            return nh;
+        }
+    }
+    return NULL;
+} /* ops_nexthop_lookup */
+
+/* Create route hash */
+static uint32_t
+ops_route_hash(const struct ops_route_key *key)
+{
+    return hash_words((const uint32_t *) key,
+                      sizeof(*key) / sizeof(uint32_t), 0);
+} /* ops_route_hash */
+
+/* Find the route table of a vrf */
+static struct ops_route_table *
+ops_route_table_lookup(opennsl_vrf_t vrf)
+{
+    struct ops_route_table *rtable;
+
+    HMAP_FOR_EACH_WITH_HASH(rtable, node, hash_int(vrf, 0),
+                            &ops_route_tables) {
+        if (rtable->vrf == vrf) {
+            return rtable;
+        }
+    }
+    return NULL;
+} /* ops_route_table_lookup */
+
+/* Find a route entry matching the key */
+static struct ops_route *
+ops_route_lookup(const struct ops_route_key *key)
+{
+    struct ops_route_table *rtable;
+    struct ops_route *route;
+
+    rtable = ops_route_table_lookup(key->vrf);
+    if (!rtable) {
+        return NULL;
+    }
+
+    HMAP_FOR_EACH_WITH_HASH(route, node, ops_route_hash(key),
+                            &rtable->routes) {
+        if (memcmp(&route->key, key, sizeof(*key)) == 0) {
+            return route;
+        }
+    }
+    return NULL;
+} /* ops_route_lookup */
+
+/* Build the stale table key of a host entry */
+static void
+ops_host_key_from_l3_host(const opennsl_l3_host_t *l3host,
+                          struct ops_route_key *key)
+{
+    memset(key, 0, sizeof(*key));
+    key->vrf = l3host->l3a_vrf;
+    if (l3host->l3a_flags & OPENNSL_L3_IP6) {
+        key->is_ipv6 = 1;
+        key->prefixlen = 128;
+        memcpy(key->prefix, l3host->l3a_ip6_addr, sizeof(struct in6_addr));
+    } else {
+        key->prefixlen = 32;
+        memcpy(key->prefix, &l3host->l3a_ip_addr,
+               sizeof(l3host->l3a_ip_addr));
+    }
+} /* ops_host_key_from_l3_host */
+
+/* Find an entry of the previous run not claimed yet */
+static struct ops_stale_entry *
+ops_stale_lookup(struct hmap *table, const struct ops_route_key *key)
+{
+    struct ops_stale_entry *entry;
+
+    if (!reconcile_active) {
+        return NULL;
+    }
+
+    HMAP_FOR_EACH_WITH_HASH(entry, node, ops_route_hash(key), table) {
+        if (memcmp(&entry->key, key, sizeof(*key)) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+} /* ops_stale_lookup */
+
+/* Find the host entry of the previous run at the address of a host */
+static struct ops_stale_entry *
+ops_stale_host_lookup(const opennsl_l3_host_t *l3host)
+{
+    struct ops_route_key key;
+
+    if (!reconcile_active) {
+        return NULL;
+    }
+
+    ops_host_key_from_l3_host(l3host, &key);
+    return ops_stale_lookup(&ops_stale_hosts, &key);
+} /* ops_stale_host_lookup */
+
+/* An entry of the previous run was reprogrammed by the configuration
+ * replay, it is kept in the asic */
+static void
+ops_stale_claim(struct hmap *table, struct ops_stale_entry *entry)
+{
+    hmap_remove(table, &entry->node);
+    free(entry);
+    reconcile_claimed++;
+    reconcile_last_claim = time_msec();
+} /* ops_stale_claim */
+
+/* Add new route and NHs */
+static struct ops_route*
+ops_route_add(const struct ops_route_key *key,
+              struct ofproto_route *of_routep)
+{
+    int i;
+    struct ops_route_table *rtable;
+    struct ops_route *routep;
+    struct ofproto_route_nexthop *of_nh;
+
+    if (!of_routep) {
+        return NULL;
+    }
+
+    /* vrfs not created through the provider get their table on demand */
+    rtable = ops_route_table_lookup(key->vrf);
+    if (!rtable) {
+        rtable = ops_routing_route_table_create(0, key->vrf);
+    }
+
+    routep = ops_slab_alloc(&ops_route_slab);
+    routep->key = *key;
+    routep->n_nexthops = 0;
+    routep->in_host_table = ops_host_routes && ops_route_key_is_host(key);
+
+    hmap_init(&routep->nexthops);
+
+    for (i = 0; i < of_routep->n_nexthops; i++) {
+        of_nh = &of_routep->nexthops[i];
+        ops_nexthop_add(routep, of_nh);
+    }
+
+    hmap_insert(&rtable->routes, &routep->node, ops_route_hash(key));
+    VLOG_DBG("Add route %s", of_routep->prefix);
+    return routep;
+} /* ops_route_add */
+
+/* Saved egress id of a nexthop added by a route update */
+#define OPS_NH_NEW  (-1)
+
+/* Update route nexthop: add, delete, resolve and unresolve nh */
+static void
+ops_route_update(int vrf, struct ops_route *routep,
+                 struct ofproto_route *of_routep,
+                 bool is_delete_nh)
+{
+    struct ops_nexthop* nh;
+    struct ofproto_route_nexthop *of_nh;
+    int i;
+
+    for (i = 0; i < of_routep->n_nexthops; i++) {
+        of_nh = &of_routep->nexthops[i];
+        nh = ops_nexthop_lookup(routep, of_nh);
+        if (is_delete_nh) {
+            ops_nexthop_delete(routep, nh);
+        } else {
+            /* add or update */
+            if (!nh) {
+                ops_nexthop_add(routep, of_nh);
+            } else {
+                /* update is currently resolved on unreoslved */
+                ops_nexthop_egress_id_set(nh,
+                                (of_nh->state == OFPROTO_NH_RESOLVED) ?
+                                of_nh->l3_egress_id : local_nhid);
+            }
+        }
+    }
+} /* ops_route_update */
+
+/* Save the egress ids of the nexthops a route update is going to change,
+ * OPS_NH_NEW for the ones it adds, so that the update can be undone */
+static void
+ops_route_update_save(struct ops_route *routep,
+                      struct ofproto_route *of_routep,
+                      opennsl_if_t *old_ids)
+{
+    struct ops_nexthop *nh;
+    int i;
+
+    for (i = 0; i < of_routep->n_nexthops; i++) {
+        nh = ops_nexthop_lookup(routep, &of_routep->nexthops[i]);
+        old_ids[i] = nh ? nh->l3_egress_id : OPS_NH_NEW;
+    }
+} /* ops_route_update_save */
+
+/* Undo a route update the asic did not take, so that the route keeps the
+ * nexthops programmed in the asic */
+static void
+ops_route_update_undo(struct ops_route *routep,
+                      struct ofproto_route *of_routep,
+                      const opennsl_if_t *old_ids)
+{
+    struct ops_nexthop *nh;
+    int i;
+
+    for (i = 0; i < of_routep->n_nexthops; i++) {
+        nh = ops_nexthop_lookup(routep, &of_routep->nexthops[i]);
+        if (!nh) {
+            continue;
+        }
+        if (old_ids[i] == OPS_NH_NEW) {
+            ops_nexthop_delete(routep, nh);
+        } else {
+            ops_nexthop_egress_id_set(nh, old_ids[i]);
+        }
+    }
+} /* ops_route_update_undo */
+
+/* Free a route removed from its table, and its nexthops */
+static void
+ops_route_free(struct ops_route *routep)
+{
+    struct ops_nexthop *nh, *next;
+
+    HMAP_FOR_EACH_SAFE(nh, next, node, &routep->nexthops) {
+        ops_nexthop_delete(routep, nh);
+    }
+
+    hmap_destroy(&routep->nexthops);
+    ops_slab_free(&ops_route_slab, routep);
+} /* ops_route_free */
+
+/* Delete route in system*/
+static void
+ops_route_delete(struct ops_route *routep)
+{
+    struct ops_route_table *rtable;
+
+    if (!routep) {
+        return;
+    }
+
+    rtable = ops_route_table_lookup(routep->key.vrf);
+    hmap_remove(&rtable->routes, &routep->node);
+    ops_route_free(routep);
+} /* ops_route_delete */
+
+/* Move the host route holding the host entry of a neighbor or of a
+ * local address to the lpm, so that the host entry can be added. Returns
+ * true if the entry was freed. */
+static bool
+ops_host_route_evict(int hw_unit, const opennsl_l3_host_t *l3host)
+{
+    struct ops_route *ops_routep;
+    struct ops_route_key key;
+    opennsl_l3_route_t route;
+    opennsl_l3_host_t route_host;
+    char buf[IPV6_BUFFER_LEN];
+    int rc;
+
+    opennsl_l3_route_t_init(&route);
+    route.l3a_vrf = l3host->l3a_vrf;
+    if (l3host->l3a_flags & OPENNSL_L3_IP6) {
+        route.l3a_flags |= OPENNSL_L3_IP6;
+        memcpy(route.l3a_ip6_net, l3host->l3a_ip6_addr,
+               sizeof(struct in6_addr));
+        opennsl_ip6_mask_create(route.l3a_ip6_mask, 128);
+    } else {
+        route.l3a_subnet = l3host->l3a_ip_addr;
+        route.l3a_ip_mask = opennsl_ip_mask_create(32);
+    }
+    ops_route_key_from_l3_route(&route, &key);
+
+    ops_routep = ops_route_lookup(&key);
+    if (!ops_routep || !ops_routep->in_host_table ||
+        !ops_route_to_l3_route(ops_routep, &route)) {
+        return false;
+    }
+
+    /* add the route to the lpm first, so it never stops forwarding */
+    ops_routep->in_host_table = false;
+    rc = ops_route_hw_add(hw_unit, ops_routep, &route);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to move host route %s to the lpm: %s",
+                 ops_route_key_to_string(&key, buf, sizeof(buf)),
+                 opennsl_errmsg(rc));
+        ops_routep->in_host_table = true;
+        return false;
+    }
+
+    ops_l3_route_to_l3_host(&route, &route_host);
+    rc = opennsl_l3_host_delete(hw_unit, &route_host);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to delete host route %s: %s",
+                 ops_route_key_to_string(&key, buf, sizeof(buf)),
+                 opennsl_errmsg(rc));
+        return false;
+    }
+    ops_route_table_update(hw_unit, &route, true, -1);
+
+    return true;
+} /* ops_host_route_evict */
+
+/* Initialize the host entry of an address, returns false if the address
+ * is not valid */
+static bool
+ops_host_entry_init(opennsl_l3_host_t *l3host, opennsl_vrf_t vrf_id,
+                    bool is_ipv6_addr, const char *ip_addr)
+{
+    in_addr_t ipv4_dest_addr;
+    char ipv6_dest_addr[sizeof(struct in6_addr)];
+
+    opennsl_l3_host_t_init(l3host);
+    if (is_ipv6_addr) {
+        /* convert string ip into host format */
+        if (inet_pton(AF_INET6, ip_addr, ipv6_dest_addr) != 1) {
+            VLOG_ERR("Invalid ipv6 address %s", ip_addr);
+            return false;
+        }
+        memcpy(l3host->l3a_ip6_addr, ipv6_dest_addr, sizeof(struct in6_addr));
+        l3host->l3a_flags = OPENNSL_L3_IP6;
+    } else {
+        /* convert string ip into host format */
+        ipv4_dest_addr = inet_network(ip_addr);
+        if (ipv4_dest_addr == -1) {
+            VLOG_ERR("Invalid ipv4 address %s", ip_addr);
+            return false;
+        }
+        VLOG_DBG("ipv4 addr converted = 0x%x", ipv4_dest_addr);
+        l3host->l3a_ip_addr = ipv4_dest_addr;
+    }
+    l3host->l3a_vrf = vrf_id;
+
+    return true;
+} /* ops_host_entry_init */
+
+/* Function to add l3 host entry via ofproto */
+int
+ops_routing_add_host_entry(int hw_unit, opennsl_port_t hw_port,
+                           opennsl_vrf_t vrf_id, bool is_ipv6_addr,
+                           char *ip_addr, char *next_hop_mac_addr,
+                           opennsl_if_t l3_intf_id,
+                           opennsl_if_t *l3_egress_id,
+                           opennsl_vlan_t vlan_id)
+{
+    opennsl_error_t rc = OPENNSL_E_NONE;
+    struct ops_egress_key egress_key;
+    opennsl_l3_host_t l3host;
+    struct ether_addr *ether_mac = ether_aton(next_hop_mac_addr);
+    opennsl_port_t port = hw_port;
+    opennsl_l2_addr_t addr;
+    struct ops_stale_entry *stale;
+
+    /* If we dont have a hw_port, this is likely a vlan interface
+     * Look it up.
+     */
+    if(hw_port == -1) {
+        opennsl_mac_t host_mac;
+        if (ether_mac != NULL)
+           memcpy(host_mac, ether_mac, ETH_ALEN);
+        opennsl_l2_addr_get(hw_unit, host_mac, vlan_id, &addr);
+        port = addr.port;
+    }
+
+    /* Get the l3_egress object which gives the index to l3 interface
+     * during lookup, shared with the other neighbors and routes using the
+     * same nexthop destmac, dest port and index of L3_INTF table */
+    VLOG_DBG("In ops_routing_add_host_entry for ip %s", ip_addr);
+    memset(&egress_key, 0, sizeof(egress_key));
+    egress_key.intf = l3_intf_id;
+    egress_key.port = port;
+    egress_key.vlan = vlan_id;
+
+    if (ether_mac != NULL) {
+        memcpy(egress_key.mac, ether_mac, ETH_ALEN);
+    } else {
+        VLOG_ERR("Invalid mac-%s", next_hop_mac_addr);
+        return 1; /* Return error */
+    }
+
+    /* Create Host Entry */
+    if (!ops_host_entry_init(&l3host, vrf_id, is_ipv6_addr, ip_addr)) {
+        VLOG_ERR("Failed to create L3 host entry for %s", ip_addr);
+        return 1; /* Return error */
+    }
+
+    rc = ops_egress_acquire(hw_unit, &egress_key, l3_egress_id);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Error, create egress object, out_port=%d, rc=%s", hw_port,
+                 opennsl_errmsg(rc));
+        return rc;
+    }
+
+    VLOG_DBG("Using L3 egress ID %d for out_port: %d intf_id: %d ",
+          *l3_egress_id, port, l3_intf_id);
+
+    l3host.l3a_intf = *l3_egress_id;
+
+    /* overwrite the entry left by the previous run on a warm restart */
+    stale = ops_stale_host_lookup(&l3host);
+    if (stale) {
+        l3host.l3a_flags |= OPENNSL_L3_REPLACE;
+    }
+
+    rc = opennsl_l3_host_add(hw_unit, &l3host);
+    if ((rc == OPENNSL_E_EXISTS) && ops_host_route_evict(hw_unit, &l3host)) {
+        /* the entry was held by a host route */
+        rc = opennsl_l3_host_add(hw_unit, &l3host);
+    }
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR ("opennsl_l3_host_add failed: rc=%s", opennsl_errmsg(rc));
+        /* no route was moved to the egress object yet */
+        ops_egress_unref(*l3_egress_id);
+        ops_egress_gc();
+        *l3_egress_id = -1;
+        return rc;
+    }
+    if (stale) {
+        ops_stale_claim(&ops_stale_hosts, stale);
+    } else {
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_HOST, 1);
+    }
+
+    /* move the routes using this neighbor as nexthop to its egress object,
+     * once the neighbor is in the asic */
+    ops_nexthop_egress_set(hw_unit, vrf_id, ip_addr, *l3_egress_id);
+
+    return rc;
+} /* ops_routing_add_host_entry */
+
+/* Function to delete l3 host entry via ofproto */
+int
+ops_routing_delete_host_entry(int hw_unit, opennsl_port_t hw_port,
+                              opennsl_vrf_t vrf_id, bool is_ipv6_addr,
+                              char *ip_addr, opennsl_if_t *l3_egress_id)
+{
+    opennsl_error_t rc = OPENNSL_E_NONE;
+    opennsl_l3_host_t l3host;
+
+    /* Delete an IP route / Host Entry */
+    VLOG_DBG("In ops_routing_delete_host_entry for ip %s", ip_addr);
+    if (!ops_host_entry_init(&l3host, vrf_id, is_ipv6_addr, ip_addr)) {
+        return 1; /* Return error */
+    }
+
+    /* the neighbor is gone even if the asic entry is not, its egress
+     * reference is dropped either way */
+    l3host.l3a_intf = *l3_egress_id;
+    rc = opennsl_l3_host_delete(hw_unit, &l3host);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR ("opennsl_l3_host_delete failed: %s", opennsl_errmsg(rc));
+    } else {
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_HOST, -1);
+    }
+
+    /* move the routes using this neighbor as nexthop to the cpu before
+     * the egress object goes away */
+    ops_nexthop_egress_set(hw_unit, vrf_id, ip_addr, local_nhid);
+
+    /* Delete the egress object, unless other hosts or routes still use it */
+    VLOG_DBG("Releasing egress object for egress-id %d", *l3_egress_id);
+    ops_egress_unref(*l3_egress_id);
+    ops_egress_gc();
+
+    *l3_egress_id = -1;
+    return rc;
+} /* ops_routing_delete_host_entry */
+
+/* Hit bits of the host entries of a vrf. The host table is walked once
+ * per sweep with opennsl_l3_host_traverse(), which also clears the hit
+ * bits in the asic, and the hit queries of the neighbor aging sweep are
+ * answered from the cache until it expires. Each host has a bit index
+ * in the cache bitmaps, kept as long as the host is in the asic. */
+struct ops_host_hit_cache {
+    struct hmap_node node;          /* ops_host_hit_caches */
+    int vrf;
+    struct hmap hosts;              /* ops_host_hit by address */
+    unsigned long *used;            /* bit indexes in use */
+    unsigned long *hits;            /* hit bits not read yet */
+    size_t n_bits;
+};
+
+struct ops_host_hit_key {
+    uint32_t is_ipv6;
+    uint8_t addr[16];
+};
+
+struct ops_host_hit {
+    struct hmap_node node;          /* ops_host_hit_cache->hosts */
+    struct ops_host_hit_key key;
+    size_t index;                   /* bit in the cache bitmaps */
+    unsigned int sweep;             /* last sweep the host was seen in */
+};
+
+#define OPS_HOST_HIT_CACHE_MSEC     5000
+#define OPS_HOST_HIT_CACHE_MIN_BITS 1024
+
+static struct hmap ops_host_hit_caches = HMAP_INITIALIZER(&ops_host_hit_caches);
+static long long int host_hit_sweep_time;
+static unsigned int host_hit_sweep;         /* number of sweeps */
+
+/* Build the cache key of a host entry */
+static void
+ops_host_hit_key_from_l3_host(const opennsl_l3_host_t *l3host,
+                              struct ops_host_hit_key *key)
+{
+    memset(key, 0, sizeof(*key));
+    if (l3host->l3a_flags & OPENNSL_L3_IP6) {
+        key->is_ipv6 = 1;
+        memcpy(key->addr, l3host->l3a_ip6_addr, sizeof(struct in6_addr));
+    } else {
+        memcpy(key->addr, &l3host->l3a_ip_addr, sizeof(l3host->l3a_ip_addr));
+    }
+} /* ops_host_hit_key_from_l3_host */
+
+/* Find the hit cache of a vrf */
+static struct ops_host_hit_cache *
+ops_host_hit_cache_lookup(int vrf)
+{
+    struct ops_host_hit_cache *cache;
+
+    HMAP_FOR_EACH_WITH_HASH(cache, node, hash_int(vrf, 0),
+                            &ops_host_hit_caches) {
+        if (cache->vrf == vrf) {
+            return cache;
+        }
+    }
+    return NULL;
+} /* ops_host_hit_cache_lookup */
+
+/* Find a host in the hit cache of its vrf */
+static struct ops_host_hit *
+ops_host_hit_lookup(struct ops_host_hit_cache *cache,
+                    const struct ops_host_hit_key *key)
+{
+    struct ops_host_hit *host;
+
+    HMAP_FOR_EACH_WITH_HASH(host, node, hash_words((const uint32_t *)key,
+                                                   sizeof(*key) / 4, 0),
+                            &cache->hosts) {
+        if (memcmp(&host->key, key, sizeof(*key)) == 0) {
+            return host;
+        }
+    }
+    return NULL;
+} /* ops_host_hit_lookup */
+
+/* Record the hit bit of a host entry found in the host table */
+static int
+ops_host_hit_sweep_cb(int unit, int index, opennsl_l3_host_t *info,
+                      void *user_data)
+{
+    struct ops_host_hit_cache *cache;
+    struct ops_host_hit_key key;
+    struct ops_host_hit *host;
+    size_t n_bits;
+
+    cache = ops_host_hit_cache_lookup(info->l3a_vrf);
+    if (!cache) {
+        cache = xzalloc(sizeof(*cache));
+        cache->vrf = info->l3a_vrf;
+        hmap_init(&cache->hosts);
+        cache->n_bits = OPS_HOST_HIT_CACHE_MIN_BITS;
+        cache->used = bitmap_allocate(cache->n_bits);
+        cache->hits = bitmap_allocate(cache->n_bits);
+        hmap_insert(&ops_host_hit_caches, &cache->node,
+                    hash_int(cache->vrf, 0));
+    }
+
+    ops_host_hit_key_from_l3_host(info, &key);
+    host = ops_host_hit_lookup(cache, &key);
+    if (!host) {
+        host = xzalloc(sizeof(*host));
+        host->key = key;
+        host->index = bitmap_scan(cache->used, false, 0, cache->n_bits);
+        if (host->index == cache->n_bits) {
+            /* double the bitmaps */
+            n_bits = cache->n_bits * 2;
+            cache->used = xrealloc(cache->used, bitmap_n_bytes(n_bits));
+            cache->hits = xrealloc(cache->hits, bitmap_n_bytes(n_bits));
+            memset((char *)cache->used + bitmap_n_bytes(cache->n_bits), 0,
+                   bitmap_n_bytes(n_bits) - bitmap_n_bytes(cache->n_bits));
+            memset((char *)cache->hits + bitmap_n_bytes(cache->n_bits), 0,
+                   bitmap_n_bytes(n_bits) - bitmap_n_bytes(cache->n_bits));
+            cache->n_bits = n_bits;
+        }
+        bitmap_set1(cache->used, host->index);
+        hmap_insert(&cache->hosts, &host->node,
+                    hash_words((const uint32_t *)&key, sizeof(key) / 4, 0));
+    }
+    host->sweep = host_hit_sweep;
+
+    /* hits not yet read are kept, the asic bit was cleared by the walk */
+    if (info->l3a_flags & OPENNSL_L3_HIT) {
+        bitmap_set1(cache->hits, host->index);
+    }
+
+    return OPENNSL_E_NONE;
+} /* ops_host_hit_sweep_cb */
+
+/* Collect the hit bits of all the host entries, clearing them in the
+ * asic, and drop the hosts which are no longer in the host table */
+static int
+ops_host_hit_sweep(int hw_unit)
+{
+    struct ops_host_hit_cache *cache, *next_cache;
+    struct ops_host_hit *host, *next;
+    opennsl_l3_info_t l3_hw_status;
+    opennsl_error_t rc;
+
+    rc = opennsl_l3_info(hw_unit, &l3_hw_status);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Error in L3 info access: %s", opennsl_errmsg(rc));
+        return rc;
+    }
+
+    /* a failed sweep is not retried before the cache expires */
+    host_hit_sweep++;
+    host_hit_sweep_time = time_msec();
+    rc = opennsl_l3_host_traverse(hw_unit, OPENNSL_L3_HIT_CLEAR, 0,
+                                  l3_hw_status.l3info_max_host,
+                                  &ops_host_hit_sweep_cb, NULL);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to collect ipv4 host hit bits: %s",
+                 opennsl_errmsg(rc));
+        return rc;
+    }
+    rc = opennsl_l3_host_traverse(hw_unit,
+                                  OPENNSL_L3_IP6 | OPENNSL_L3_HIT_CLEAR, 0,
+                                  l3_hw_status.l3info_max_host,
+                                  &ops_host_hit_sweep_cb, NULL);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to collect ipv6 host hit bits: %s",
+                 opennsl_errmsg(rc));
+        return rc;
+    }
+
+    HMAP_FOR_EACH_SAFE(cache, next_cache, node, &ops_host_hit_caches) {
+        HMAP_FOR_EACH_SAFE(host, next, node, &cache->hosts) {
+            if (host->sweep != host_hit_sweep) {
+                bitmap_set0(cache->used, host->index);
+                bitmap_set0(cache->hits, host->index);
+                hmap_remove(&cache->hosts, &host->node);
+                free(host);
+            }
+        }
+        if (hmap_is_empty(&cache->hosts)) {
+            hmap_remove(&ops_host_hit_caches, &cache->node);
+            hmap_destroy(&cache->hosts);
+            bitmap_free(cache->used);
+            bitmap_free(cache->hits);
+            free(cache);
+        }
+    }
+
+    return OPENNSL_E_NONE;
+} /* ops_host_hit_sweep */
+
+/* Read and reset the hit bit of a host from the hit cache, sweeping the
+ * host table if the cache expired. Returns false if the host was not in
+ * the host table at the last sweep. */
+static bool
+ops_host_hit_cache_get(int hw_unit, opennsl_l3_host_t *l3host, bool *hit_bit)
+{
+    struct ops_host_hit_cache *cache;
+    struct ops_host_hit_key key;
+    struct ops_host_hit *host;
+
+    if (!host_hit_sweep ||
+        ((time_msec() - host_hit_sweep_time) >= OPS_HOST_HIT_CACHE_MSEC)) {
+        if (OPENNSL_FAILURE(ops_host_hit_sweep(hw_unit))) {
+            return false;
+        }
+    }
+
+    cache = ops_host_hit_cache_lookup(l3host->l3a_vrf);
+    if (!cache) {
+        return false;
+    }
+    ops_host_hit_key_from_l3_host(l3host, &key);
+    host = ops_host_hit_lookup(cache, &key);
+    if (!host) {
+        return false;
+    }
+
+    /* the hit bit is reported once per sweep, like the hit bit in the
+     * asic is reset once read */
+    *hit_bit = bitmap_is_set(cache->hits, host->index);
+    bitmap_set0(cache->hits, host->index);
+    return true;
+} /* ops_host_hit_cache_get */
+
+/* Ft to read and reset the host hit-bit */
+int
+ops_routing_get_host_hit(int hw_unit, opennsl_vrf_t vrf_id,
+                         bool is_ipv6_addr, char *ip_addr, bool *hit_bit)
+{
+    opennsl_error_t rc = OPENNSL_E_NONE;
+    opennsl_l3_host_t l3host;
+    in_addr_t ipv4_dest_addr;
+    char ipv6_dest_addr[sizeof(struct in6_addr)];
+    int flags = 0;
+
+    VLOG_DBG("In ops_routing_get_host_hit for ip %s", ip_addr);
+    opennsl_l3_host_t_init(&l3host);
+    if( is_ipv6_addr ) {
+        VLOG_DBG("ipv6 addr type");
+        flags |= OPENNSL_L3_IP6;
+
+        /* convert string ip into host format */
+        rc = inet_pton(AF_INET6, ip_addr, ipv6_dest_addr);
+        if ( rc != 1 ) {
+            VLOG_ERR("invalid ipv6-%s", ip_addr);
+            return 1;
+        }
+
+        memcpy(l3host.l3a_ip6_addr, ipv6_dest_addr, sizeof(struct in6_addr));
+    } else {
+        /* convert string ip into host format */
+        ipv4_dest_addr = inet_network(ip_addr);
+        if ( ipv4_dest_addr == -1 ) {
+            VLOG_ERR("Invalid ip-%s", ip_addr);
+            return 1;
+        }
+
+        VLOG_DBG("ipv4 addr converted =0x%x", ipv4_dest_addr);
+        l3host.l3a_ip_addr = ipv4_dest_addr;
+    }
+
+    /* Get Host Entry */
+    l3host.l3a_vrf = vrf_id;
+    l3host.l3a_flags = flags;
+
+    /* answer from the bulk hit bit collection, unless the host was added
+     * since the last sweep */
+    if (ops_host_hit_cache_get(hw_unit, &l3host, hit_bit)) {
+        VLOG_DBG("Got the cached hit-bit =0x%x", *hit_bit);
+        return OPENNSL_E_NONE;
+    }
+
+    rc = opennsl_l3_host_find(hw_unit, &l3host);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR ("opennsl_l3_host_find failed: %s", opennsl_errmsg(rc));
+        return rc;
+    } else {
+        *hit_bit = (l3host.l3a_flags & OPENNSL_L3_HIT);
+        VLOG_DBG("Got the hit-bit =0x%x", *hit_bit);
+        if(*hit_bit) {
+            l3host.l3a_flags = flags | OPENNSL_L3_HIT_CLEAR;
+            /* Reset the hit-bit */
+            rc = opennsl_l3_host_find(hw_unit, &l3host);
+            if (OPENNSL_FAILURE(rc)) {
+                VLOG_ERR ("Reset hit-bit failed: %s", opennsl_errmsg(rc));
+                return rc;
+            }
+        }
+    }
+
+    return rc;
+} /* ops_routing_get_host_hit */
+
+/* Convert from string to ipv4/ipv6 prefix */
+static int
+ops_string_to_prefix(int family, char *ip_address, void *prefix,
+                     unsigned char *prefixlen)
+{
+    char *p;
+    char *tmp_ip_addr;
+    int maxlen = (family == AF_INET) ? IPV4_PREFIX_LEN :
+                                       IPV6_PREFIX_LEN;
+    *prefixlen = maxlen;
+    tmp_ip_addr = strdup(ip_address);
+
+    if ((p = strchr(tmp_ip_addr, '/'))) {
+        *p++ = '\0';
+        *prefixlen = atoi(p);
+    }
+
+    if (*prefixlen > maxlen) {
+        VLOG_DBG("Bad prefixlen %d > %d", *prefixlen, maxlen);
+        free(tmp_ip_addr);
+        return EINVAL;
+    }
+
+    if (family == AF_INET) {
+        /* ipv4 address in host order */
+        in_addr_t *addr = (in_addr_t*)prefix;
+        *addr = inet_network(tmp_ip_addr);
+        if (*addr == -1) {
+            VLOG_ERR("Invalid ip address %s", ip_address);
+            free(tmp_ip_addr);
+            return EINVAL;
+        }
+    } else {
+        /* ipv6 address */
+        if (inet_pton(family, tmp_ip_addr, prefix) == 0) {
+            VLOG_DBG("%d inet_pton failed with %s", family, strerror(errno));
+            free(tmp_ip_addr);
+            return EINVAL;
+        }
+    }
+
+    free(tmp_ip_addr);
+    return 0;
+} /* ops_string_to_prefix */
+
+/* Compare egress object ids, used to sort the ecmp group key */
+static int
+ops_egress_id_cmp(const void *a, const void *b)
+{
+    opennsl_if_t id1 = *(const opennsl_if_t *)a;
+    opennsl_if_t id2 = *(const opennsl_if_t *)b;
+
+    return (id1 > id2) - (id1 < id2);
+} /* ops_egress_id_cmp */
+
+/* Scale down the weights of the nexthops of a route so that the total
+ * number of ecmp members fits in max_members, keeping at least one
+ * member per nexthop. Returns the total number of members. */
+static int
+ops_wcmp_weights_reduce(int *weights, int n, int max_members)
+{
+    long long int scaled;
+    int total = 0;
+    int divisor = 0;
+    int a, b, t;
+    int i, max;
+
+    /* divide by the greatest common divisor of the weights */
+    for (i = 0; i < n; i++) {
+        for (a = divisor, b = weights[i]; b; a = b, b = t) {
+            t = a % b;
+        }
+        divisor = a;
+    }
+    for (i = 0; i < n; i++) {
+        weights[i] /= divisor;
+        total += weights[i];
+    }
+    if (total <= max_members) {
+        return total;
+    }
+
+    /* scale down in proportion, then trim the largest weights */
+    for (i = 0; i < n; i++) {
+        scaled = ((long long int)weights[i] * max_members) / total;
+        weights[i] = MAX(1, (int)scaled);
+    }
+    for (total = 0, i = 0; i < n; i++) {
+        total += weights[i];
+    }
+    while (total > max_members) {
+        for (max = 0, i = 1; i < n; i++) {
+            if (weights[i] > weights[max]) {
+                max = i;
+            }
+        }
+        if (weights[max] == 1) {
+            break;
+        }
+        weights[max]--;
+        total--;
+    }
+    return total;
+} /* ops_wcmp_weights_reduce */
+
+/* Collect the egress ids of the route nexthops in canonical (sorted)
+ * order. The egress id of a weighted nexthop is repeated once per unit
+ * of weight. */
+static int
+ops_route_egress_ids(struct ops_route *routep, opennsl_if_t *egress_ids)
+{
+    int weights[MAX_NEXTHOPS_PER_ROUTE];
+    int nh_count = 0;
+    int n_egress;
+    struct ops_nexthop *nh;
+    int i;
+
+    HMAP_FOR_EACH(nh, node, &routep->nexthops) {
+        egress_ids[nh_count] = nh->l3_egress_id;
+        weights[nh_count] = ops_nexthop_weight_get(routep->key.vrf, nh->id);
+        nh_count++;
+        /* break once max ecmp is reached */
+        if (nh_count == MAX_NEXTHOPS_PER_ROUTE) {
+            break;
+        }
+    }
+
+    /* replicate the egress ids of weighted nexthops */
+    if ((nh_count > 1) &&
+        (ops_wcmp_weights_reduce(weights, nh_count,
+                                 ecmp_max_members) > nh_count)) {
+        n_egress = nh_count;
+        for (i = 0; i < nh_count; i++) {
+            while (--weights[i] > 0) {
+                egress_ids[n_egress++] = egress_ids[i];
+            }
+        }
+        nh_count = n_egress;
+    }
+    qsort(egress_ids, nh_count, sizeof(opennsl_if_t), ops_egress_id_cmp);
+
+    return nh_count;
+} /* ops_route_egress_ids */
+
+/* Create ecmp group hash */
+static uint32_t
+ops_ecmp_group_hash(const opennsl_if_t *egress_ids, int n_egress)
+{
+    return hash_bytes(egress_ids, n_egress * sizeof(opennsl_if_t), 0);
+} /* ops_ecmp_group_hash */
+
+/* Find an ecmp group with exactly the given egress ids */
+static struct ops_ecmp_group *
+ops_ecmp_group_lookup(const opennsl_if_t *egress_ids, int n_egress)
+{
+    struct ops_ecmp_group *grp;
+
+    HMAP_FOR_EACH_WITH_HASH(grp, node,
+                            ops_ecmp_group_hash(egress_ids, n_egress),
+                            &ops_ecmp_groups) {
+        if ((grp->n_egress == n_egress) &&
+            (memcmp(grp->egress_ids, egress_ids,
+                    n_egress * sizeof(opennsl_if_t)) == 0)) {
+            return grp;
+        }
+    }
+    return NULL;
+} /* ops_ecmp_group_lookup */
+
+/* Move the members of a resilient ecmp group to a new sorted set of
+ * egress objects. Members are added and deleted one at a time, so that
+ * only the flow buckets of the changed members are remapped. New members
+ * are added first, so that the group never becomes empty. */
+static int
+ops_ecmp_resilient_update(int hw_unit, opennsl_if_t ecmp_intf,
+                          opennsl_if_t *egress_ids, int n_egress)
+{
+    opennsl_l3_egress_ecmp_t ecmp_grp;
+    opennsl_if_t cur_ids[OPS_ECMP_MAX_MEMBERS];
+    int n_cur = 0;
+    opennsl_error_t rc;
+    int i, j;
+
+    opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
+    ecmp_grp.ecmp_intf = ecmp_intf;
+    rc = opennsl_l3_egress_ecmp_get(hw_unit, &ecmp_grp,
+                                    OPS_ECMP_MAX_MEMBERS, cur_ids, &n_cur);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to get ecmp object %d: %s", ecmp_intf,
+                 opennsl_errmsg(rc));
+        return rc;
+    }
+    qsort(cur_ids, n_cur, sizeof(opennsl_if_t), ops_egress_id_cmp);
+
+    /* add the members not in the group */
+    for (i = 0, j = 0; i < n_egress; i++) {
+        while ((j < n_cur) && (cur_ids[j] < egress_ids[i])) {
+            j++;
+        }
+        if ((j < n_cur) && (cur_ids[j] == egress_ids[i])) {
+            j++;
+            continue;
+        }
+        rc = opennsl_l3_egress_ecmp_add(hw_unit, &ecmp_grp, egress_ids[i]);
+        if (OPENNSL_FAILURE(rc)) {
+            VLOG_ERR("Failed to add egress %d to ecmp object %d: %s",
+                     egress_ids[i], ecmp_intf, opennsl_errmsg(rc));
+            return rc;
+        }
+    }
+
+    /* delete the members not in the new set */
+    for (i = 0, j = 0; j < n_cur; j++) {
+        while ((i < n_egress) && (egress_ids[i] < cur_ids[j])) {
+            i++;
+        }
+        if ((i < n_egress) && (egress_ids[i] == cur_ids[j])) {
+            i++;
+            continue;
+        }
+        rc = opennsl_l3_egress_ecmp_delete(hw_unit, &ecmp_grp, cur_ids[j]);
+        if (OPENNSL_FAILURE(rc)) {
+            VLOG_ERR("Failed to delete egress %d from ecmp object %d: %s",
+                     cur_ids[j], ecmp_intf, opennsl_errmsg(rc));
+            return rc;
+        }
+    }
+
+    return OPENNSL_E_NONE;
+} /* ops_ecmp_resilient_update */
+
+/* Create or update an ecmp egress object */
+static int
+ops_create_or_update_ecmp_object(int hw_unit, opennsl_if_t *egress_ids,
+                                 int n_egress, opennsl_if_t *ecmp_intfp,
+                                 bool update)
+{
+    opennsl_error_t rc = OPENNSL_E_NONE;
+    opennsl_l3_egress_ecmp_t ecmp_grp;
+    uint64_t start = ops_l3_perf_now();
+
+    if (update && ecmp_resilient) {
+        rc = ops_ecmp_resilient_update(hw_unit, *ecmp_intfp, egress_ids,
+                                       n_egress);
+        goto done;
+    }
+
+    opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
+    if (update) {
+        ecmp_grp.flags = (OPENNSL_L3_REPLACE | OPENNSL_L3_WITH_ID);
+        ecmp_grp.ecmp_intf = *ecmp_intfp;
+    }
+    if (ecmp_resilient) {
+        ecmp_grp.dynamic_mode = OPENNSL_L3_ECMP_DYNAMIC_MODE_RESILIENT;
+        ecmp_grp.dynamic_size = OPS_ECMP_RESILIENT_BUCKETS;
+    }
+
+    rc = opennsl_l3_egress_ecmp_create(hw_unit, &ecmp_grp, n_egress,
+                                       egress_ids);
+    if (OPENNSL_SUCCESS(rc)) {
+        *ecmp_intfp = ecmp_grp.ecmp_intf;
+    }
+
+done:
+    ops_l3_perf_record(update ? OPS_L3_PERF_ECMP_UPDATE :
+                                OPS_L3_PERF_ECMP_CREATE,
+                       start, OPENNSL_FAILURE(rc));
+    return rc;
+} /* ops_create_or_update_ecmp_object */
+
+/* Switch an ecmp group in the asic to or from resilient hashing */
+static int
+ops_ecmp_group_resilient_set(int hw_unit, struct ops_ecmp_group *grp,
+                             bool enable)
+{
+    opennsl_l3_egress_ecmp_t ecmp_grp;
+    opennsl_if_t hw_ids[OPS_ECMP_MAX_MEMBERS];
+    int n_hw = 0;
+    int rc;
+
+    /* keep the members pruned on link down out of the group */
+    opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
+    ecmp_grp.ecmp_intf = grp->ecmp_intf;
+    rc = opennsl_l3_egress_ecmp_get(hw_unit, &ecmp_grp,
+                                    OPS_ECMP_MAX_MEMBERS, hw_ids, &n_hw);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to get ecmp object %d: %s", grp->ecmp_intf,
+                 opennsl_errmsg(rc));
+        return rc;
+    }
+    opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
+    ecmp_grp.flags = (OPENNSL_L3_REPLACE | OPENNSL_L3_WITH_ID);
+    ecmp_grp.ecmp_intf = grp->ecmp_intf;
+    if (enable) {
+        ecmp_grp.dynamic_mode = OPENNSL_L3_ECMP_DYNAMIC_MODE_RESILIENT;
+        ecmp_grp.dynamic_size = OPS_ECMP_RESILIENT_BUCKETS;
+    }
+    rc = opennsl_l3_egress_ecmp_create(hw_unit, &ecmp_grp, n_hw, hw_ids);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to set resilient hashing %s on ecmp object %d: %s",
+                 enable ? "on" : "off", grp->ecmp_intf, opennsl_errmsg(rc));
+    }
+    return rc;
+} /* ops_ecmp_group_resilient_set */
+
+/* Switch the ecmp groups in the asic to or from resilient hashing. If a
+ * group fails, the groups already switched are switched back, so all the
+ * groups keep the mode of ecmp_resilient. */
+static int
+ops_ecmp_resilient_set(int hw_unit, bool enable)
+{
+    struct ops_ecmp_group *grp;
+    int n_done = 0;
+    int rc = OPENNSL_E_NONE;
+
+    if (ecmp_resilient == enable) {
+        return OPENNSL_E_NONE;
+    }
+
+    ovs_mutex_lock(&egress_mutex);
+    HMAP_FOR_EACH (grp, node, &ops_ecmp_groups) {
+        rc = ops_ecmp_group_resilient_set(hw_unit, grp, enable);
+        if (OPENNSL_FAILURE(rc)) {
+            break;
+        }
+        n_done++;
+    }
+
+    if (OPENNSL_FAILURE(rc)) {
+        HMAP_FOR_EACH (grp, node, &ops_ecmp_groups) {
+            if (n_done-- == 0) {
+                break;
+            }
+            ops_ecmp_group_resilient_set(hw_unit, grp, !enable);
+        }
+    } else {
+        ecmp_resilient = enable;
+    }
+    ovs_mutex_unlock(&egress_mutex);
+
+    return rc;
+} /* ops_ecmp_resilient_set */
+
+/* Delete ecmp object */
+static int
+ops_delete_ecmp_object(int hw_unit, opennsl_if_t ecmp_intf)
+{
+    opennsl_error_t rc = OPENNSL_E_NONE;
+    opennsl_l3_egress_ecmp_t ecmp_grp;
+    uint64_t start = ops_l3_perf_now();
+
+    opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
+    ecmp_grp.ecmp_intf = ecmp_intf;
+
+    rc = opennsl_l3_egress_ecmp_destroy(hw_unit, &ecmp_grp);
+    ops_l3_perf_record(OPS_L3_PERF_ECMP_DESTROY, start, OPENNSL_FAILURE(rc));
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to delete ecmp egress object %d: %s",
+                  ecmp_intf, opennsl_errmsg(rc));
+        return rc;
+    }
+    return rc;
+} /* ops_delete_ecmp_object */
+
+/* Find an egress object by id, called with egress_mutex held */
+static struct ops_egress *
+ops_egress_lookup(opennsl_if_t egress_id)
+{
+    struct ops_egress *egress;
+
+    HMAP_FOR_EACH_WITH_HASH(egress, node, hash_int(egress_id, 0),
+                            &ops_egresses) {
+        if (egress->egress_id == egress_id) {
+            return egress;
+        }
+    }
+    return NULL;
+} /* ops_egress_lookup */
+
+/* Add back the members removed from the ecmp groups using an egress
+ * object, called with egress_mutex held */
+static void
+ops_egress_port_restore(int hw_unit, struct ops_egress *egress)
+{
+    struct ops_ecmp_member *member;
+    opennsl_l3_egress_ecmp_t ecmp_grp;
+    opennsl_error_t rc = OPENNSL_E_NONE;
+
+    LIST_FOR_EACH (member, egress_node, &egress->members) {
+        opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
+        ecmp_grp.ecmp_intf = member->grp->ecmp_intf;
+        while (member->n_removed) {
+            rc = opennsl_l3_egress_ecmp_add(hw_unit, &ecmp_grp,
+                                            egress->egress_id);
+            if (OPENNSL_FAILURE(rc)) {
+                VLOG_ERR("Failed to add egress %d back to ecmp object %d: %s",
+                         egress->egress_id, ecmp_grp.ecmp_intf,
+                         opennsl_errmsg(rc));
+                break;
+            }
+            member->n_removed--;
+            member->grp->n_down--;
+            ops_hw_table_update(hw_unit, OPS_HW_TABLE_ECMP_MEMBER, 1);
+        }
+    }
+} /* ops_egress_port_restore */
+
+/* Remove the members on a port from the ecmp groups using an egress
+ * object, keeping at least one member in each group. Called with
+ * egress_mutex held. */
+static void
+ops_egress_port_prune(int hw_unit, struct ops_egress *egress)
+{
+    struct ops_ecmp_member *member;
+    opennsl_l3_egress_ecmp_t ecmp_grp;
+    opennsl_error_t rc = OPENNSL_E_NONE;
+    int i;
+
+    LIST_FOR_EACH (member, egress_node, &egress->members) {
+        if (member->n_removed ||
+            ((member->grp->n_egress - member->grp->n_down) <= member->count)) {
+            continue;
+        }
+        opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
+        ecmp_grp.ecmp_intf = member->grp->ecmp_intf;
+        /* weighted nexthops have one copy per unit of weight */
+        for (i = 0; i < member->count; i++) {
+            rc = opennsl_l3_egress_ecmp_delete(hw_unit, &ecmp_grp,
+                                               egress->egress_id);
+            if (OPENNSL_FAILURE(rc)) {
+                VLOG_ERR("Failed to remove egress %d from ecmp object %d: %s",
+                         egress->egress_id, ecmp_grp.ecmp_intf,
+                         opennsl_errmsg(rc));
+                break;
+            }
+            member->n_removed++;
+            member->grp->n_down++;
+            ops_hw_table_update(hw_unit, OPS_HW_TABLE_ECMP_MEMBER, -1);
+        }
+    }
+} /* ops_egress_port_prune */
+
+/* Hash of the key of an egress object */
+static uint32_t
+ops_egress_key_hash(const struct ops_egress_key *key)
+{
+    return hash_bytes(key, sizeof(*key), 0);
+} /* ops_egress_key_hash */
+
+/* Hash of the (vlan, mac) of the neighbor of an egress object */
+static uint32_t
+ops_egress_mac_hash(opennsl_vlan_t vlan, const opennsl_mac_t mac)
+{
+    return hash_bytes(mac, ETH_ALEN, vlan);
+} /* ops_egress_mac_hash */
+
+/* Find an egress object by key, called with egress_mutex held */
+static struct ops_egress *
+ops_egress_lookup_by_key(const struct ops_egress_key *key)
+{
+    struct ops_egress *egress;
+
+    HMAP_FOR_EACH_WITH_HASH(egress, key_node, ops_egress_key_hash(key),
+                            &ops_egresses_by_key) {
+        if (memcmp(&egress->key, key, sizeof(*key)) == 0) {
+            return egress;
+        }
+    }
+    return NULL;
+} /* ops_egress_lookup_by_key */
+
+/* Take a reference on an egress object, called with egress_mutex held */
+static void
+ops_egress_hold(struct ops_egress *egress)
+{
+    if (!egress->refcnt++) {
+        list_remove(&egress->unused_node);
+        list_init(&egress->unused_node);
+    }
+} /* ops_egress_hold */
+
+/* Drop a reference on an egress object, called with egress_mutex held.
+ * The egress object is destroyed by ops_egress_gc() once the asic no
+ * longer uses it. */
+static void
+ops_egress_drop(struct ops_egress *egress)
+{
+    if (!--egress->refcnt) {
+        list_push_back(&ops_egresses_unused, &egress->unused_node);
+    }
+} /* ops_egress_drop */
+
+/* Add an egress object of the asic to the cache, with no user yet.
+ * Called with egress_mutex held. */
+static struct ops_egress *
+ops_egress_insert(int hw_unit, const struct ops_egress_key *key,
+                  opennsl_if_t egress_id)
+{
+    struct ops_egress *egress;
+
+    egress = xzalloc(sizeof(*egress));
+    egress->key = *key;
+    egress->egress_id = egress_id;
+    egress->hw_unit = hw_unit;
+    list_init(&egress->unused_node);
+    list_init(&egress->members);
+    hmap_insert(&ops_egresses, &egress->node, hash_int(egress_id, 0));
+    hmap_insert(&ops_egresses_by_key, &egress->key_node,
+                ops_egress_key_hash(key));
+    hmap_insert(&ops_egresses_by_port, &egress->port_node,
+                hash_int(key->port, 0));
+    hmap_insert(&ops_egresses_by_mac, &egress->mac_node,
+                ops_egress_mac_hash(key->vlan, key->mac));
+
+    return egress;
+} /* ops_egress_insert */
+
+/* Get the egress object of a neighbor, creating it in the asic if no
+ * other host or route uses one with the same attributes */
+static int
+ops_egress_acquire(int hw_unit, const struct ops_egress_key *key,
+                   opennsl_if_t *egress_id)
+{
+    opennsl_l3_egress_t egress_object;
+    struct ops_egress *egress;
+    opennsl_error_t rc;
+
+    ovs_mutex_lock(&egress_mutex);
+    egress = ops_egress_lookup_by_key(key);
+    if (egress) {
+        ops_egress_hold(egress);
+        *egress_id = egress->egress_id;
+        ovs_mutex_unlock(&egress_mutex);
+        return OPENNSL_E_NONE;
+    }
+
+    opennsl_l3_egress_t_init(&egress_object);
+    egress_object.intf = key->intf;
+    egress_object.port = key->port;
+    memcpy(egress_object.mac_addr, key->mac, ETH_ALEN);
+
+    rc = opennsl_l3_egress_create(hw_unit, 0, &egress_object, egress_id);
+    if (OPENNSL_FAILURE(rc)) {
+        ovs_mutex_unlock(&egress_mutex);
+        return rc;
+    }
+    ops_hw_table_update(hw_unit, OPS_HW_TABLE_EGRESS, 1);
+
+    egress = ops_egress_insert(hw_unit, key, *egress_id);
+    egress->refcnt = 1;
+    ovs_mutex_unlock(&egress_mutex);
+
+    return OPENNSL_E_NONE;
+} /* ops_egress_acquire */
+
+/* Take a reference on an egress object used as route nexthop. Egress
+ * objects not created by ops_egress_acquire(), like the one to the cpu,
+ * are not tracked. */
+static void
+ops_egress_ref(opennsl_if_t egress_id)
+{
+    struct ops_egress *egress;
+
+    ovs_mutex_lock(&egress_mutex);
+    egress = ops_egress_lookup(egress_id);
+    if (egress) {
+        ops_egress_hold(egress);
+    }
+    ovs_mutex_unlock(&egress_mutex);
+} /* ops_egress_ref */
+
+/* Drop a reference taken with ops_egress_acquire() or ops_egress_ref() */
+static void
+ops_egress_unref(opennsl_if_t egress_id)
+{
+    struct ops_egress *egress;
+
+    ovs_mutex_lock(&egress_mutex);
+    egress = ops_egress_lookup(egress_id);
+    if (egress) {
+        ops_egress_drop(egress);
+    }
+    ovs_mutex_unlock(&egress_mutex);
+} /* ops_egress_unref */
+
+/* Destroy the egress objects with no user left. Called once the routes
+ * and ecmp groups have been moved off them in the asic. */
+static void
+ops_egress_gc(void)
+{
+    struct ops_egress *egress, *next;
+    opennsl_error_t rc;
+
+    ovs_mutex_lock(&egress_mutex);
+    LIST_FOR_EACH_SAFE (egress, next, unused_node, &ops_egresses_unused) {
+        VLOG_DBG("Deleting egress object for egress-id %d",
+                 egress->egress_id);
+        rc = opennsl_l3_egress_destroy(egress->hw_unit, egress->egress_id);
+        if (OPENNSL_FAILURE(rc)) {
+            /* still used in the asic, retried on the next call */
+            VLOG_ERR("opennsl_egress_destroy failed: %s", opennsl_errmsg(rc));
+            continue;
+        }
+        ops_hw_table_update(egress->hw_unit, OPS_HW_TABLE_EGRESS, -1);
+        list_remove(&egress->unused_node);
+        hmap_remove(&ops_egresses, &egress->node);
+        hmap_remove(&ops_egresses_by_key, &egress->key_node);
+        hmap_remove(&ops_egresses_by_port, &egress->port_node);
+        hmap_remove(&ops_egresses_by_mac, &egress->mac_node);
+        free(egress);
+    }
+    ovs_mutex_unlock(&egress_mutex);
+} /* ops_egress_gc */
+
+/* Rewrite a neighbor egress object in the asic to go out of another
+ * port after a mac move, called with egress_mutex held */
+static int
+ops_egress_port_rewrite(struct ops_egress *egress, opennsl_port_t port)
+{
+    opennsl_l3_egress_t egress_object;
+    opennsl_if_t egress_id = egress->egress_id;
+    opennsl_error_t rc;
+
+    opennsl_l3_egress_t_init(&egress_object);
+    egress_object.intf = egress->key.intf;
+    egress_object.port = port;
+    memcpy(egress_object.mac_addr, egress->key.mac, ETH_ALEN);
+
+    VLOG_DBG("Move egress object %d, vlan=%d, mac=" ETH_ADDR_FMT
+             " from port %d to port %d", egress_id, egress->key.vlan,
+             ETH_ADDR_BYTES_ARGS(egress->key.mac), egress->key.port, port);
+
+    rc = opennsl_l3_egress_create(egress->hw_unit,
+                                  (OPENNSL_L3_REPLACE | OPENNSL_L3_WITH_ID),
+                                  &egress_object, &egress_id);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to move egress object %d to port %d: %s",
+                 egress->egress_id, port, opennsl_errmsg(rc));
+        return rc;
+    }
+
+    /* put it back in the groups it was pruned from on the old port */
+    ops_egress_port_restore(egress->hw_unit, egress);
+    hmap_remove(&ops_egresses_by_key, &egress->key_node);
+    hmap_remove(&ops_egresses_by_port, &egress->port_node);
+    egress->key.port = port;
+    hmap_insert(&ops_egresses_by_key, &egress->key_node,
+                ops_egress_key_hash(&egress->key));
+    hmap_insert(&ops_egresses_by_port, &egress->port_node, hash_int(port, 0));
+
+    return rc;
+} /* ops_egress_port_rewrite */
+
+/* Drop the egress memberships of an ecmp group, called with egress_mutex
+ * held */
+static void
+ops_ecmp_group_members_clear(struct ops_ecmp_group *grp)
+{
+    struct ops_ecmp_member *member, *next;
+
+    LIST_FOR_EACH_SAFE (member, next, grp_node, &grp->members) {
+        list_remove(&member->grp_node);
+        list_remove(&member->egress_node);
+        ops_egress_drop(member->egress);
+        free(member);
+    }
+    grp->n_down = 0;
+} /* ops_ecmp_group_members_clear */
+
+/* Index the members of an ecmp group by egress object, given its sorted
+ * egress ids and the ones left out of the asic group for being down.
+ * Called with egress_mutex held. */
+static void
+ops_ecmp_group_members_index(struct ops_ecmp_group *grp,
+                             struct ops_egress **egresses, const bool *down,
+                             int n_egress)
+{
+    struct ops_ecmp_member *member = NULL;
+    int i;
+
+    for (i = 0; i < n_egress; i++) {
+        if (!egresses[i]) {
+            continue;
+        }
+        if (down[i]) {
+            grp->n_down++;
+        }
+        /* egress ids are sorted, index each distinct one once */
+        if (member && (member->egress == egresses[i])) {
+            member->count++;
+            member->n_removed += down[i];
+            continue;
+        }
+        member = xzalloc(sizeof(*member));
+        member->grp = grp;
+        member->egress = egresses[i];
+        member->count = 1;
+        member->n_removed = down[i];
+        list_push_back(&grp->members, &member->grp_node);
+        list_push_back(&egresses[i]->members, &member->egress_node);
+        ops_egress_hold(egresses[i]);
+    }
+} /* ops_ecmp_group_members_index */
+
+/* Program the members of an ecmp group in the asic and index them by
+ * port. Members on a port which is down are left out, unless all of them
+ * are down. The link state is read and the members of the group are set
+ * under egress_mutex, so that a link change handled on the linkscan
+ * thread sees either the old or the new members, never a mix. */
+static int
+ops_ecmp_group_program(int hw_unit, struct ops_ecmp_group *grp,
+                       opennsl_if_t *egress_ids, int n_egress, bool update)
+{
+    opennsl_if_t hw_ids[OPS_ECMP_MAX_MEMBERS];
+    struct ops_egress *egresses[OPS_ECMP_MAX_MEMBERS];
+    opennsl_pbmp_t link_up_pbm;
+    bool down[OPS_ECMP_MAX_MEMBERS];
+    int n_hw = 0;
+    int rc;
+    int i;
+
+    ovs_mutex_lock(&egress_mutex);
+
+    /* the linkscan thread updates the bitmap before pruning the port */
+    link_up_pbm = ops_get_link_up_pbm(hw_unit);
+    for (i = 0; i < n_egress; i++) {
+        egresses[i] = ops_egress_lookup(egress_ids[i]);
+        down[i] = egresses[i] &&
+                  !OPENNSL_PBMP_MEMBER(link_up_pbm, egresses[i]->key.port);
+        if (!down[i]) {
+            hw_ids[n_hw++] = egress_ids[i];
+        }
+    }
+    if (!n_hw) {
+        /* all members are down, keep them all */
+        memcpy(hw_ids, egress_ids, n_egress * sizeof(opennsl_if_t));
+        memset(down, 0, sizeof(down));
+        n_hw = n_egress;
+    }
+
+    rc = ops_create_or_update_ecmp_object(hw_unit, hw_ids, n_hw,
+                                          &grp->ecmp_intf, update);
+    if (OPENNSL_FAILURE(rc)) {
+        ovs_mutex_unlock(&egress_mutex);
+        return rc;
+    }
+    if (!update) {
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_ECMP_GROUP, 1);
+    }
+    /* the members in the asic were those of the group not pruned */
+    ops_hw_table_update(hw_unit, OPS_HW_TABLE_ECMP_MEMBER,
+                        n_hw - (grp->n_egress - grp->n_down));
+
+    ops_ecmp_group_members_clear(grp);
+    grp->n_egress = n_egress;
+    memcpy(grp->egress_ids, egress_ids, n_egress * sizeof(opennsl_if_t));
+    ops_ecmp_group_members_index(grp, egresses, down, n_egress);
+
+    ovs_mutex_unlock(&egress_mutex);
+    return rc;
+} /* ops_ecmp_group_program */
+
+/* Prune or restore the ecmp group members on a port when its link goes
+ * down or up. Called from the linkscan thread, so that traffic stops
+ * being hashed onto a dead link without waiting for the routes to
+ * converge. */
+void
+ops_routing_link_state_change(int unit, opennsl_port_t hw_port, bool link_up)
+{
+    struct ops_egress *egress;
+
+    ovs_mutex_lock(&egress_mutex);
+    HMAP_FOR_EACH_WITH_HASH(egress, port_node, hash_int(hw_port, 0),
+                            &ops_egresses_by_port) {
+        if (egress->key.port != hw_port) {
+            continue;
+        }
+        if (link_up) {
+            ops_egress_port_restore(unit, egress);
+        } else {
+            ops_egress_port_prune(unit, egress);
+        }
+    }
+    ovs_mutex_unlock(&egress_mutex);
+} /* ops_routing_link_state_change */
+
+/* Rewrite the members of an ecmp group in place, every route using the
+ * group follows without being reprogrammed. */
+static int
+ops_ecmp_group_rewrite(int hw_unit, struct ops_ecmp_group *grp,
+                       opennsl_if_t *egress_ids, int n_egress)
+{
+    int rc;
+
+    rc = ops_ecmp_group_program(hw_unit, grp, egress_ids, n_egress, true);
+    if (OPENNSL_FAILURE(rc)) {
+        return rc;
+    }
+
+    hmap_remove(&ops_ecmp_groups, &grp->node);
+    hmap_insert(&ops_ecmp_groups, &grp->node,
+                ops_ecmp_group_hash(egress_ids, n_egress));
+
+    return rc;
+} /* ops_ecmp_group_rewrite */
+
+/* Take a reference on the ecmp group matching the route nexthops.
+ * A group with the same egress set is shared between routes. When the
+ * route is the only user of its current group and no matching group
+ * exists, the current group is rewritten in place instead of allocating
+ * another ecmp object. The caller releases the previous group of the
+ * route once the route points to the returned group in the ASIC. */
+static int
+ops_ecmp_group_acquire(int hw_unit, struct ops_route *routep,
+                       struct ops_ecmp_group **grpp)
+{
+    opennsl_if_t egress_ids[OPS_ECMP_MAX_MEMBERS];
+    struct ops_ecmp_group *grp;
+    char buf[IPV6_BUFFER_LEN];
+    int n_egress;
+    int rc;
+
+    n_egress = ops_route_egress_ids(routep, egress_ids);
+
+    grp = ops_ecmp_group_lookup(egress_ids, n_egress);
+    if (grp) {
+        grp->refcnt++;
+        *grpp = grp;
+        return 0;
+    }
+
+    grp = routep->ecmp_grp;
+    if (grp && (grp->refcnt == 1)) {
+        rc = ops_ecmp_group_rewrite(hw_unit, grp, egress_ids, n_egress);
+        if (OPENNSL_FAILURE(rc)) {
+            VLOG_ERR("Failed to update ecmp object for route %s: rc=%s",
+                     ops_route_key_to_string(&routep->key, buf, sizeof(buf)),
+                     opennsl_errmsg(rc));
+            return rc;
+        }
+        grp->refcnt++;
+        *grpp = grp;
+        return 0;
+    }
+
+    grp = xzalloc(sizeof(*grp));
+    list_init(&grp->members);
+    rc = ops_ecmp_group_program(hw_unit, grp, egress_ids, n_egress, false);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to create ecmp object for route %s: rc=%s",
+                 ops_route_key_to_string(&routep->key, buf, sizeof(buf)),
+                 opennsl_errmsg(rc));
+        free(grp);
+        return rc;
+    }
+    VLOG_DBG("Created ecmp object %d with %d egress objects",
+             grp->ecmp_intf, n_egress);
+
+    hmap_insert(&ops_ecmp_groups, &grp->node,
+                ops_ecmp_group_hash(egress_ids, n_egress));
+    grp->refcnt++;
+
+    *grpp = grp;
+    return 0;
+} /* ops_ecmp_group_acquire */
+
+/* Destroy an ecmp group no route uses */
+static int
+ops_ecmp_group_destroy(int hw_unit, struct ops_ecmp_group *grp)
+{
+    int rc;
+
+    VLOG_DBG("Destroy ecmp object %d", grp->ecmp_intf);
+    hmap_remove(&ops_ecmp_groups, &grp->node);
+    ovs_mutex_lock(&egress_mutex);
+    rc = ops_delete_ecmp_object(hw_unit, grp->ecmp_intf);
+    if (OPENNSL_SUCCESS(rc)) {
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_ECMP_GROUP, -1);
+        ops_hw_table_update(hw_unit, OPS_HW_TABLE_ECMP_MEMBER,
+                            -(grp->n_egress - grp->n_down));
+    }
+    ops_ecmp_group_members_clear(grp);
+    ovs_mutex_unlock(&egress_mutex);
+    free(grp);
+
+    return rc;
+} /* ops_ecmp_group_destroy */
+
+/* Drop a reference on an ecmp group, the ecmp object in the ASIC is
+ * destroyed when the last route leaves the group. */
+static int
+ops_ecmp_group_release(int hw_unit, struct ops_ecmp_group *grp)
+{
+    if (!grp) {
+        return 0;
+    }
+
+    if (--grp->refcnt > 0) {
+        return 0;
+    }
+
+    return ops_ecmp_group_destroy(hw_unit, grp);
+} /* ops_ecmp_group_release */
+
+/* Fill the opennsl route which the asic should hold for a route.
+ * Returns false if the route has no nexthop to program. */
+static bool
+ops_route_to_l3_route(struct ops_route *ops_routep, opennsl_l3_route_t *routep)
+{
+    struct ops_nexthop *ops_nh;
+
+    opennsl_l3_route_t_init(routep);
+    ops_route_key_to_l3_route(&ops_routep->key, routep);
+
+    if (ops_routep->ecmp_grp) {
+        routep->l3a_intf = ops_routep->ecmp_grp->ecmp_intf;
+        routep->l3a_flags |= OPENNSL_L3_MULTIPATH;
+        return true;
+    }
+
+    HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
+        routep->l3a_intf = ops_nh->l3_egress_id;
+        return true;
+    }
+    return false;
+} /* ops_route_to_l3_route */
+
+/* Reprogram a route after the egress id of one of its nexthops changed */
+static int
+ops_route_refresh(int hw_unit, struct ops_route *ops_routep)
+{
+    struct ops_ecmp_group *old_grp = ops_routep->ecmp_grp;
+    struct ops_ecmp_group *ecmp_grp = NULL;
+    opennsl_l3_route_t route;
+    char buf[IPV6_BUFFER_LEN];
+    int rc;
+
+    if (old_grp) {
+        rc = ops_ecmp_group_acquire(hw_unit, ops_routep, &ecmp_grp);
+        if (OPS_FAILURE(rc)) {
+            return rc;
+        }
+        if (ecmp_grp == old_grp) {
+            /* group rewritten in place, nothing to do for the route */
+            ops_ecmp_group_release(hw_unit, ecmp_grp);
+            return 0;
+        }
+        ops_routep->ecmp_grp = ecmp_grp;
+    }
+
+    if (!ops_route_to_l3_route(ops_routep, &route)) {
+        return 0;
+    }
+    route.l3a_flags |= OPENNSL_L3_REPLACE;
+
+    rc = ops_route_hw_add(hw_unit, ops_routep, &route);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to refresh route %s: %s",
+                 ops_route_key_to_string(&ops_routep->key, buf, sizeof(buf)),
+                 opennsl_errmsg(rc));
+        if (old_grp) {
+            ops_routep->ecmp_grp = old_grp;
+            ops_ecmp_group_release(hw_unit, ecmp_grp);
+        }
+        return rc;
+    }
+
+    ops_ecmp_group_release(hw_unit, old_grp);
+    return rc;
+} /* ops_route_refresh */
+
+/* Sort routes by ecmp group */
+static int
+ops_route_grp_cmp(const void *a, const void *b)
+{
+    uintptr_t grp1 = (uintptr_t)(*(struct ops_route * const *)a)->ecmp_grp;
+    uintptr_t grp2 = (uintptr_t)(*(struct ops_route * const *)b)->ecmp_grp;
+
+    return (grp1 > grp2) - (grp1 < grp2);
+} /* ops_route_grp_cmp */
+
+/* Point every route using a nexthop to a new egress object. When all the
+ * routes sharing an ecmp group move the same way, the group is rewritten
+ * once in place, so the cost is one SDK call per affected ecmp group plus
+ * one per affected non-ecmp route. */
+static int
+ops_nexthop_egress_set(int hw_unit, int vrf, const char *id,
+                       opennsl_if_t l3_egress_id)
+{
+    opennsl_if_t egress_ids[OPS_ECMP_MAX_MEMBERS];
+    opennsl_if_t other_ids[OPS_ECMP_MAX_MEMBERS];
+    struct ops_vrf_nexthop *vrf_nh;
+    struct ops_ecmp_group *grp;
+    struct ops_route **routes;
+    struct ops_nexthop *nh;
+    bool same;
+    int n_routes = 0;
+    int n_egress;
+    int ret = 0;
+    int rc;
+    int i, j, k;
+
+    vrf_nh = ops_vrf_nexthop_lookup(vrf, id);
+    if (!vrf_nh) {
+        return 0;
+    }
+
+    routes = xmalloc(list_size(&vrf_nh->nexthops) * sizeof(*routes));
+    LIST_FOR_EACH (nh, vrf_nh_node, &vrf_nh->nexthops) {
+        if (nh->l3_egress_id != l3_egress_id) {
+            ops_nexthop_egress_id_set(nh, l3_egress_id);
+            routes[n_routes++] = nh->route;
+        }
+    }
+
+    VLOG_DBG("Nexthop %s vrf %d moved to egress %d, %d routes", id, vrf,
+             l3_egress_id, n_routes);
+
+    qsort(routes, n_routes, sizeof(*routes), ops_route_grp_cmp);
+
+    for (i = 0; i < n_routes; i = j) {
+        grp = routes[i]->ecmp_grp;
+
+        /* routes[i..j-1] share the same ecmp group */
+        for (j = i + 1; (j < n_routes) && (routes[j]->ecmp_grp == grp); j++) {
+        }
+
+        if (grp && ((j - i) == grp->refcnt)) {
+            n_egress = ops_route_egress_ids(routes[i], egress_ids);
+            same = true;
+            for (k = i + 1; same && (k < j); k++) {
+                same = (ops_route_egress_ids(routes[k], other_ids) == n_egress)
+                       && (memcmp(egress_ids, other_ids,
+                                  n_egress * sizeof(opennsl_if_t)) == 0);
+            }
+            if (same && !ops_ecmp_group_lookup(egress_ids, n_egress)) {
+                rc = ops_ecmp_group_rewrite(hw_unit, grp, egress_ids,
+                                            n_egress);
+                if (OPENNSL_SUCCESS(rc)) {
+                    continue;
+                }
+                VLOG_ERR("Failed to update ecmp object %d: %s",
+                         grp->ecmp_intf, opennsl_errmsg(rc));
+            }
+        }
+
+        for (k = i; k < j; k++) {
+            rc = ops_route_refresh(hw_unit, routes[k]);
+            if (OPS_FAILURE(rc)) {
+                ret = rc;
+            }
+        }
+    }
+
+    free(routes);
+    return ret;
+} /* ops_nexthop_egress_set */
+
+/* Set the weight of a nexthop in the ecmp groups of the routes using it.
+ * A weight of 1 restores plain ecmp for the nexthop. */
+int
+ops_routing_nexthop_weight_set(int hw_unit, int vrf, const char *id,
+                               int weight)
+{
+    struct ops_nexthop_weight *nh_weight;
+    struct ops_vrf_nexthop *vrf_nh;
+    struct ops_nexthop *nh;
+    int rc = 0;
+    int ret;
+
+    if ((weight < 1) || (weight > OPS_ECMP_MAX_MEMBERS)) {
+        VLOG_ERR("Invalid weight %d for nexthop %s", weight, id);
+        return EINVAL;
+    }
+
+    nh_weight = ops_nexthop_weight_lookup(vrf, id);
+    if ((nh_weight ? nh_weight->weight : 1) == weight) {
+        return 0;
+    }
+    if (weight == 1) {
+        hmap_remove(&ops_nexthop_weights, &nh_weight->node);
+        free(nh_weight->id);
+        free(nh_weight);
+    } else {
+        if (!nh_weight) {
+            nh_weight = xzalloc(sizeof(*nh_weight));
+            nh_weight->vrf = vrf;
+            nh_weight->id = xstrdup(id);
+            hmap_insert(&ops_nexthop_weights, &nh_weight->node,
+                        hash_string(id, vrf));
+        }
+        nh_weight->weight = weight;
+    }
+
+    /* reprogram the ecmp routes using the nexthop */
+    vrf_nh = ops_vrf_nexthop_lookup(vrf, id);
+    if (!vrf_nh) {
+        return 0;
+    }
+    LIST_FOR_EACH (nh, vrf_nh_node, &vrf_nh->nexthops) {
+        if (nh->route->ecmp_grp) {
+            ret = ops_route_refresh(hw_unit, nh->route);
+            if (OPS_FAILURE(ret)) {
+                rc = ret;
+            }
+        }
+    }
+    return rc;
+} /* ops_routing_nexthop_weight_set */
+
+/* Set the maximum number of members of a weighted ecmp group. Weights
+ * are scaled down to fit. */
+int
+ops_routing_ecmp_max_members_set(int hw_unit, int max_members)
+{
+    struct ops_route_table *rtable;
+    struct ops_route *ops_routep;
+    int rc = 0;
+    int ret;
+
+    if ((max_members < MAX_NEXTHOPS_PER_ROUTE) ||
+        (max_members > OPS_ECMP_MAX_MEMBERS)) {
+        VLOG_ERR("Invalid ecmp group size %d, range is %d to %d",
+                 max_members, MAX_NEXTHOPS_PER_ROUTE, OPS_ECMP_MAX_MEMBERS);
+        return EINVAL;
+    }
+    if (max_members == ecmp_max_members) {
+        return 0;
+    }
+    ecmp_max_members = max_members;
+
+    if (hmap_is_empty(&ops_nexthop_weights)) {
+        return 0;
+    }
+    HMAP_FOR_EACH(rtable, node, &ops_route_tables) {
+        HMAP_FOR_EACH(ops_routep, node, &rtable->routes) {
+            if (ops_routep->ecmp_grp) {
+                ret = ops_route_refresh(hw_unit, ops_routep);
+                if (OPS_FAILURE(ret)) {
+                    rc = ret;
+                }
+            }
+        }
+    }
+    return rc;
+} /* ops_routing_ecmp_max_members_set */
+
+/* Dump the nexthop weights */
+void
+ops_routing_wcmp_dump(struct ds *ds)
+{
+    struct ops_nexthop_weight *nh_weight;
+
+    ds_put_format(ds, "Maximum ecmp group size: %d\n", ecmp_max_members);
+    ds_put_format(ds, "%-6s %-45s %s\n", "VRF", "NEXTHOP", "WEIGHT");
+    HMAP_FOR_EACH(nh_weight, node, &ops_nexthop_weights) {
+        ds_put_format(ds, "%-6d %-45s %d\n", nh_weight->vrf, nh_weight->id,
+                      nh_weight->weight);
+    }
+} /* ops_routing_wcmp_dump */
+
+/* add or update ECMP or non-ECMP route */
+static int
+ops_add_route_entry(int hw_unit, opennsl_vrf_t vrf_id,
+                    const struct ops_route_key *key,
+                    struct ofproto_route *of_routep,
+                    opennsl_l3_route_t *routep)
+{
+    struct ops_route *ops_routep;
+    struct ops_nexthop *ops_nh;
+    struct ops_ecmp_group *ecmp_grp = NULL;
+    struct ops_stale_entry *stale = NULL;
+    struct hmap *stale_table = &ops_stale_routes;
+    opennsl_l3_host_t l3host;
+    opennsl_if_t old_ids[MAX_NEXTHOPS_PER_ROUTE];
+    enum ops_route_state old_rstate;
+    int rc;
+    bool add_route = false;
+
+    /* assert for zero nexthop */
+    assert(of_routep && (of_routep->n_nexthops > 0));
+
+    /* the route table mirrors the LPM table, no need to probe the asic */
+    ops_routep = ops_route_lookup(key);
+
+    /* new route */
+    if (!ops_routep) {
+        /* add the route in local data structure */
+        ops_routep = ops_route_add(key, of_routep);
+        /* create or get ecmp object */
+        if (ops_routep->n_nexthops > 1){
+            rc = ops_ecmp_group_acquire(hw_unit, ops_routep, &ecmp_grp);
+            if (OPS_FAILURE(rc)) {
+                /* keep the route table in sync with the asic */
+                ops_route_delete(ops_routep);
+                return rc;
+            }
+            routep->l3a_intf = ecmp_grp->ecmp_intf;
+            routep->l3a_flags |= OPENNSL_L3_MULTIPATH;
+        } else {
+            HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
+                routep->l3a_intf = ops_nh->l3_egress_id;
+            }
+        }
+        /* overwrite the route left by the previous run on a warm restart,
+         * in the table it was programmed in */
+        stale = ops_stale_lookup(&ops_stale_routes, key);
+        if (stale) {
+            ops_routep->in_host_table = false;
+            routep->l3a_flags |= OPENNSL_L3_REPLACE;
+        } else if (ops_routep->in_host_table) {
+            ops_l3_route_to_l3_host(routep, &l3host);
+            stale = ops_stale_host_lookup(&l3host);
+            if (stale) {
+                stale_table = &ops_stale_hosts;
+                routep->l3a_flags |= OPENNSL_L3_REPLACE;
+            }
+        }
+        add_route = true;
+    } else {
+        /* update route in local data structure */
+        ops_route_update_save(ops_routep, of_routep, old_ids);
+        ops_route_update(vrf_id, ops_routep, of_routep, false);
+
+        switch (ops_routep->rstate) {
+        case OPS_ROUTE_STATE_NON_ECMP:
+            /* if nexthops becomes more than 1 */
+            if (ops_routep->n_nexthops > 1) {
+                rc = ops_ecmp_group_acquire(hw_unit, ops_routep, &ecmp_grp);
+                if (OPS_FAILURE(rc)) {
+                    ops_route_update_undo(ops_routep, of_routep, old_ids);
+                    return rc;
+                }
+                routep->l3a_intf = ecmp_grp->ecmp_intf;
+                routep->l3a_flags |= (OPENNSL_L3_MULTIPATH |
+                                      OPENNSL_L3_REPLACE);
+            } else {
+                HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
+                    routep->l3a_intf = ops_nh->l3_egress_id;
+                    routep->l3a_flags &= ~OPENNSL_L3_MULTIPATH;
+                    routep->l3a_flags |= OPENNSL_L3_REPLACE;
+                }
+            }
+            break;
+        case OPS_ROUTE_STATE_ECMP:
+            /* ecmp route to non-ecmp route on replace */
+            if (ops_routep->n_nexthops < 2) {
+                HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
+                    routep->l3a_intf = ops_nh->l3_egress_id;
+                }
+                routep->l3a_flags &= ~OPENNSL_L3_MULTIPATH;
+                routep->l3a_flags |= OPENNSL_L3_REPLACE;
+                break;
+            }
+            /* move to the ecmp group of the updated nexthop set */
+            rc = ops_ecmp_group_acquire(hw_unit, ops_routep, &ecmp_grp);
+            if (OPS_FAILURE(rc)) {
+                ops_route_update_undo(ops_routep, of_routep, old_ids);
+                return rc;
+            }
+            routep->l3a_intf = ecmp_grp->ecmp_intf;
+            routep->l3a_flags |= (OPENNSL_L3_MULTIPATH |
+                                  OPENNSL_L3_REPLACE);
+            break;
+        default:
+            break;
+        }
+
+    }
+    old_rstate = ops_routep->rstate;
+    ops_routep->rstate = (ops_routep->n_nexthops > 1) ?
+                         OPS_ROUTE_STATE_ECMP : OPS_ROUTE_STATE_NON_ECMP;
+
+    rc = ops_route_hw_add(hw_unit, ops_routep, routep);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to %s route %s: %s",
+                  add_route ? "add" : "update", of_routep->prefix,
+                  opennsl_errmsg(rc));
+        ops_ecmp_group_release(hw_unit, ecmp_grp);
+        /* keep the route table in sync with the asic */
+        if (add_route) {
+            ops_route_delete(ops_routep);
+        } else {
+            ops_route_update_undo(ops_routep, of_routep, old_ids);
+            ops_routep->rstate = old_rstate;
+            /* a group the route was the only user of was rewritten in
+             * place, put its members back */
+            if (ecmp_grp && (ecmp_grp == ops_routep->ecmp_grp)) {
+                ops_route_refresh(hw_unit, ops_routep);
+            }
+        }
+        return rc;
+    }
+    if (stale) {
+        ops_stale_claim(stale_table, stale);
+    }
+
+    VLOG_DBG("Success to %s route %s: %s",
+              add_route ? "add" : "update", of_routep->prefix,
+              opennsl_errmsg(rc));
+
+    /* route now points to the new group, drop the old one */
+    ops_ecmp_group_release(hw_unit, ops_routep->ecmp_grp);
+    ops_routep->ecmp_grp = ecmp_grp;
+
+    return rc;
+} /* ops_add_route_entry */
+
+/* Delete a route entry */
+static int
+ops_delete_route_entry(int hw_unit, opennsl_vrf_t vrf_id,
+                       const struct ops_route_key *key,
+                       struct ofproto_route *of_routep,
+                       opennsl_l3_route_t *routep)
+{
+    struct ops_route *ops_routep;
+    struct ops_ecmp_group *ecmp_grp;
+    int rc;
+
+    assert(of_routep);
+
+    /* route lookup in local data structure */
+    ops_routep = ops_route_lookup(key);
+    if (!ops_routep) {
+        VLOG_ERR("Failed to get route %s", of_routep->prefix);
+        return EINVAL;
+    }
+
+    ecmp_grp = ops_routep->ecmp_grp;
+    rc = ops_route_hw_delete(hw_unit, ops_routep, routep);
+    ops_route_delete(ops_routep);
+
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to delete route %s: %s", of_routep->prefix,
+                  opennsl_errmsg(rc));
+        /* the asic route may still point to the group, keep it until the
+         * audit deleted the stale route */
+        if (ecmp_grp) {
+            ecmp_grp->refcnt--;
+        }
+        return rc;
+    }
+    VLOG_DBG("Success to delete route %s: %s", of_routep->prefix,
+             opennsl_errmsg(rc));
+
+    ops_ecmp_group_release(hw_unit, ecmp_grp);
+    return rc;
+} /* ops_delete_route_entry */
+
+/* Delete nexthop entry in route table */
+static int
+ops_delete_nh_entry(int hw_unit, opennsl_vrf_t vrf_id,
+                    const struct ops_route_key *key,
+                    struct ofproto_route *of_routep,
+                    opennsl_l3_route_t *routep)
+{
+    struct ops_route *ops_routep;
+    struct ops_nexthop *ops_nh;
+    struct ops_ecmp_group *ecmp_grp = NULL;
+    int rc;
+
+    /* assert for zero nexthop */
+    assert(of_routep && (of_routep->n_nexthops > 0));
+
+    /* route lookup in local data structure */
+    ops_routep = ops_route_lookup(key);
+    if (!ops_routep) {
+        VLOG_ERR("Failed to get route %s", of_routep->prefix);
+        return EINVAL;
+    }
+    ops_route_update(vrf_id, ops_routep, of_routep, true);
+
+    /* no nexthop left, the asic keeps the route until it is deleted */
+    if (!ops_routep->n_nexthops) {
+        return 0;
+    }
+
+    switch (ops_routep->rstate) {
+    case OPS_ROUTE_STATE_NON_ECMP:
+        HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
+            routep->l3a_intf = ops_nh->l3_egress_id;
+            routep->l3a_flags &= ~OPENNSL_L3_MULTIPATH;
+            routep->l3a_flags |= OPENNSL_L3_REPLACE;
+        }
+        break;
+    case OPS_ROUTE_STATE_ECMP:
+        /* ecmp route to non-ecmp route*/
+        if (ops_routep->n_nexthops < 2) {
+            /* update with single nexthop, ecmp group is released below */
+            HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
+                routep->l3a_intf = ops_nh->l3_egress_id;
+            }
+            routep->l3a_flags &= ~OPENNSL_L3_MULTIPATH;
+            routep->l3a_flags |= OPENNSL_L3_REPLACE;
+        } else {
+            /* move to the ecmp group of the remaining nexthops */
+            rc = ops_ecmp_group_acquire(hw_unit, ops_routep, &ecmp_grp);
+            if (OPS_FAILURE(rc)) {
+                return rc;
+            }
+            routep->l3a_intf = ecmp_grp->ecmp_intf;
+            routep->l3a_flags |= (OPENNSL_L3_MULTIPATH |
+                                  OPENNSL_L3_REPLACE);
+        }
+        break;
+    default:
+        break;
+    }
+    ops_routep->rstate = (ops_routep->n_nexthops > 1) ?
+                          OPS_ROUTE_STATE_ECMP : OPS_ROUTE_STATE_NON_ECMP;
+
+    rc = ops_route_hw_add(hw_unit, ops_routep, routep);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to (delete NH) update route %s: %s",
+                  of_routep->prefix, opennsl_errmsg(rc));
+        ops_ecmp_group_release(hw_unit, ecmp_grp);
+        return rc;
+    } else {
+        VLOG_DBG("Success to (delete NH) update route %s: %s",
+                  of_routep->prefix, opennsl_errmsg(rc));
+    }
+
+    /* route now points to the new group, drop the old one */
+    rc = ops_ecmp_group_release(hw_unit, ops_routep->ecmp_grp);
+    ops_routep->ecmp_grp = ecmp_grp;
+
+    return rc;
+} /* ops_delete_nh_entry */
+
+/* update the error */
+static void
+ops_update_nexthop_error(int ret_code, struct ofproto_route *of_routep)
+{
+    char *error_str = NULL;
+    struct ofproto_route_nexthop *of_nh;
+
+    if (OPENNSL_FAILURE(ret_code)) {
+        error_str = opennsl_errmsg(ret_code);
+    } else {
+        error_str = strerror(ret_code);
+    }
+
+    for (int i = 0;  i < of_routep->n_nexthops; i++) {
+        of_nh = &of_routep->nexthops[i];
+        of_nh->err_str = error_str;
+        of_nh->rc = ret_code;
+    }
+}/* ops_update_nexthop_error */
+
+/* Parse the prefix of an ofproto route into a route key */
+static int
+ops_route_key_from_route(opennsl_vrf_t vrf_id, struct ofproto_route *routep,
+                         struct ops_route_key *key)
+{
+    int rc;
+
+    switch (routep->family) {
+    case OFPROTO_ROUTE_IPV4:
+        rc = ops_route_key_from_string(vrf_id, AF_INET, routep->prefix,
+                                       key);
+        if (rc) {
+            VLOG_DBG("Invalid IPv4/Prefix");
+            return rc; /* Return error */
+        }
+        break;
+    case OFPROTO_ROUTE_IPV6:
+        rc = ops_route_key_from_string(vrf_id, AF_INET6, routep->prefix,
+                                       key);
+        if (rc) {
+            VLOG_DBG("Invalid IPv6/Prefix");
+            return rc; /* Return error */
+        }
+        break;
+     default:
+        VLOG_ERR ("Unknown protocol %d", routep->family);
+        return EINVAL;
+
+    }
+    return 0;
+} /* ops_route_key_from_route */
+
+/* Program one route action in the ASIC */
+static int
+ops_route_entry_apply(int hw_unit, opennsl_vrf_t vrf_id,
+                      enum ofproto_route_action action,
+                      const struct ops_route_key *key,
+                      struct ofproto_route *routep)
+{
+    int rc = 0;
+    opennsl_l3_route_t route;
+    enum ops_l3_perf_op op;
+    uint64_t start = ops_l3_perf_now();
+
+    opennsl_l3_route_t_init(&route);
+    ops_route_key_to_l3_route(key, &route);
+
+    VLOG_DBG("action: %d, vrf: %d, prefix: %s, nexthops: %d",
+              action, vrf_id, routep->prefix, routep->n_nexthops);
+
+    switch (action) {
+    case OFPROTO_ROUTE_ADD:
+        op = ops_route_lookup(key) ? OPS_L3_PERF_ROUTE_REPLACE :
+                                     OPS_L3_PERF_ROUTE_ADD;
+        rc = ops_add_route_entry(hw_unit, vrf_id, key, routep, &route);
+        break;
+    case OFPROTO_ROUTE_DELETE:
+        op = OPS_L3_PERF_ROUTE_DELETE;
+        rc = ops_delete_route_entry(hw_unit, vrf_id, key, routep, &route);
+        break;
+    case OFPROTO_ROUTE_DELETE_NH:
+        op = OPS_L3_PERF_ROUTE_REPLACE;
+        rc = ops_delete_nh_entry(hw_unit, vrf_id, key, routep, &route);
+        break;
+    default:
+        VLOG_ERR("Unknown route action %d", action);
+        return EINVAL;
+    }
+
+    ops_l3_perf_record(op, start, OPS_FAILURE(rc));
+    return rc;
+} /* ops_route_entry_apply */
+
+/* Add, delete route and nexthop */
+int
+ops_routing_route_entry_action(int hw_unit,
+                               opennsl_vrf_t vrf_id,
+                               enum ofproto_route_action action,
+                               struct ofproto_route *routep)
+{
+    int rc = 0;
+    struct ops_route_key key;
+
+    VLOG_DBG("%s: vrfid: %d, action: %d", __FUNCTION__, vrf_id, action);
+
+    if (!routep && !routep->n_nexthops) {
+        VLOG_ERR("route/nexthop entry null");
+        return EINVAL; /* Return error */
+    }
+
+    rc = ops_route_key_from_route(vrf_id, routep, &key);
+    if (rc) {
+        return rc;
+    }
+
+    rc = ops_route_entry_apply(hw_unit, vrf_id, action, &key, routep);
+
+    if ((action == OFPROTO_ROUTE_ADD) && OPS_FAILURE(rc)) {
+        /* upadate the next hops error */
+        ops_update_nexthop_error(rc, routep);
+    }
+
+    /* destroy the egress objects the route was the last user of */
+    ops_egress_gc();
+    return rc;
+} /* ops_routing_route_entry_action */
+
+struct ops_route_audit {
+    bool repair;
+    int checked;                    /* routes in the route table */
+    int missing;                    /* not in the asic */
+    int mismatch;                   /* other egress object in the asic */
+    int stale;                      /* in the asic only */
+    int n_stale_routes;
+    opennsl_l3_route_t *stale_routes;
+};
+
+/* Find asic routes which are not in the route table */
+static int
+ops_route_audit_cb(int unit, int index, opennsl_l3_route_t *info,
+                   void *user_data)
+{
+    struct ops_route_audit *audit = (struct ops_route_audit *)user_data;
+    struct ops_route_key key;
+
+    ops_route_key_from_l3_route(info, &key);
+    if (ops_route_lookup(&key)) {
+        return OPENNSL_E_NONE;
+    }
+
+    audit->stale++;
+    if (audit->repair) {
+        audit->stale_routes = xrealloc(audit->stale_routes,
+                                       (audit->n_stale_routes + 1) *
+                                       sizeof(opennsl_l3_route_t));
+        audit->stale_routes[audit->n_stale_routes++] = *info;
+    }
+    return OPENNSL_E_NONE;
+} /* ops_route_audit_cb */
+
+/* Compare the route table with the LPM table in the asic. The route
+ * table is authoritative: with repair set, routes missing or pointing to
+ * another egress object are reprogrammed, and asic routes unknown to the
+ * route table are deleted. */
+int
+ops_routing_route_audit(int hw_unit, struct ds *ds, bool repair)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+    struct ops_route_table *rtable;
+    struct ops_route *ops_routep;
+    struct ops_route_audit audit;
+    struct ops_ecmp_group *grp, *next_grp;
+    opennsl_l3_route_t sw_route;
+    opennsl_l3_route_t hw_route;
+    opennsl_l3_info_t l3_hw_status;
+    char buf[IPV6_BUFFER_LEN];
+    bool stale_left = false;
+    int rc;
+    int i;
 
-    /* Return error other than found / not found */
-    if ((rc != OPENNSL_E_NOT_FOUND) &&
-        (OPENNSL_FAILURE(rc))) {
-        VLOG_ERR("Route lookup error: %s", opennsl_errmsg(rc));
-        return rc;
-    }
+    memset(&audit, 0, sizeof(audit));
+    audit.repair = repair;
 
-    /* new route */
-    if (rc == OPENNSL_E_NOT_FOUND){
-        /* add the route in local data structure */
-        ops_routep = ops_route_add(vrf_id, of_routep);
-        /* create or get ecmp object */
-        if (ops_routep->n_nexthops > 1){
-            rc = ops_create_or_update_ecmp_object(hw_unit, ops_routep,
-                                                 &l3_intf, false);
-            if (OPS_FAILURE(rc)) {
-                return rc;
+    /* the routes of destroyed vrfs may still be queued for deletion */
+    ops_hw_queue_flush();
+
+    HMAP_FOR_EACH(rtable, node, &ops_route_tables) {
+        HMAP_FOR_EACH(ops_routep, node, &rtable->routes) {
+            /* compressed away, forwarded by a covering route */
+            if (ops_routep->fib_node && !ops_routep->fib_node->installed) {
+                continue;
             }
-            routep->l3a_intf = l3_intf;
-            routep->l3a_flags |= OPENNSL_L3_MULTIPATH;
-        } else {
-            HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
-                routep->l3a_intf = ops_nh->l3_egress_id;
+            if (!ops_route_to_l3_route(ops_routep, &sw_route)) {
+                continue;
             }
-        }
-        add_route = true;
-    } else {
-        /* update route in local data structure */
-        ops_routep = ops_route_lookup(vrf_id, of_routep);
-        if (!ops_routep) {
-            VLOG_ERR("Failed to find route %s", of_routep->prefix);
-            return EINVAL;
-        }
+            audit.checked++;
 
-        ops_route_update(vrf_id, ops_routep, of_routep, false);
+            rc = ops_route_hw_get(hw_unit, ops_routep, &hw_route);
+            if (rc == OPENNSL_E_NOT_FOUND) {
+                audit.missing++;
+            } else if (OPENNSL_FAILURE(rc)) {
+                VLOG_ERR("Route lookup error: %s", opennsl_errmsg(rc));
+                return rc;
+            } else if ((hw_route.l3a_intf == sw_route.l3a_intf) &&
+                       ((hw_route.l3a_flags & OPENNSL_L3_MULTIPATH) ==
+                        (sw_route.l3a_flags & OPENNSL_L3_MULTIPATH))) {
+                continue;
+            } else {
+                audit.mismatch++;
+                sw_route.l3a_flags |= OPENNSL_L3_REPLACE;
+            }
 
-        switch (ops_routep->rstate) {
-        case OPS_ROUTE_STATE_NON_ECMP:
-            /* if nexthops becomes more than 1 */
-            if (ops_routep->n_nexthops > 1) {
-                rc = ops_create_or_update_ecmp_object(hw_unit, ops_routep,
-                                                     &l3_intf, false);
-                if (OPS_FAILURE(rc)) {
-                    VLOG_ERR("Failed to create ecmp object for route %s: %s",
-                              ops_routep->prefix, opennsl_errmsg(rc));
-                    return rc;
+            VLOG_WARN_RL(&rl, "Route %s %s in asic",
+                         ops_route_key_to_string(&ops_routep->key, buf,
+                                                 sizeof(buf)),
+                         (rc == OPENNSL_E_NOT_FOUND) ? "missing" : "differs");
+
+            if (repair) {
+                if (ops_routep->fib_node) {
+                    ops_routep->fib_node->installed =
+                                        (rc != OPENNSL_E_NOT_FOUND);
+                    rc = ops_fib_program(rtable, ops_routep->fib_node, true);
+                } else {
+                    rc = ops_route_hw_add(hw_unit, ops_routep, &sw_route);
                 }
-                routep->l3a_intf = l3_intf;
-                routep->l3a_flags |= (OPENNSL_L3_MULTIPATH |
-                                      OPENNSL_L3_REPLACE);
-            } else {
-                HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
-                    routep->l3a_intf = ops_nh->l3_egress_id;
-                    routep->l3a_flags &= ~OPENNSL_L3_MULTIPATH;
-                    routep->l3a_flags |= OPENNSL_L3_REPLACE;
+                if (OPENNSL_FAILURE(rc)) {
+                    VLOG_ERR("Failed to repair route %s: %s",
+                             ops_route_key_to_string(&ops_routep->key, buf,
+                                                     sizeof(buf)),
+                             opennsl_errmsg(rc));
                 }
             }
-            break;
-        case OPS_ROUTE_STATE_ECMP:
-            /* update the ecmp table */
-            l3_intf = routep->l3a_intf;
-            rc = ops_create_or_update_ecmp_object(hw_unit, ops_routep,
-                                                 &l3_intf, true);
-            if (OPS_FAILURE(rc)) {
-                VLOG_ERR("Failed to update ecmp object for route %s: %s",
-                         ops_routep->prefix, opennsl_errmsg(rc));
-                return rc;
+        }
+    }
+
+    rc = opennsl_l3_info(hw_unit, &l3_hw_status);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Error in L3 info access: %s", opennsl_errmsg(rc));
+        return rc;
+    }
+
+    opennsl_l3_route_traverse(hw_unit, 0, 0, l3_hw_status.l3info_max_route,
+                              &ops_route_audit_cb, &audit);
+    opennsl_l3_route_traverse(hw_unit, OPENNSL_L3_IP6, 0,
+                              l3_hw_status.l3info_max_route,
+                              &ops_route_audit_cb, &audit);
+
+    for (i = 0; i < audit.n_stale_routes; i++) {
+        rc = ops_route_lpm_delete(hw_unit, &audit.stale_routes[i]);
+        if (OPENNSL_FAILURE(rc)) {
+            VLOG_ERR("Failed to delete stale route: %s", opennsl_errmsg(rc));
+            stale_left = true;
+        }
+    }
+    free(audit.stale_routes);
+
+    /* ecmp groups kept after their last route failed to be deleted, no
+     * asic route uses them any more. The groups taken over on a warm
+     * restart are left to the end of the reconciliation. */
+    if (repair && !stale_left && !reconcile_active) {
+        HMAP_FOR_EACH_SAFE (grp, next_grp, node, &ops_ecmp_groups) {
+            if (!grp->refcnt) {
+                ops_ecmp_group_destroy(hw_unit, grp);
             }
-            routep->l3a_flags |= (OPENNSL_L3_MULTIPATH |
-                                  OPENNSL_L3_REPLACE);
-            break;
-        default:
-            break;
         }
+    }
 
+    if (audit.missing || audit.mismatch || audit.stale) {
+        VLOG_WARN_RL(&rl, "Route audit: %d missing, %d mismatched, "
+                     "%d stale routes%s", audit.missing, audit.mismatch,
+                     audit.stale, repair ? ", repaired" : "");
     }
-    ops_routep->rstate = (ops_routep->n_nexthops > 1) ?
-                         OPS_ROUTE_STATE_ECMP : OPS_ROUTE_STATE_NON_ECMP;
 
-    rc = opennsl_l3_route_add(hw_unit, routep);
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Failed to %s route %s: %s",
-                  add_route ? "add" : "update", of_routep->prefix,
-                  opennsl_errmsg(rc));
-    } else {
-        VLOG_DBG("Success to %s route %s: %s",
-                  add_route ? "add" : "update", of_routep->prefix,
-                  opennsl_errmsg(rc));
+    if (ds) {
+        ds_put_format(ds, "Routes checked   : %d\n", audit.checked);
+        ds_put_format(ds, "Missing in ASIC  : %d\n", audit.missing);
+        ds_put_format(ds, "Mismatched       : %d\n", audit.mismatch);
+        ds_put_format(ds, "Stale in ASIC    : %d\n", audit.stale);
+        if (repair) {
+            ds_put_format(ds, "Repaired\n");
+        }
     }
-    return rc;
-} /* ops_add_route_entry */
 
-/* Delete a route entry */
-static int
-ops_delete_route_entry(int hw_unit, opennsl_vrf_t vrf_id,
-                       struct ofproto_route *of_routep,
-                       opennsl_l3_route_t *routep)
+    return 0;
+} /* ops_routing_route_audit */
+
+/* Set the periodic route audit interval, 0 disables it */
+void
+ops_routing_route_audit_set_interval(int seconds)
 {
-    struct ops_route *ops_routep;
-    opennsl_if_t l3_intf ;
-    bool is_delete_ecmp = false;
-    int rc;
+    route_audit_interval = (seconds > 0) ? (long long int)seconds * 1000 : 0;
+    route_audit_next = time_msec() + route_audit_interval;
+} /* ops_routing_route_audit_set_interval */
 
-    assert(of_routep);
+int
+ops_routing_route_audit_get_interval(void)
+{
+    return route_audit_interval / 1000;
+} /* ops_routing_route_audit_get_interval */
 
-    /* look for prefix in LPM table*/
-    rc = opennsl_l3_route_get(hw_unit, routep);
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Route lookup error: %s", opennsl_errmsg(rc));
-        return rc;
+/* Run the periodic route audit, repairing the asic if needed */
+void
+ops_routing_route_audit_run(void)
+{
+    long long int now;
+
+    /* routes of the previous run are not known until it is reconciled */
+    if (!route_audit_interval || reconcile_active) {
+        return;
     }
 
-    /* route lookup in local data structure */
-    ops_routep = ops_route_lookup(vrf_id, of_routep);
-    if (!ops_routep) {
-        VLOG_ERR("Failed to get route %s", of_routep->prefix);
-        return EINVAL;
+    now = time_msec();
+    if (now < route_audit_next) {
+        return;
     }
+    route_audit_next = now + route_audit_interval;
 
-    ops_route_delete(ops_routep);
+    ops_routing_route_audit(0, NULL, true);
+} /* ops_routing_route_audit_run */
+
+void
+ops_routing_route_audit_wait(void)
+{
+    if (route_audit_interval) {
+        poll_timer_wait_until(route_audit_next);
+    }
+} /* ops_routing_route_audit_wait */
+
+struct ops_reconcile {
+    bool have_local_nhid;
+    int n_egress;
+    int n_ecmp;
+};
+
+/* Take over a neighbor egress object of the previous run, and its egress
+ * object for unresolved NH */
+static int
+ops_reconcile_egress_cb(int unit, opennsl_if_t egress_id,
+                        opennsl_l3_egress_t *info, void *user_data)
+{
+    struct ops_reconcile *reconcile = (struct ops_reconcile *)user_data;
+    struct ops_egress_key key;
+    opennsl_l3_intf_t l3_intf;
+    opennsl_error_t rc;
 
-    if (routep->l3a_flags & OPENNSL_L3_MULTIPATH) {
-        l3_intf = routep->l3a_intf;
-        is_delete_ecmp = true;
+    if (info->flags & OPENNSL_L3_COPY_TO_CPU) {
+        if (!reconcile->have_local_nhid) {
+            local_nhid = egress_id;
+            reconcile->have_local_nhid = true;
+        }
+        return OPENNSL_E_NONE;
     }
 
-    rc = opennsl_l3_route_delete(hw_unit, routep);
+    /* the vlan of the neighbor is the one of its l3 interface */
+    opennsl_l3_intf_t_init(&l3_intf);
+    l3_intf.l3a_intf_id = info->intf;
+    rc = opennsl_l3_intf_get(unit, &l3_intf);
     if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Failed to delete route %s: %s", of_routep->prefix,
-                  opennsl_errmsg(rc));
-    } else {
-        VLOG_DBG("Success to delete route %s: %s", of_routep->prefix,
-                 opennsl_errmsg(rc));
+        VLOG_WARN("No l3 interface %d for egress object %d, not taken over",
+                  info->intf, egress_id);
+        return OPENNSL_E_NONE;
     }
 
-    if (is_delete_ecmp) {
-        rc = ops_delete_ecmp_object(hw_unit, l3_intf);
+    memset(&key, 0, sizeof(key));
+    key.intf = info->intf;
+    key.port = info->port;
+    key.vlan = l3_intf.l3a_vid;
+    memcpy(key.mac, info->mac_addr, ETH_ALEN);
+    ops_egress_insert(unit, &key, egress_id);
+    reconcile->n_egress++;
+
+    return OPENNSL_E_NONE;
+} /* ops_reconcile_egress_cb */
+
+/* Take over an ecmp group of the previous run, with no route using it */
+static int
+ops_reconcile_ecmp_cb(int unit, opennsl_l3_egress_ecmp_t *ecmp,
+                      int intf_count, opennsl_if_t *intf_array,
+                      void *user_data)
+{
+    struct ops_reconcile *reconcile = (struct ops_reconcile *)user_data;
+    struct ops_egress *egresses[OPS_ECMP_MAX_MEMBERS];
+    bool down[OPS_ECMP_MAX_MEMBERS];
+    struct ops_ecmp_group *grp;
+    int i;
+
+    if (intf_count > OPS_ECMP_MAX_MEMBERS) {
+        VLOG_WARN("Ecmp object %d has %d members, not taken over",
+                  ecmp->ecmp_intf, intf_count);
+        return OPENNSL_E_NONE;
     }
-    return rc;
-} /* ops_delete_route_entry */
 
-/* Delete nexthop entry in route table */
+    grp = xzalloc(sizeof(*grp));
+    list_init(&grp->members);
+    grp->ecmp_intf = ecmp->ecmp_intf;
+    grp->n_egress = intf_count;
+    grp->reconciled = true;
+    memcpy(grp->egress_ids, intf_array, intf_count * sizeof(opennsl_if_t));
+    qsort(grp->egress_ids, intf_count, sizeof(opennsl_if_t),
+          ops_egress_id_cmp);
+
+    memset(down, 0, sizeof(down));
+    for (i = 0; i < intf_count; i++) {
+        egresses[i] = ops_egress_lookup(grp->egress_ids[i]);
+    }
+    ops_ecmp_group_members_index(grp, egresses, down, intf_count);
+    hmap_insert(&ops_ecmp_groups, &grp->node,
+                ops_ecmp_group_hash(grp->egress_ids, intf_count));
+
+    ops_hw_table_update(unit, OPS_HW_TABLE_ECMP_GROUP, 1);
+    ops_hw_table_update(unit, OPS_HW_TABLE_ECMP_MEMBER, intf_count);
+    reconcile->n_ecmp++;
+
+    return OPENNSL_E_NONE;
+} /* ops_reconcile_ecmp_cb */
+
+/* Mark a host entry of the previous run stale */
 static int
-ops_delete_nh_entry(int hw_unit, opennsl_vrf_t vrf_id,
-                    struct ofproto_route *of_routep,
-                    opennsl_l3_route_t *routep)
+ops_reconcile_host_cb(int unit, int index, opennsl_l3_host_t *info,
+                      void *user_data)
 {
-    struct ops_route *ops_routep;
-    struct ops_nexthop *ops_nh;
-    opennsl_if_t l3_intf;
-    bool is_delete_ecmp = false;
-    int rc;
+    struct ops_stale_entry *entry;
 
-    /* assert for zero nexthop */
-    assert(of_routep && (of_routep->n_nexthops > 0));
+    entry = xzalloc(sizeof(*entry));
+    ops_host_key_from_l3_host(info, &entry->key);
+    entry->host = *info;
+    hmap_insert(&ops_stale_hosts, &entry->node, ops_route_hash(&entry->key));
 
-    /* look for prefix in LPM table*/
-    rc = opennsl_l3_route_get(hw_unit, routep);
+    return OPENNSL_E_NONE;
+} /* ops_reconcile_host_cb */
+
+/* Mark a route of the previous run stale */
+static int
+ops_reconcile_route_cb(int unit, int index, opennsl_l3_route_t *info,
+                       void *user_data)
+{
+    struct ops_stale_entry *entry;
+
+    entry = xzalloc(sizeof(*entry));
+    ops_route_key_from_l3_route(info, &entry->key);
+    entry->route = *info;
+    hmap_insert(&ops_stale_routes, &entry->node, ops_route_hash(&entry->key));
+
+    return OPENNSL_E_NONE;
+} /* ops_reconcile_route_cb */
+
+/* Read back the l3 tables left in the asic by the previous run on a warm
+ * restart. Egress objects and ecmp groups go to their caches unused, the
+ * hosts and routes to the stale tables, and all of them stay in the asic
+ * so that forwarding goes on during the configuration replay. Returns
+ * true if the egress object for unresolved NH was taken over. */
+static bool
+ops_reconcile_start(int unit)
+{
+    struct ops_reconcile reconcile;
+    opennsl_l3_info_t l3_hw_status;
+    opennsl_error_t rc;
 
-    /* Return error other than found / not found */
+    rc = opennsl_l3_info(unit, &l3_hw_status);
     if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Route lookup error: %s", opennsl_errmsg(rc));
-        return rc;
+        VLOG_ERR("Error in L3 info access: %s", opennsl_errmsg(rc));
+        return false;
     }
 
-    /* route lookup in local data structure */
-    ops_routep = ops_route_lookup(vrf_id, of_routep);
-    if (!ops_routep) {
-        VLOG_ERR("Failed to get route %s", of_routep->prefix);
-        return EINVAL;
+    memset(&reconcile, 0, sizeof(reconcile));
+    reconcile_active = true;
+    reconcile_unit = unit;
+    reconcile_start = time_msec();
+    reconcile_last_claim = 0;
+    reconcile_claimed = 0;
+    reconcile_ran = true;
+    reconcile_ecmp_reused = 0;
+
+    /* egress objects first, the ecmp groups are indexed by them */
+    ovs_mutex_lock(&egress_mutex);
+    rc = opennsl_l3_egress_traverse(unit, &ops_reconcile_egress_cb,
+                                    &reconcile);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to read the egress objects: %s", opennsl_errmsg(rc));
+    }
+    rc = opennsl_l3_egress_ecmp_traverse(unit, &ops_reconcile_ecmp_cb,
+                                         &reconcile);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to read the ecmp objects: %s", opennsl_errmsg(rc));
+    }
+    ovs_mutex_unlock(&egress_mutex);
+    reconcile_ecmp_taken = reconcile.n_ecmp;
+
+    rc = opennsl_l3_host_traverse(unit, 0, 0, l3_hw_status.l3info_max_host,
+                                  &ops_reconcile_host_cb, NULL);
+    if (OPENNSL_SUCCESS(rc)) {
+        rc = opennsl_l3_host_traverse(unit, OPENNSL_L3_IP6, 0,
+                                      l3_hw_status.l3info_max_host,
+                                      &ops_reconcile_host_cb, NULL);
+    }
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to read the host entries: %s", opennsl_errmsg(rc));
     }
-    ops_route_update(vrf_id, ops_routep, of_routep, true);
 
-    switch (ops_routep->rstate) {
-    case OPS_ROUTE_STATE_NON_ECMP:
-        HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
-            routep->l3a_intf = ops_nh->l3_egress_id;
-            routep->l3a_flags &= ~OPENNSL_L3_MULTIPATH;
-            routep->l3a_flags |= OPENNSL_L3_REPLACE;
+    rc = opennsl_l3_route_traverse(unit, 0, 0, l3_hw_status.l3info_max_route,
+                                   &ops_reconcile_route_cb, NULL);
+    if (OPENNSL_SUCCESS(rc)) {
+        rc = opennsl_l3_route_traverse(unit, OPENNSL_L3_IP6, 0,
+                                       l3_hw_status.l3info_max_route,
+                                       &ops_reconcile_route_cb, NULL);
+    }
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Failed to read the routes: %s", opennsl_errmsg(rc));
+    }
+
+    VLOG_INFO("Warm restart: %d egress objects, %d ecmp groups, "
+              "%zu hosts and %zu routes to reconcile",
+              reconcile.n_egress, reconcile.n_ecmp,
+              hmap_count(&ops_stale_hosts), hmap_count(&ops_stale_routes));
+
+    return reconcile.have_local_nhid;
+} /* ops_reconcile_start */
+
+/* End the warm restart reconciliation. The routes and hosts not claimed
+ * by the configuration replay are deleted, then the ecmp groups and
+ * egress objects left without user. */
+static void
+ops_reconcile_finish(void)
+{
+    struct ops_stale_entry *entry, *next;
+    struct ops_ecmp_group *grp, *next_grp;
+    struct ops_egress *egress;
+    int unit = reconcile_unit;
+    int n_routes = hmap_count(&ops_stale_routes);
+    int n_hosts = hmap_count(&ops_stale_hosts);
+    int n_ecmp = 0;
+    opennsl_error_t rc;
+
+    reconcile_active = false;
+
+    HMAP_FOR_EACH_SAFE (entry, next, node, &ops_stale_routes) {
+        rc = ops_route_lpm_delete(unit, &entry->route);
+        if (OPENNSL_FAILURE(rc) && (rc != OPENNSL_E_NOT_FOUND)) {
+            VLOG_ERR("Failed to delete stale route: %s", opennsl_errmsg(rc));
         }
-        break;
-    case OPS_ROUTE_STATE_ECMP:
-        /* ecmp route to non-ecmp route*/
-        if (ops_routep->n_nexthops < 2) {
-            /* delete ecmp table if route has single nexthop */
-            if (routep->l3a_flags & OPENNSL_L3_MULTIPATH) {
-                /* store intf to delete ecmp object */
-                l3_intf = routep->l3a_intf;
-                is_delete_ecmp = true;
-            }
-            /* update with single nexthop */
-            HMAP_FOR_EACH(ops_nh, node, &ops_routep->nexthops) {
-                routep->l3a_intf = ops_nh->l3_egress_id;
-            }
-            routep->l3a_flags &= ~OPENNSL_L3_MULTIPATH;
-            routep->l3a_flags |= OPENNSL_L3_REPLACE;
-        } else {
-            /* update the ecmp table */
-            l3_intf = routep->l3a_intf;
-            rc = ops_create_or_update_ecmp_object(hw_unit, ops_routep,
-                                                 &l3_intf, false);
-            if (OPS_FAILURE(rc)) {
-                VLOG_ERR("Failed to update ecmp object for route %s: %s",
-                              ops_routep->prefix, opennsl_errmsg(rc));
-                    return rc;
-                }
-                routep->l3a_flags |= (OPENNSL_L3_MULTIPATH |
-                                      OPENNSL_L3_REPLACE);
-            }
-            break;
-        default:
+        hmap_remove(&ops_stale_routes, &entry->node);
+        free(entry);
+    }
+
+    HMAP_FOR_EACH_SAFE (entry, next, node, &ops_stale_hosts) {
+        rc = opennsl_l3_host_delete(unit, &entry->host);
+        if (OPENNSL_SUCCESS(rc)) {
+            ops_hw_table_update(unit, OPS_HW_TABLE_HOST, -1);
+        } else if (rc != OPENNSL_E_NOT_FOUND) {
+            VLOG_ERR("Failed to delete stale host: %s", opennsl_errmsg(rc));
+        }
+        hmap_remove(&ops_stale_hosts, &entry->node);
+        free(entry);
+    }
+
+    HMAP_FOR_EACH_SAFE (grp, next_grp, node, &ops_ecmp_groups) {
+        if (!grp->refcnt) {
+            ops_ecmp_group_destroy(unit, grp);
+            n_ecmp++;
+        } else if (grp->reconciled) {
+            reconcile_ecmp_reused++;
+        }
+    }
+
+    /* egress objects no host, route or group took a reference on */
+    ovs_mutex_lock(&egress_mutex);
+    HMAP_FOR_EACH (egress, node, &ops_egresses) {
+        if (!egress->refcnt && list_is_empty(&egress->unused_node)) {
+            list_push_back(&ops_egresses_unused, &egress->unused_node);
+        }
+    }
+    ovs_mutex_unlock(&egress_mutex);
+    ops_egress_gc();
+
+    VLOG_INFO("Warm restart reconciled: %d entries kept, %d routes, "
+              "%d hosts and %d ecmp groups deleted", reconcile_claimed,
+              n_routes, n_hosts, n_ecmp);
+} /* ops_reconcile_finish */
+
+/* The reconciliation ends once the replay stopped claiming entries for
+ * a while, or after a bounded time if it claims none */
+static long long int
+ops_reconcile_deadline(void)
+{
+    long long int deadline = reconcile_start + OPS_RECONCILE_MAX_MSEC;
+
+    if (reconcile_last_claim) {
+        deadline = MIN(deadline,
+                       reconcile_last_claim + OPS_RECONCILE_IDLE_MSEC);
+    }
+    return deadline;
+} /* ops_reconcile_deadline */
+
+void
+ops_routing_reconcile_run(void)
+{
+    if (!reconcile_active) {
+        return;
+    }
+
+    /* done early once every host and route was claimed */
+    if ((reconcile_last_claim && hmap_is_empty(&ops_stale_hosts) &&
+         hmap_is_empty(&ops_stale_routes)) ||
+        (time_msec() >= ops_reconcile_deadline())) {
+        ops_reconcile_finish();
+    }
+} /* ops_routing_reconcile_run */
+
+void
+ops_routing_reconcile_wait(void)
+{
+    if (reconcile_active) {
+        poll_timer_wait_until(ops_reconcile_deadline());
+    }
+} /* ops_routing_reconcile_wait */
+
+/* End the warm restart reconciliation without waiting for the replay to
+ * settle */
+void
+ops_routing_reconcile_done(void)
+{
+    if (reconcile_active) {
+        ops_reconcile_finish();
+    }
+} /* ops_routing_reconcile_done */
+
+void
+ops_routing_reconcile_dump(struct ds *ds)
+{
+    struct ops_ecmp_group *grp;
+    int n_used = 0;
+
+    if (!reconcile_active) {
+        ds_put_format(ds, "No warm restart reconciliation in progress\n");
+        if (reconcile_ran) {
+            ds_put_format(ds, "Last warm restart reconciliation:\n");
+            ds_put_format(ds, "  ECMP taken over : %d\n",
+                          reconcile_ecmp_taken);
+            ds_put_format(ds, "  ECMP reused     : %d\n",
+                          reconcile_ecmp_reused);
+        }
+        return;
+    }
+
+    HMAP_FOR_EACH (grp, node, &ops_ecmp_groups) {
+        if (grp->reconciled && grp->refcnt) {
+            n_used++;
+        }
+    }
+
+    ds_put_format(ds, "Warm restart reconciliation in progress:\n");
+    ds_put_format(ds, "  Entries claimed : %d\n", reconcile_claimed);
+    ds_put_format(ds, "  Stale hosts     : %zu\n",
+                  hmap_count(&ops_stale_hosts));
+    ds_put_format(ds, "  Stale routes    : %zu\n",
+                  hmap_count(&ops_stale_routes));
+    ds_put_format(ds, "  ECMP taken over : %d\n", reconcile_ecmp_taken);
+    ds_put_format(ds, "  ECMP reused     : %d\n", n_used);
+    ds_put_format(ds, "  Ends in         : %lld msec\n",
+                  MAX(ops_reconcile_deadline() - time_msec(), 0));
+} /* ops_routing_reconcile_dump */
+
+/* A route of a destroyed vrf left the asic, release what it used */
+static void
+ops_route_flush_done(struct ops_hw_cmd *cmd)
+{
+    struct ops_route *routep = cmd->aux;
+    struct ops_ecmp_group *ecmp_grp = routep->ecmp_grp;
+
+    if (OPENNSL_SUCCESS(cmd->rc)) {
+        ops_route_table_update(cmd->hw_unit, &cmd->route, false, -1);
+    } else if (cmd->rc != OPENNSL_E_NOT_FOUND) {
+        VLOG_ERR("Failed to delete route of vrf %d: %s", routep->key.vrf,
+                 opennsl_errmsg(cmd->rc));
+    }
+
+    ops_route_free(routep);
+    ops_ecmp_group_release(cmd->hw_unit, ecmp_grp);
+    egress_gc_pending = true;
+} /* ops_route_flush_done */
+
+/* Delete up to 'budget' routes of a destroyed vrf from its table. The
+ * lpm routes are deleted from the asic by the programming thread, and
+ * keep their nexthops and ecmp group until then. Returns true once the
+ * table is empty. */
+static bool
+ops_route_table_flush(struct ops_route_table *rtable, int budget)
+{
+    struct ops_route *routep, *next;
+    struct ops_ecmp_group *ecmp_grp;
+    opennsl_l3_route_t route;
+    struct ops_hw_cmd cmd;
+    opennsl_error_t rc;
+
+    HMAP_FOR_EACH_SAFE (routep, next, node, &rtable->routes) {
+        if (!budget--) {
             break;
+        }
+
+        hmap_remove(&rtable->routes, &routep->node);
+
+        if (!routep->in_host_table &&
+            (!routep->fib_node || routep->fib_node->installed)) {
+            /* the whole vrf goes, nothing to expand */
+            ops_hw_cmd_init(&cmd, OPS_HW_CMD_ROUTE_DELETE, rtable->hw_unit);
+            opennsl_l3_route_t_init(&cmd.route);
+            ops_route_key_to_l3_route(&routep->key, &cmd.route);
+            cmd.done = ops_route_flush_done;
+            cmd.aux = routep;
+            ops_hw_queue_submit(&cmd);
+            continue;
+        }
+
+        if (routep->in_host_table) {
+            opennsl_l3_route_t_init(&route);
+            ops_route_key_to_l3_route(&routep->key, &route);
+            rc = ops_route_hw_delete(rtable->hw_unit, routep, &route);
+            if (OPENNSL_FAILURE(rc) && (rc != OPENNSL_E_NOT_FOUND)) {
+                VLOG_ERR("Failed to delete route of vrf %d: %s", rtable->vrf,
+                         opennsl_errmsg(rc));
+            }
+        }
+
+        ecmp_grp = routep->ecmp_grp;
+        ops_route_free(routep);
+        ops_ecmp_group_release(rtable->hw_unit, ecmp_grp);
+    }
+
+    /* destroy the egress objects used only by the deleted routes */
+    ops_egress_gc();
+
+    return hmap_is_empty(&rtable->routes);
+} /* ops_route_table_flush */
+
+static void
+ops_route_table_free(struct ops_route_table *rtable)
+{
+    list_remove(&rtable->dying_node);
+    hmap_destroy(&rtable->routes);
+    ops_fib_free(rtable->fib[0]);
+    ops_fib_free(rtable->fib[1]);
+    free(rtable);
+} /* ops_route_table_free */
+
+/* Create the route table of a vrf */
+struct ops_route_table *
+ops_routing_route_table_create(int hw_unit, opennsl_vrf_t vrf)
+{
+    struct ops_route_table *rtable, *next;
+
+    rtable = ops_route_table_lookup(vrf);
+    if (rtable) {
+        return rtable;
+    }
+
+    /* the routes of a previous vrf with the same id must be gone from
+     * the asic before the new vrf adds its own */
+    LIST_FOR_EACH_SAFE (rtable, next, dying_node, &ops_dying_route_tables) {
+        if (rtable->vrf == vrf) {
+            ops_route_table_flush(rtable, INT_MAX);
+            ops_route_table_free(rtable);
+        }
     }
-    ops_routep->rstate = (ops_routep->n_nexthops > 1) ?
-                          OPS_ROUTE_STATE_ECMP : OPS_ROUTE_STATE_NON_ECMP;
 
-    rc = opennsl_l3_route_add(hw_unit, routep);
-    if (OPENNSL_FAILURE(rc)) {
-        VLOG_ERR("Failed to (delete NH) update route %s: %s",
-                  of_routep->prefix, opennsl_errmsg(rc));
-        return rc;
-    } else {
-        VLOG_DBG("Success to (delete NH) update route %s: %s",
-                  of_routep->prefix, opennsl_errmsg(rc));
+    rtable = xzalloc(sizeof(*rtable));
+    rtable->vrf = vrf;
+    rtable->hw_unit = hw_unit;
+    hmap_init(&rtable->routes);
+    list_init(&rtable->dying_node);
+    list_init(&rtable->fib_recheck);
+    hmap_insert(&ops_route_tables, &rtable->node, hash_int(vrf, 0));
+
+    return rtable;
+} /* ops_routing_route_table_create */
+
+/* Destroy the route table of a vrf. The vrf has no route from now on,
+ * the routes are deleted from the asic by ops_routing_route_table_run()
+ * so that dropping a large vrf does not stall the main loop. */
+void
+ops_routing_route_table_destroy(struct ops_route_table *rtable)
+{
+    if (!rtable) {
+        return;
     }
 
-    if (is_delete_ecmp) {
-        rc = ops_delete_ecmp_object(hw_unit, l3_intf);
+    hmap_remove(&ops_route_tables, &rtable->node);
+    if (hmap_is_empty(&rtable->routes)) {
+        ops_route_table_free(rtable);
+        return;
     }
-    return rc;
-} /* ops_delete_nh_entry */
 
-/* update the error */
+    VLOG_DBG("Deleting %zu routes of vrf %d", hmap_count(&rtable->routes),
+             rtable->vrf);
+    list_push_back(&ops_dying_route_tables, &rtable->dying_node);
+} /* ops_routing_route_table_destroy */
+
+/* Delete a batch of routes of the destroyed vrfs */
+void
+ops_routing_route_table_run(void)
+{
+    struct ops_route_table *rtable;
+
+    if (egress_gc_pending) {
+        egress_gc_pending = false;
+        ops_egress_gc();
+    }
+
+    if (list_is_empty(&ops_dying_route_tables)) {
+        return;
+    }
+
+    rtable = CONTAINER_OF(list_front(&ops_dying_route_tables),
+                          struct ops_route_table, dying_node);
+    if (ops_route_table_flush(rtable, OPS_ROUTE_TABLE_FLUSH_BATCH)) {
+        ops_route_table_free(rtable);
+    }
+} /* ops_routing_route_table_run */
+
+void
+ops_routing_route_table_wait(void)
+{
+    if (!list_is_empty(&ops_dying_route_tables)) {
+        poll_immediate_wake();
+    }
+} /* ops_routing_route_table_wait */
+
+/* Build the compression tries of a vrf from its routes. The routes are
+ * all in the lpm, the redundant ones are queued for deletion. */
 static void
-ops_update_nexthop_error(int ret_code, struct ofproto_route *of_routep)
+ops_fib_build(struct ops_route_table *rtable)
 {
-    char *error_str = NULL;
-    struct ofproto_route_nexthop *of_nh;
+    struct ops_fib_node *node;
+    struct ops_route *routep;
+    opennsl_l3_route_t route;
+    int i;
 
-    if (OPENNSL_FAILURE(ret_code)) {
-        error_str = opennsl_errmsg(ret_code);
-    } else {
-        error_str = strerror(ret_code);
+    HMAP_FOR_EACH (routep, node, &rtable->routes) {
+        if (routep->in_host_table) {
+            continue;
+        }
+        /* a route left without nexthops keeps its last egress */
+        if (!ops_route_to_l3_route(routep, &route) &&
+            OPENNSL_FAILURE(ops_route_hw_get(rtable->hw_unit, routep,
+                                             &route))) {
+            continue;
+        }
+        node = ops_fib_insert(rtable, &routep->key);
+        node->is_route = true;
+        node->installed = true;
+        node->intf = route.l3a_intf;
+        node->multipath = !!(route.l3a_flags & OPENNSL_L3_MULTIPATH);
+        routep->fib_node = node;
     }
 
-    for (int i = 0;  i < of_routep->n_nexthops; i++) {
-        of_nh = &of_routep->nexthops[i];
-        of_nh->err_str = error_str;
-        of_nh->rc = ret_code;
+    for (i = 0; i < ARRAY_SIZE(rtable->fib); i++) {
+        ops_fib_queue_all(rtable, rtable->fib[i]);
     }
-}/* ops_update_nexthop_error */
+} /* ops_fib_build */
 
-/* Add, delete route and nexthop */
-int
-ops_routing_route_entry_action(int hw_unit,
-                               opennsl_vrf_t vrf_id,
-                               enum ofproto_route_action action,
-                               struct ofproto_route *routep)
+/* Program the redundant routes of a vrf and drop its compression tries */
+static int
+ops_fib_unbuild(struct ops_route_table *rtable)
 {
+    struct ops_route *routep;
     int rc = 0;
-    opennsl_l3_route_t route;
-    in_addr_t ipv4_addr;
-    struct in6_addr ipv6_addr;
-    uint8_t prefix_len;
+    int rc2;
 
-    VLOG_DBG("%s: vrfid: %d, action: %d", __FUNCTION__, vrf_id, action);
+    HMAP_FOR_EACH (routep, node, &rtable->routes) {
+        if (routep->fib_node && !routep->fib_node->installed) {
+            rc2 = ops_fib_program(rtable, routep->fib_node, true);
+            if (OPENNSL_FAILURE(rc2)) {
+                rc = rc2;
+            }
+        }
+    }
+    if (rc) {
+        /* keep the vrf compressed rather than lose routes */
+        return rc;
+    }
 
-    if (!routep && !routep->n_nexthops) {
-        VLOG_ERR("route/nexthop entry null");
-        return EINVAL; /* Return error */
+    HMAP_FOR_EACH (routep, node, &rtable->routes) {
+        routep->fib_node = NULL;
     }
+    list_init(&rtable->fib_recheck);
+    ops_fib_free(rtable->fib[0]);
+    ops_fib_free(rtable->fib[1]);
+    rtable->fib[0] = rtable->fib[1] = NULL;
+    return 0;
+} /* ops_fib_unbuild */
 
-    opennsl_l3_route_t_init(&route);
+/* Turn the fib compression of a vrf on or off */
+int
+ops_routing_fib_compress_set(opennsl_vrf_t vrf, bool enable)
+{
+    struct ops_route_table *rtable;
+    int rc;
 
-    switch (routep->family) {
-    case OFPROTO_ROUTE_IPV4:
-        rc = ops_string_to_prefix(AF_INET, routep->prefix, &ipv4_addr,
-                                  &prefix_len);
-        if (rc) {
-            VLOG_DBG("Invalid IPv4/Prefix");
-            return rc; /* Return error */
+    rtable = ops_route_table_lookup(vrf);
+    if (!rtable) {
+        return OPENNSL_E_NOT_FOUND;
+    }
+    if (rtable->compress == enable) {
+        return OPENNSL_E_NONE;
+    }
+    /* the stale entries of a warm restart are matched against the lpm */
+    if (reconcile_active) {
+        return OPENNSL_E_BUSY;
+    }
+
+    if (enable) {
+        ops_fib_build(rtable);
+    } else {
+        rc = ops_fib_unbuild(rtable);
+        if (OPENNSL_FAILURE(rc)) {
+            return rc;
         }
-        route.l3a_subnet = ipv4_addr;
-        route.l3a_ip_mask = opennsl_ip_mask_create(prefix_len);
-        break;
-    case OFPROTO_ROUTE_IPV6:
-        rc = ops_string_to_prefix(AF_INET6, routep->prefix, &ipv6_addr,
-                                  &prefix_len);
-        if (rc) {
-            VLOG_DBG("Invalid IPv6/Prefix");
-            return rc; /* Return error */
+    }
+    rtable->compress = enable;
+    VLOG_INFO("Fib compression %s for vrf %d", enable ? "enabled" : "disabled",
+              vrf);
+    return OPENNSL_E_NONE;
+} /* ops_routing_fib_compress_set */
+
+/* Delete a batch of the routes found redundant from the lpm */
+void
+ops_routing_fib_run(void)
+{
+    struct ops_route_table *rtable;
+    int budget = OPS_FIB_RECHECK_BATCH;
+
+    HMAP_FOR_EACH (rtable, node, &ops_route_tables) {
+        if (budget <= 0) {
+            break;
         }
-        route.l3a_flags |= OPENNSL_L3_IP6;
-        memcpy(route.l3a_ip6_net, &ipv6_addr, sizeof(struct in6_addr));
-        opennsl_ip6_mask_create(route.l3a_ip6_mask, prefix_len);
-        break;
-     default:
-        VLOG_ERR ("Unknown protocol %d", routep->family);
-        return EINVAL;
+        ops_fib_recheck(rtable, &budget);
+    }
+} /* ops_routing_fib_run */
 
+void
+ops_routing_fib_wait(void)
+{
+    struct ops_route_table *rtable;
+
+    HMAP_FOR_EACH (rtable, node, &ops_route_tables) {
+        if (!list_is_empty(&rtable->fib_recheck)) {
+            poll_immediate_wake();
+            return;
+        }
     }
-    route.l3a_vrf = vrf_id;
+} /* ops_routing_fib_wait */
 
-    VLOG_DBG("action: %d, vrf: %d, prefix: %s, nexthops: %d",
-              action, vrf_id, routep->prefix, routep->n_nexthops);
+struct ops_fib_stats {
+    int routes;
+    int installed;
+    int pending;
+};
 
-    switch (action) {
-    case OFPROTO_ROUTE_ADD:
-        rc = ops_add_route_entry(hw_unit, vrf_id, routep, &route);
-        break;
-    case OFPROTO_ROUTE_DELETE:
-        rc = ops_delete_route_entry(hw_unit, vrf_id, routep, &route);
-        break;
-    case OFPROTO_ROUTE_DELETE_NH:
-        rc = ops_delete_nh_entry(hw_unit, vrf_id, routep, &route);
-        break;
-    default:
-        VLOG_ERR("Unknown route action %d", action);
-        rc = EINVAL;
-        break;
+static void
+ops_fib_stats_get(const struct ops_fib_node *node,
+                  struct ops_fib_stats *stats)
+{
+    if (!node) {
+        return;
     }
+    if (node->is_route) {
+        stats->routes++;
+        stats->installed += node->installed;
+        stats->pending += !list_is_empty(&node->recheck_node);
+    }
+    ops_fib_stats_get(node->child[0], stats);
+    ops_fib_stats_get(node->child[1], stats);
+} /* ops_fib_stats_get */
 
-    if ((action == OFPROTO_ROUTE_ADD) && OPS_FAILURE(rc)) {
-        /* upadate the next hops error */
-        ops_update_nexthop_error(rc, routep);
+static void
+ops_fib_node_print(struct ds *ds, const struct ops_fib_node *node)
+{
+    char buf[IPV6_BUFFER_LEN];
+    int af = node->is_ipv6 ? AF_INET6 : AF_INET;
+
+    ds_put_format(ds, "%s/%d", inet_ntop(af, node->prefix, buf, sizeof(buf)),
+                  node->prefixlen);
+} /* ops_fib_node_print */
+
+/* Print the suppressed routes below a node with the lpm entry that
+ * forwards their traffic */
+static void
+ops_fib_suppressed_print(struct ds *ds, const struct ops_fib_node *node)
+{
+    const struct ops_fib_node *cover;
+
+    if (!node) {
+        return;
+    }
+    if (node->is_route && !node->installed) {
+        for (cover = ops_fib_cover(node); cover && !cover->installed;
+             cover = ops_fib_cover(cover)) {
+            continue;
+        }
+        ds_put_format(ds, "  ");
+        ops_fib_node_print(ds, node);
+        ds_put_format(ds, " covered by ");
+        if (cover) {
+            ops_fib_node_print(ds, cover);
+        } else {
+            ds_put_format(ds, "-");
+        }
+        ds_put_format(ds, "\n");
     }
+    ops_fib_suppressed_print(ds, node->child[0]);
+    ops_fib_suppressed_print(ds, node->child[1]);
+} /* ops_fib_suppressed_print */
 
-    return rc;
-} /* ops_routing_route_entry_action */
+void
+ops_routing_fib_dump(struct ds *ds, int vrf)
+{
+    struct ops_route_table *rtable;
+    struct ops_fib_stats stats;
+    int i;
+
+    ds_put_format(ds, "%-6s %-5s %10s %10s %10s %10s\n", "VRF", "Mode",
+                  "Routes", "Installed", "Suppressed", "Pending");
+    ds_put_format(ds, "------------------------------------------------"
+                  "--------------\n");
+    HMAP_FOR_EACH (rtable, node, &ops_route_tables) {
+        if ((vrf >= 0) && (rtable->vrf != vrf)) {
+            continue;
+        }
+        memset(&stats, 0, sizeof(stats));
+        for (i = 0; i < ARRAY_SIZE(rtable->fib); i++) {
+            ops_fib_stats_get(rtable->fib[i], &stats);
+        }
+        ds_put_format(ds, "%-6d %-5s %10d %10d %10d %10d\n", rtable->vrf,
+                      rtable->compress ? "on" : "off", stats.routes,
+                      stats.installed, stats.routes - stats.installed,
+                      stats.pending);
+
+        if (vrf >= 0) {
+            for (i = 0; i < ARRAY_SIZE(rtable->fib); i++) {
+                ops_fib_suppressed_print(ds, rtable->fib[i]);
+            }
+        }
+    }
+} /* ops_routing_fib_dump */
 
-/* FIXME : Remove once these macros are exposed by opennsl */
-#define opennslSwitchHashMultipath (135)
+/* FIXME : Remove once this macro is exposed by opennsl */
 #define OPENNSL_HASH_ZERO          0x00000001
 int
 ops_routing_ecmp_set(int hw_unit, bool enable)
@@ -1392,8 +4987,8 @@ ops_routing_ecmp_set(int hw_unit, bool enable)
     static int last_cfg;
     opennsl_error_t rc = OPENNSL_E_NONE;
 
-    rc = opennsl_switch_control_get(hw_unit, opennslSwitchHashMultipath,
-                                    &cur_cfg);
+    rc = ops_switch_control_get(hw_unit, opennslSwitchHashMultipath,
+                                &cur_cfg);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to get opennslSwitchHashMultipath : unit=%d, rc=%s",
                  hw_unit, opennsl_errmsg(rc));
@@ -1408,8 +5003,8 @@ ops_routing_ecmp_set(int hw_unit, bool enable)
 
     if (enable) { /* Enable ECMP */
         /* write back the config that existed before disabling */
-        rc = opennsl_switch_control_set(hw_unit, opennslSwitchHashMultipath,
-                                        last_cfg);
+        rc = ops_switch_control_set(hw_unit, opennslSwitchHashMultipath,
+                                    last_cfg);
         if (OPENNSL_FAILURE(rc)) {
             VLOG_ERR("Failed to set opennslSwitchHashMultipath : unit=%d, rc=%s",
                      hw_unit, opennsl_errmsg(rc));
@@ -1418,8 +5013,8 @@ ops_routing_ecmp_set(int hw_unit, bool enable)
     } else { /* Disable ECMP */
         /* save the current config before disabling */
         last_cfg = cur_cfg;
-        rc = opennsl_switch_control_set(hw_unit, opennslSwitchHashMultipath,
-                                        OPENNSL_HASH_ZERO);
+        rc = ops_switch_control_set(hw_unit, opennslSwitchHashMultipath,
+                                    OPENNSL_HASH_ZERO);
         if (OPENNSL_FAILURE(rc)) {
             VLOG_ERR("Failed to clear opennslSwitchHashMultipath : unit=%d, rc=%s",
                      hw_unit, opennsl_errmsg(rc));
@@ -1436,15 +5031,15 @@ ops_routing_ecmp_hash_set(int hw_unit, unsigned int hash, bool enable)
     int cur_hash_ip4 = 0, cur_hash_ip6 = 0;
     opennsl_error_t rc = OPENNSL_E_NONE;
 
-    rc = opennsl_switch_control_get(hw_unit, opennslSwitchHashIP4Field0,
-                                    &cur_hash_ip4);
+    rc = ops_switch_control_get(hw_unit, opennslSwitchHashIP4Field0,
+                                &cur_hash_ip4);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to get opennslSwitchHashIP4Field0 : unit=%d, rc=%s",
                  hw_unit, opennsl_errmsg(rc));
         return rc;
     }
-    rc = opennsl_switch_control_get(hw_unit, opennslSwitchHashIP6Field0,
-                                    &cur_hash_ip6);
+    rc = ops_switch_control_get(hw_unit, opennslSwitchHashIP6Field0,
+                                &cur_hash_ip6);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to get opennslSwitchHashIP6Field0 : unit=%d, rc=%s",
                  hw_unit, opennsl_errmsg(rc));
@@ -1468,6 +5063,13 @@ ops_routing_ecmp_hash_set(int hw_unit, unsigned int hash, bool enable)
         hash_v6 |= OPENNSL_HASH_FIELD_IP6DST_LO | OPENNSL_HASH_FIELD_IP6DST_HI;
     }
 
+    if (hash & OFPROTO_ECMP_HASH_RESILIENT) {
+        rc = ops_ecmp_resilient_set(hw_unit, enable);
+        if (OPENNSL_FAILURE(rc)) {
+            return rc;
+        }
+    }
+
     if (enable) {
         cur_hash_ip4 |= hash_v4;
         cur_hash_ip6 |= hash_v6;
@@ -1476,52 +5078,52 @@ ops_routing_ecmp_hash_set(int hw_unit, unsigned int hash, bool enable)
         cur_hash_ip6 &= ~hash_v6;
     }
 
-    rc = opennsl_switch_control_set(hw_unit,
-                                    opennslSwitchHashIP4TcpUdpPortsEqualField0,
-                                    cur_hash_ip4);
+    rc = ops_switch_control_set(hw_unit,
+                                opennslSwitchHashIP4TcpUdpPortsEqualField0,
+                                cur_hash_ip4);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP4TcpUdpPortsEqualField0:"
                  "unit=%d, hash=%x, rc=%s",
                  hw_unit, cur_hash_ip4, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(hw_unit,
-                                    opennslSwitchHashIP4TcpUdpField0,
-                                    cur_hash_ip4);
+    rc = ops_switch_control_set(hw_unit,
+                                opennslSwitchHashIP4TcpUdpField0,
+                                cur_hash_ip4);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP4TcpUdpPortsEqualField0:"
                  "unit=%d, hash=%x, rc=%s",
                  hw_unit, cur_hash_ip4, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(hw_unit, opennslSwitchHashIP4Field0,
-                                    cur_hash_ip4);
+    rc = ops_switch_control_set(hw_unit, opennslSwitchHashIP4Field0,
+                                cur_hash_ip4);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP4Field0 : unit=%d, hash=%x, rc=%s",
                  hw_unit, cur_hash_ip4, opennsl_errmsg(rc));
         return rc;
     }
 
-    rc = opennsl_switch_control_set(hw_unit,
-                                    opennslSwitchHashIP6TcpUdpPortsEqualField0,
-                                    cur_hash_ip6);
+    rc = ops_switch_control_set(hw_unit,
+                                opennslSwitchHashIP6TcpUdpPortsEqualField0,
+                                cur_hash_ip6);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP6TcpUdpPortsEqualField0:"
                  "unit=%d, hash=%x, rc=%s",
                  hw_unit, cur_hash_ip6, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(hw_unit,
-                                    opennslSwitchHashIP6TcpUdpField0,
-                                    cur_hash_ip6);
+    rc = ops_switch_control_set(hw_unit,
+                                opennslSwitchHashIP6TcpUdpField0,
+                                cur_hash_ip6);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP6TcpUdpPortsEqualField0:"
                  "unit=%d, hash=%x, rc=%s",
                  hw_unit, cur_hash_ip6, opennsl_errmsg(rc));
         return 1;
     }
-    rc = opennsl_switch_control_set(hw_unit, opennslSwitchHashIP6Field0,
-                                    cur_hash_ip6);
+    rc = ops_switch_control_set(hw_unit, opennslSwitchHashIP6Field0,
+                                cur_hash_ip6);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Failed to set opennslSwitchHashIP6Field0 : unit=%d, hash=%x, rc=%s",
                  hw_unit, cur_hash_ip6, opennsl_errmsg(rc));
@@ -1549,6 +5151,8 @@ ops_routing_host_entry_action(int hw_unit, opennsl_vrf_t vrf_id,
     struct in6_addr ipv6_addr;
     uint8_t prefix_len;
     int flags = OPENNSL_L3_HOST_LOCAL;
+    struct ops_stale_entry *stale;
+    uint64_t start = ops_l3_perf_now();
 
     VLOG_DBG("%s: vrfid: %d, action: %d", __FUNCTION__, vrf_id, action);
 
@@ -1581,6 +5185,12 @@ ops_routing_host_entry_action(int hw_unit, opennsl_vrf_t vrf_id,
     l3host.l3a_vrf = vrf_id;
     l3host.l3a_flags = flags;
     rc = opennsl_l3_host_find(hw_unit, &l3host);
+    if (OPENNSL_SUCCESS(rc) && (action == OFPROTO_HOST_ADD) &&
+        ops_host_route_evict(hw_unit, &l3host)) {
+        /* the entry found was a host route, now moved to the lpm */
+        l3host.l3a_flags = flags;
+        rc = OPENNSL_E_NOT_FOUND;
+    }
 
     switch (action) {
     case OFPROTO_HOST_ADD:
@@ -1590,10 +5200,18 @@ ops_routing_host_entry_action(int hw_unit, opennsl_vrf_t vrf_id,
             rc = opennsl_l3_host_add(hw_unit, &l3host);
             if (OPENNSL_FAILURE(rc)) {
                 VLOG_ERR ("opennsl_l3_host_add failed: %s", opennsl_errmsg(rc));
+            } else {
+                ops_hw_table_update(hw_unit, OPS_HW_TABLE_HOST, 1);
             }
         } else {
             VLOG_DBG ("Host entry exists: 0x%x", rc);
+            /* local host of the previous run on a warm restart */
+            stale = ops_stale_host_lookup(&l3host);
+            if (stale) {
+                ops_stale_claim(&ops_stale_hosts, stale);
+            }
         }
+        ops_l3_perf_record(OPS_L3_PERF_HOST_ADD, start, OPENNSL_FAILURE(rc));
         break;
     case OFPROTO_HOST_DELETE:
         if (rc != OPENNSL_E_NOT_FOUND) {
@@ -1602,10 +5220,14 @@ ops_routing_host_entry_action(int hw_unit, opennsl_vrf_t vrf_id,
             rc = opennsl_l3_host_delete(hw_unit, &l3host);
             if (OPENNSL_FAILURE(rc)) {
                 VLOG_ERR ("opennsl_l3_host_delete failed: %s", opennsl_errmsg(rc));
+            } else {
+                ops_hw_table_update(hw_unit, OPS_HW_TABLE_HOST, -1);
             }
         } else {
             VLOG_DBG ("Host entry doesn't exists: 0x%x", rc);
         }
+        ops_l3_perf_record(OPS_L3_PERF_HOST_DELETE, start,
+                           OPENNSL_FAILURE(rc));
         break;
     default:
         VLOG_ERR("Unknown l3 host action %d", action);
@@ -1616,6 +5238,68 @@ ops_routing_host_entry_action(int hw_unit, opennsl_vrf_t vrf_id,
     return rc;
 } /* ops_routing_route_entry_action */
 
+/* Print a latency, truncated to the largest unit it reaches */
+static void
+ops_l3_perf_put_ns(struct ds *ds, uint64_t ns)
+{
+    if (ns >= 1000000000ULL) {
+        ds_put_format(ds, "%"PRIu64"s", ns / 1000000000);
+    } else if (ns >= 1000000ULL) {
+        ds_put_format(ds, "%"PRIu64"ms", ns / 1000000);
+    } else if (ns >= 1000ULL) {
+        ds_put_format(ds, "%"PRIu64"us", ns / 1000);
+    } else {
+        ds_put_format(ds, "%"PRIu64"ns", ns);
+    }
+} /* ops_l3_perf_put_ns */
+
+void
+ops_routing_perf_dump(struct ds *ds)
+{
+    struct ops_l3_perf *perf;
+    int op, i;
+
+    ds_put_format(ds, "%-14s %10s %8s %10s %10s\n",
+                  "Operation", "Count", "Errors", "Avg(us)", "Max(us)");
+    ds_put_format(ds, "----------------------------------------------------"
+                  "-----\n");
+    for (op = 0; op < OPS_L3_PERF_MAX; op++) {
+        perf = &ops_l3_perf[op];
+        ds_put_format(ds, "%-14s %10"PRIu64" %8"PRIu64" %10"PRIu64
+                      " %10"PRIu64"\n", ops_l3_perf_names[op], perf->count, perf->errors,
+                      perf->count ? perf->total_ns / perf->count / 1000 : 0,
+                      perf->max_ns / 1000);
+    }
+
+    for (op = 0; op < OPS_L3_PERF_MAX; op++) {
+        perf = &ops_l3_perf[op];
+        if (!perf->count) {
+            continue;
+        }
+        ds_put_format(ds, "\n%s latency:\n", ops_l3_perf_names[op]);
+        for (i = 0; i < OPS_L3_PERF_BUCKETS; i++) {
+            if (!perf->buckets[i]) {
+                continue;
+            }
+            ds_put_cstr(ds, "  ");
+            if (i == OPS_L3_PERF_BUCKETS - 1) {
+                ds_put_cstr(ds, ">= ");
+                ops_l3_perf_put_ns(ds, 1ULL << (i - 1));
+            } else {
+                ds_put_cstr(ds, "<  ");
+                ops_l3_perf_put_ns(ds, 1ULL << i);
+            }
+            ds_put_format(ds, " : %"PRIu64"\n", perf->buckets[i]);
+        }
+    }
+} /* ops_routing_perf_dump */
+
+void
+ops_routing_perf_reset(void)
+{
+    memset(ops_l3_perf, 0, sizeof(ops_l3_perf));
+} /* ops_routing_perf_reset */
+
 static void
 l3_intf_print(struct ds *ds, int unit, int print_hdr,
               opennsl_l3_intf_t *intf)
@@ -1640,161 +5324,167 @@ l3_intf_print(struct ds *ds, int unit, int print_hdr,
     return;
 } /* l3_intf_print */
 
-static struct ops_mac_move_egress_id *
-ops_egress_id_lookup(char*egress_id_key_l)
-{
-   struct ops_mac_move_egress_id    *egress_id_node;
-
-   HMAP_FOR_EACH_WITH_HASH(egress_id_node, node, hash_string(egress_id_key_l, 0),
-                                               &ops_mac_move_egress_id_map) {
-           return egress_id_node;
-   }
-
-   return NULL;
-}
-
+/* Queue a mac move reported by the l2 callback thread. This runs on
+ * the SDK thread, so it only copies the event into the ring and wakes up
+ * the main thread.
+ *
+ * When a move happens, the ASIC sends a MAC delete message followed by a
+ * MAC add message, both with the MOVE flag set. Only the add, which
+ * carries the new port, is needed. */
 void
-ops_l3_mac_move_add(int   unit,
-                    opennsl_l2_addr_t  *l2addr,
-                    void   *userdata)
+ops_l3_mac_move_cb(int   unit,
+                   opennsl_l2_addr_t  *l2addr,
+                   int    operation,
+                   void   *userdata)
 {
-   opennsl_l3_egress_t     egress_object;
-   opennsl_error_t         rc = OPENNSL_E_NONE;
-   struct ops_mac_move_egress_id    *egress_id_node;
-
-   if (!(l2addr->flags & OPENNSL_L2_MOVE_PORT)) {
-       /* Only handle ADD due to mac-move */
-       return;
-   }
+    struct ops_mac_move_event *event;
+    unsigned int head, tail;
 
-   /* ADD call, due to mac-move. */
+    if (l2addr == NULL) {
+        VLOG_ERR("Invalid arguments. l2-addr is NULL");
+        return;
+    }
 
-   memset(egress_id_key, 0, sizeof(egress_id_key));
-   snprintf(egress_id_key, 24, "%d:" ETH_ADDR_FMT, l2addr->vid,
-                               ETH_ADDR_BYTES_ARGS(l2addr->mac));
+    if ((operation != OPENNSL_L2_CALLBACK_ADD) ||
+        !(l2addr->flags & OPENNSL_L2_MOVE_PORT)) {
+        return;
+    }
 
-   egress_id_node = ops_egress_id_lookup(egress_id_key);
-   if (egress_id_node == NULL) {
-       VLOG_INFO("Egress object id NOT found in process cache, possibly "
-                 "deleted: unit=%d, key=%s, vlan=%d, mac=" ETH_ADDR_FMT,
-                 unit, egress_id_key, l2addr->vid, ETH_ADDR_BYTES_ARGS(l2addr->mac));
+    atomic_read_explicit(&mac_move_head, &head, memory_order_relaxed);
+    atomic_read_explicit(&mac_move_tail, &tail, memory_order_acquire);
+    if ((head - tail) >= OPS_MAC_MOVE_RING_SIZE) {
+        /* the main thread resyncs the egress objects with the l2 table */
+        atomic_store_explicit(&mac_move_overflow, true, memory_order_release);
+    } else {
+        event = &mac_move_ring[head & (OPS_MAC_MOVE_RING_SIZE - 1)];
+        event->vid = l2addr->vid;
+        memcpy(event->mac, l2addr->mac, ETH_ALEN);
+        event->port = l2addr->port;
+        atomic_store_explicit(&mac_move_head, head + 1, memory_order_release);
+    }
+    latch_set(&mac_move_latch);
+} /* ops_l3_mac_move_cb */
 
-       /* Unexpected condition. This shouldn't happen. */
-       return;
-   }
+/* Move the egress objects of a neighbor to the port its mac moved to */
+static void
+ops_mac_move_apply(opennsl_vlan_t vid, const opennsl_mac_t mac,
+                   opennsl_port_t port)
+{
+    struct ops_egress *egress;
+
+    ovs_mutex_lock(&egress_mutex);
+    HMAP_FOR_EACH_WITH_HASH(egress, mac_node, ops_egress_mac_hash(vid, mac),
+                            &ops_egresses_by_mac) {
+        if ((egress->key.vlan == vid) &&
+            (memcmp(egress->key.mac, mac, ETH_ALEN) == 0) &&
+            (egress->key.port != port)) {
+            ops_egress_port_rewrite(egress, port);
+        }
+    }
+    ovs_mutex_unlock(&egress_mutex);
+} /* ops_mac_move_apply */
 
-   opennsl_l3_egress_t_init(&egress_object);
+/* Check the port of every neighbor egress object against the l2 table,
+ * after mac moves were lost because the ring was full */
+static void
+ops_mac_move_resync(void)
+{
+    struct ops_egress *egress;
+    opennsl_l2_addr_t l2addr;
+    opennsl_error_t rc;
 
-   /* Using egress id, get egress object from ASIC */
-   rc = opennsl_l3_egress_get(unit, egress_id_node->egress_object_id, &egress_object);
+    VLOG_WARN("Mac move events lost, checking all the neighbor egress objects");
 
-   if (OPENNSL_FAILURE(rc)) {
-       VLOG_ERR("Egress object not found in ASIC for given vlan/mac. rc=%s "
-                 "unit=%d, key=%s, vlan=%d, mac=" ETH_ADDR_FMT ", egr-id: %d",
-                 opennsl_errmsg(rc), unit, egress_id_key, l2addr->vid,
-                 ETH_ADDR_BYTES_ARGS(l2addr->mac), egress_id_node->egress_object_id);
+    ovs_mutex_lock(&egress_mutex);
+    HMAP_FOR_EACH(egress, node, &ops_egresses) {
+        rc = opennsl_l2_addr_get(egress->hw_unit, egress->key.mac,
+                                 egress->key.vlan, &l2addr);
+        if (OPENNSL_SUCCESS(rc) && (l2addr.port != egress->key.port)) {
+            ops_egress_port_rewrite(egress, l2addr.port);
+        }
+    }
+    ovs_mutex_unlock(&egress_mutex);
+} /* ops_mac_move_resync */
 
-       goto done;
-   }
+/* Find the pending move of a mac */
+static struct ops_mac_move *
+ops_mac_move_lookup(opennsl_vlan_t vid, const opennsl_mac_t mac)
+{
+    struct ops_mac_move *move;
 
-   egress_object.flags    |= (OPENNSL_L3_REPLACE|OPENNSL_L3_WITH_ID);
-   egress_object.port     = l2addr->port;  /* new port */
-   /* L3 intf will remain unchanged */
+    HMAP_FOR_EACH_WITH_HASH(move, node, ops_egress_mac_hash(vid, mac),
+                            &ops_mac_moves) {
+        if ((move->vid == vid) && (memcmp(move->mac, mac, ETH_ALEN) == 0)) {
+            return move;
+        }
+    }
+    return NULL;
+} /* ops_mac_move_lookup */
 
-   VLOG_DBG("Input: unit=%d, flags=0x%x, port=%d, vlan=%d, mac=" ETH_ADDR_FMT
-             " egr-id=%d, intf=%d", unit, egress_object.flags, egress_object.port,
-             egress_object.vlan, ETH_ADDR_BYTES_ARGS(egress_object.mac_addr),
-             egress_id_node->egress_object_id, egress_object.intf);
+/* Drain the mac moves queued by the l2 callback thread. The moves of a
+ * mac are coalesced, and its egress objects are rewritten once it stayed
+ * OPS_MAC_MOVE_SETTLE_MSEC after its first move, so a mac flapping
+ * between two ports costs one rewrite per settle period. */
+void
+ops_routing_mac_move_run(void)
+{
+    struct ops_mac_move_event *event;
+    struct ops_mac_move *move, *next;
+    unsigned int head, tail;
+    long long int now = time_msec();
+    bool overflow;
 
-   rc = opennsl_l3_egress_create(unit, egress_object.flags, &egress_object,
-                                   &(egress_id_node->egress_object_id));
-   if (OPENNSL_FAILURE(rc)) {
-       VLOG_ERR("Failed creation of egress object: rc=%s, unit=%d", opennsl_errmsg(rc), unit);
-       goto done;
-   }
+    if (!mac_move_latch_initialized) {
+        return;
+    }
+    latch_poll(&mac_move_latch);
+
+    atomic_read_explicit(&mac_move_head, &head, memory_order_acquire);
+    atomic_read_explicit(&mac_move_tail, &tail, memory_order_relaxed);
+    for (; tail != head; tail++) {
+        event = &mac_move_ring[tail & (OPS_MAC_MOVE_RING_SIZE - 1)];
+        move = ops_mac_move_lookup(event->vid, event->mac);
+        if (!move) {
+            move = xzalloc(sizeof(*move));
+            move->vid = event->vid;
+            memcpy(move->mac, event->mac, ETH_ALEN);
+            move->deadline = now + OPS_MAC_MOVE_SETTLE_MSEC;
+            hmap_insert(&ops_mac_moves, &move->node,
+                        ops_egress_mac_hash(event->vid, event->mac));
+        }
+        move->port = event->port;
+    }
+    atomic_store_explicit(&mac_move_tail, tail, memory_order_release);
 
-done:
-   /* remove hmap entry for given mac/vlan */
-   hmap_remove(&ops_mac_move_egress_id_map, &egress_id_node->node);
-}
+    atomic_read_explicit(&mac_move_overflow, &overflow, memory_order_acquire);
+    if (overflow) {
+        atomic_store_explicit(&mac_move_overflow, false, memory_order_relaxed);
+        ops_mac_move_resync();
+    }
 
-void
-ops_l3_mac_move_delete(int   unit,
-                       opennsl_l2_addr_t  *l2addr,
-                       void   *userdata)
-{
-   opennsl_l3_egress_t     egress_object;
-   opennsl_if_t            egress_object_id;
-   struct ops_mac_move_egress_id   *egress_node;
-   opennsl_error_t         rc = OPENNSL_E_NONE;
-
-   if (!(l2addr->flags & OPENNSL_L2_MOVE_PORT)) {
-       /* Only handle DELTE due to mac-move */
-       return;
-   }
-
-   /* DELETE call due to mac-move */
-
-   memset(egress_id_key, 0, sizeof(egress_id_key));
-   snprintf(egress_id_key, 24, "%d:" ETH_ADDR_FMT, l2addr->vid,
-                               ETH_ADDR_BYTES_ARGS(l2addr->mac));
-
-   /* Create an egress object with old/deleted port and save in hashmap */
-
-   opennsl_l3_egress_t_init(&egress_object);
-   memcpy(egress_object.mac_addr, l2addr->mac, ETH_ALEN);
-   egress_object.vlan     = l2addr->vid;
-   egress_object.port     = l2addr->port; /* old/deleted port */
-   egress_object.intf     = l2addr->vid;  /* l3 intf is same as vlanid */
-
-   /* egress_id is the id of row containing egress_object in ASIC */
-   opennsl_l3_egress_find(unit, &egress_object, &egress_object_id);
-   if (OPENNSL_FAILURE(rc)) {
-       VLOG_ERR("Failed retrieving egress object id: rc=%s, unit=%d, vlan=%d, "
-                "mac=" ETH_ADDR_FMT, opennsl_errmsg(rc), unit, l2addr->vid,
-                ETH_ADDR_BYTES_ARGS(l2addr->mac));
-
-       return;
-   }
-
-   /* add the egress id to hashmap */
-   egress_node = (struct ops_mac_move_egress_id *) xmalloc(sizeof(struct
-                                                   ops_mac_move_egress_id));
-   if (egress_node == NULL) {
-       VLOG_ERR("Failed allocating memory to ops_mac_move_egress_id: "
-                "unit=%d", unit);
-       return;
-   }
-   egress_node->egress_object_id = egress_object_id;
-   hmap_insert(&ops_mac_move_egress_id_map, &egress_node->node, hash_string(egress_id_key, 0));
-}
+    HMAP_FOR_EACH_SAFE(move, next, node, &ops_mac_moves) {
+        if (now >= move->deadline) {
+            ops_mac_move_apply(move->vid, move->mac, move->port);
+            hmap_remove(&ops_mac_moves, &move->node);
+            free(move);
+        }
+    }
+} /* ops_routing_mac_move_run */
 
-/*This function can get called by ASIC for following events:
-*  Add, Delete, Mac-Learn, Mac-Age, & Mac-Move
-*
-*  Currently, it handles Add & Delete events, triggered due to mac-move. */
 void
-ops_l3_mac_move_cb(int   unit,
-                   opennsl_l2_addr_t  *l2addr,
-                   int    operation,
-                   void   *userdata)
+ops_routing_mac_move_wait(void)
 {
-   if (l2addr == NULL) {
-       VLOG_ERR("Invalid arguments. l2-addr is NULL");
-       return;
-   }
-
-   switch(operation) {
-       case OPENNSL_L2_CALLBACK_ADD:
-           ops_l3_mac_move_add(unit, l2addr, userdata);
-           break;
-       case OPENNSL_L2_CALLBACK_DELETE:
-           ops_l3_mac_move_delete(unit, l2addr, userdata);
-           break;
-       default:
-           break;
-   }
-}
+    struct ops_mac_move *move;
+
+    if (!mac_move_latch_initialized) {
+        return;
+    }
+
+    latch_wait(&mac_move_latch);
+    HMAP_FOR_EACH(move, node, &ops_mac_moves) {
+        poll_timer_wait_until(move->deadline);
+    }
+} /* ops_routing_mac_move_wait */
 
 void
 ops_l3intf_dump(struct ds *ds, int intfid)
@@ -1941,11 +5631,19 @@ int ops_route_print(int unit, int index, opennsl_l3_route_t *info,
 {
     char *hit;
     char *ecmp_str;
+    char entry[16];
     struct ds *pds = (struct ds *)user_data;
 
     hit = (info->l3a_flags & OPENNSL_L3_HIT) ? "Y" : "N";
     ecmp_str = (info->l3a_flags & OPENNSL_L3_MULTIPATH) ? "(ECMP)" : "";
 
+    /* routes held in the host table have no lpm index */
+    if (index < 0) {
+        snprintf(entry, sizeof(entry), "host");
+    } else {
+        snprintf(entry, sizeof(entry), "%d", index);
+    }
+
     if (info->l3a_flags & OPENNSL_L3_IP6) {
         char subnet_str[IPV6_BUFFER_LEN];
         char subnet_mask[IPV6_BUFFER_LEN];
@@ -1968,7 +5666,7 @@ int ops_route_print(int unit, int index, opennsl_l3_route_t *info,
             (((uint16)info->l3a_ip6_mask[12] << 8) | info->l3a_ip6_mask[13]),
             (((uint16)info->l3a_ip6_mask[14] << 8) | info->l3a_ip6_mask[15]));
 
-        ds_put_format(pds, "%-6d %-4d %-42s %-42s %2d %4s %s\n", index,
+        ds_put_format(pds, "%-6s %-4d %-42s %-42s %2d %4s %s\n", entry,
                       info->l3a_vrf, subnet_str, subnet_mask, info->l3a_intf,
                       hit, ecmp_str);
     } else {
@@ -1981,13 +5679,33 @@ int ops_route_print(int unit, int index, opennsl_l3_route_t *info,
             (info->l3a_ip_mask >> 24) & 0xff, (info->l3a_ip_mask >> 16) & 0xff,
             (info->l3a_ip_mask >> 8) & 0xff, info->l3a_ip_mask & 0xff);
 
-        ds_put_format(pds,"%-6d %-4d %-16s %-16s %2d %5s %s\n", index,
+        ds_put_format(pds,"%-6s %-4d %-16s %-16s %2d %5s %s\n", entry,
                       info->l3a_vrf, subnet_str, subnet_mask, info->l3a_intf,
                       hit, ecmp_str);
     }
     return OPENNSL_E_NONE;
 } /*ops_route_print*/
 
+/* Print the routes of a family programmed in the host table */
+static void
+ops_host_routes_print(struct ds *ds, int unit, bool is_ipv6)
+{
+    struct ops_route_table *rtable;
+    struct ops_route *ops_routep;
+    opennsl_l3_route_t route;
+
+    HMAP_FOR_EACH(rtable, node, &ops_route_tables) {
+        HMAP_FOR_EACH(ops_routep, node, &rtable->routes) {
+            if (!ops_routep->in_host_table ||
+                (ops_routep->key.is_ipv6 != is_ipv6) ||
+                !ops_route_to_l3_route(ops_routep, &route)) {
+                continue;
+            }
+            ops_route_print(unit, -1, &route, ds);
+        }
+    }
+} /* ops_host_routes_print */
+
 void
 ops_l3route_dump(struct ds *ds, int ipv6_enabled)
 {
@@ -1997,6 +5715,8 @@ ops_l3route_dump(struct ds *ds, int ipv6_enabled)
     int               first_entry;
     opennsl_l3_info_t l3_hw_status;
 
+    ops_hw_queue_flush();
+
     rv = opennsl_l3_info(unit, &l3_hw_status);
     if (OPENNSL_FAILURE(rv)){
         VLOG_ERR("Error in L3 info access: %s\n",opennsl_errmsg(rv));
@@ -2012,8 +5732,8 @@ ops_l3route_dump(struct ds *ds, int ipv6_enabled)
 
     if (ipv6_enabled == TRUE) {
         int ipv6_hash = 0;
-        rv = opennsl_switch_control_get(unit, opennslSwitchHashIP6Field0,
-                                        &ipv6_hash);
+        rv = ops_switch_control_get(unit, opennslSwitchHashIP6Field0,
+                                    &ipv6_hash);
         if (OPENNSL_FAILURE(rv)){
             VLOG_ERR("Error in get opennslSwitchHashIP6Field0: %s\n",
                       opennsl_errmsg(rv));
@@ -2035,10 +5755,11 @@ ops_l3route_dump(struct ds *ds, int ipv6_enabled)
                       "----------------------------------------------------------\n");
         opennsl_l3_route_traverse(unit, OPENNSL_L3_IP6, first_entry, last_entry,
                                  &ops_route_print, ds);
+        ops_host_routes_print(ds, unit, true);
     } else {
         int ipv4_hash = 0;
-        rv = opennsl_switch_control_get(unit, opennslSwitchHashIP4Field0,
-                                        &ipv4_hash);
+        rv = ops_switch_control_get(unit, opennslSwitchHashIP4Field0,
+                                    &ipv4_hash);
         if (OPENNSL_FAILURE(rv)){
             VLOG_ERR("Error in get opennslSwitchHashIP4Field0: %s\n",
                       opennsl_errmsg(rv));
@@ -2059,6 +5780,7 @@ ops_l3route_dump(struct ds *ds, int ipv6_enabled)
 
         opennsl_l3_route_traverse(unit, 0, first_entry, last_entry,
                                  &ops_route_print, ds);
+        ops_host_routes_print(ds, unit, false);
     }
 
 } /* ops_l3route_dump */
@@ -2117,6 +5839,10 @@ l3ecmp_egress_print(int unit, opennsl_l3_egress_ecmp_t *ecmp,
     int idx;
     struct ds *pds = (struct ds *)user_data;
     ds_put_format(pds, "Multipath Egress Object %d\n", ecmp->ecmp_intf);
+    if (ecmp->dynamic_mode == OPENNSL_L3_ECMP_DYNAMIC_MODE_RESILIENT) {
+        ds_put_format(pds, "Resilient hashing: %d buckets\n",
+                      ecmp->dynamic_size);
+    }
     ds_put_format(pds, "Interfaces:");
 
     for (idx = 0; idx < intf_count; idx++) {
@@ -2136,15 +5862,15 @@ ops_l3ecmp_egress_dump(struct ds *ds, int ecmpid)
     int unit = 0;
     opennsl_error_t rc;
     opennsl_l3_egress_ecmp_t ecmp_grp;
-    opennsl_l3_ecmp_member_t ecmp_member[MAX_NEXTHOPS_PER_ROUTE];
-    opennsl_if_t ecmp_intf[MAX_NEXTHOPS_PER_ROUTE];
+    opennsl_l3_ecmp_member_t ecmp_member[OPS_ECMP_MAX_MEMBERS];
+    opennsl_if_t ecmp_intf[OPS_ECMP_MAX_MEMBERS];
     int member_count = 0;
 
     /* single multipath object */
     if (ecmpid != -1) {
         opennsl_l3_egress_ecmp_t_init(&ecmp_grp);
         ecmp_grp.ecmp_intf = ecmpid;
-        rc = opennsl_l3_ecmp_get(unit, &ecmp_grp, MAX_NEXTHOPS_PER_ROUTE,
+        rc = opennsl_l3_ecmp_get(unit, &ecmp_grp, OPS_ECMP_MAX_MEMBERS,
                                  ecmp_member, &member_count);
         if (OPENNSL_FAILURE(rc)){
             VLOG_ERR("Error reading ecmp egress entry %d: %s\n", ecmpid,
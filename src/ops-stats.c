@@ -16,16 +16,23 @@
  *
  * File: ops-stats.c
  *
- * Purpose: This file has code to retreive Interface statistics.
+ * Purpose: This file has code to retreive Interface statistics and
+ *          hardware table occupancy.
  */
 
 #include <openvswitch/vlog.h>
 
 #include <opennsl/error.h>
 #include <opennsl/stat.h>
+#include <opennsl/l3.h>
+#include <opennsl/trunk.h>
 
 #include <openvswitch/vlog.h>
 #include <netdev.h>
+#include <ovs-thread.h>
+
+#include "platform-defines.h"
+#include "ops-stats.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_stats);
 
@@ -98,3 +105,159 @@ bcmsdk_get_port_stats(int hw_unit, int hw_port, struct netdev_stats *stats)
     return 0;
 
 } // bcmsdk_get_port_stats
+
+/////////////////////// HARDWARE TABLE OCCUPANCY ///////////////////////////
+
+// Number of VLANs which can be created.
+#define OPS_HW_VLAN_MAX     4094
+
+static const char *hw_table_names[OPS_HW_TABLE_MAX] = {
+    "host",             // OPS_HW_TABLE_HOST
+    "ipv4 route",       // OPS_HW_TABLE_ROUTE_V4
+    "ipv6 route",       // OPS_HW_TABLE_ROUTE_V6
+    "egress",           // OPS_HW_TABLE_EGRESS
+    "ecmp group",       // OPS_HW_TABLE_ECMP_GROUP
+    "ecmp member",      // OPS_HW_TABLE_ECMP_MEMBER
+    "l3 interface",     // OPS_HW_TABLE_L3_INTF
+    "vlan",             // OPS_HW_TABLE_VLAN
+    "trunk",            // OPS_HW_TABLE_TRUNK
+};
+
+// Occupancy is updated by the create and destroy calls on the main
+// thread, and by the linkscan thread for ECMP members.
+static struct ovs_mutex hw_table_mutex = OVS_MUTEX_INITIALIZER;
+static struct ops_hw_table_usage hw_tables[MAX_SWITCH_UNITS][OPS_HW_TABLE_MAX];
+
+// LPM entries already in use at init, e.g. after a warm boot. The SDK
+// counts IPv4 and IPv6 routes together, so they are left out of the
+// per family route counts.
+static int hw_lpm_used_at_init[MAX_SWITCH_UNITS];
+
+void
+ops_hw_table_init(int hw_unit)
+{
+    struct ops_hw_table_usage *tables;
+    opennsl_l3_info_t l3_hw_status;
+    opennsl_trunk_chip_info_t trunk_info;
+    opennsl_error_t rc;
+    int i;
+
+    if (!VALID_HW_UNIT(hw_unit)) {
+        return;
+    }
+
+    tables = hw_tables[hw_unit];
+    ovs_mutex_lock(&hw_table_mutex);
+
+    tables[OPS_HW_TABLE_VLAN].max = OPS_HW_VLAN_MAX;
+
+    rc = opennsl_trunk_chip_info_get(hw_unit, &trunk_info);
+    if (OPENNSL_SUCCESS(rc)) {
+        tables[OPS_HW_TABLE_TRUNK].max = trunk_info.trunk_group_count;
+    }
+
+    // Seed the L3 tables with their size and the entries already in use.
+    // The LPM table is shared by IPv4 and IPv6 routes, whose counts start
+    // at 0.
+    rc = opennsl_l3_info(hw_unit, &l3_hw_status);
+    if (OPENNSL_FAILURE(rc)) {
+        VLOG_ERR("Error in L3 info access: unit=%d rc=%s",
+                 hw_unit, opennsl_errmsg(rc));
+    } else {
+        tables[OPS_HW_TABLE_HOST].max = l3_hw_status.l3info_max_host;
+        tables[OPS_HW_TABLE_HOST].used = l3_hw_status.l3info_used_host;
+        tables[OPS_HW_TABLE_ROUTE_V4].max = l3_hw_status.l3info_max_route;
+        tables[OPS_HW_TABLE_ROUTE_V6].max = l3_hw_status.l3info_max_route;
+        hw_lpm_used_at_init[hw_unit] = l3_hw_status.l3info_used_route;
+        tables[OPS_HW_TABLE_EGRESS].max = l3_hw_status.l3info_max_nexthop;
+        tables[OPS_HW_TABLE_EGRESS].used = l3_hw_status.l3info_used_nexthop;
+        tables[OPS_HW_TABLE_ECMP_GROUP].max = l3_hw_status.l3info_max_ecmp_groups;
+        tables[OPS_HW_TABLE_L3_INTF].max = l3_hw_status.l3info_max_intf;
+        tables[OPS_HW_TABLE_L3_INTF].used = l3_hw_status.l3info_used_intf;
+    }
+
+    for (i = 0; i < OPS_HW_TABLE_MAX; i++) {
+        tables[i].high_water = tables[i].used;
+    }
+
+    ovs_mutex_unlock(&hw_table_mutex);
+
+} // ops_hw_table_init
+
+void
+ops_hw_table_update(int hw_unit, enum ops_hw_table table, int delta)
+{
+    struct ops_hw_table_usage *usage;
+
+    if (!VALID_HW_UNIT(hw_unit) || (table >= OPS_HW_TABLE_MAX)) {
+        return;
+    }
+
+    usage = &hw_tables[hw_unit][table];
+    ovs_mutex_lock(&hw_table_mutex);
+    usage->used += delta;
+    if (usage->used < 0) {
+        usage->used = 0;
+    }
+    if (usage->used > usage->high_water) {
+        usage->high_water = usage->used;
+    }
+    ovs_mutex_unlock(&hw_table_mutex);
+
+} // ops_hw_table_update
+
+int
+bcmsdk_get_hw_table_usage(int hw_unit, enum ops_hw_table table,
+                          struct ops_hw_table_usage *usage)
+{
+    if (!VALID_HW_UNIT(hw_unit) || (table >= OPS_HW_TABLE_MAX)) {
+        return -1;
+    }
+
+    ovs_mutex_lock(&hw_table_mutex);
+    *usage = hw_tables[hw_unit][table];
+    ovs_mutex_unlock(&hw_table_mutex);
+
+    return 0;
+
+} // bcmsdk_get_hw_table_usage
+
+const char *
+ops_hw_table_name(enum ops_hw_table table)
+{
+    return (table < OPS_HW_TABLE_MAX) ? hw_table_names[table] : "unknown";
+
+} // ops_hw_table_name
+
+void
+ops_hw_table_dump(struct ds *ds)
+{
+    struct ops_hw_table_usage usage;
+    int unit, table;
+
+    for (unit = 0; unit <= MAX_SWITCH_UNIT_ID; unit++) {
+        ds_put_format(ds, "Unit %d:\n", unit);
+        ds_put_format(ds, "  %-14s %10s %10s %10s %6s\n",
+                      "TABLE", "USED", "HIGH-WATER", "SIZE", "USE%");
+        for (table = 0; table < OPS_HW_TABLE_MAX; table++) {
+            bcmsdk_get_hw_table_usage(unit, table, &usage);
+            ds_put_format(ds, "  %-14s %10d %10d ",
+                          ops_hw_table_name(table), usage.used,
+                          usage.high_water);
+            if (usage.max) {
+                ds_put_format(ds, "%10d %5d%%\n", usage.max,
+                              (int)((usage.used * 100LL) / usage.max));
+            } else {
+                ds_put_format(ds, "%10s %6s\n", "-", "-");
+            }
+        }
+        ovs_mutex_lock(&hw_table_mutex);
+        if (hw_lpm_used_at_init[unit]) {
+            ds_put_format(ds, "  %d routes in the LPM table at init are not "
+                          "counted in the ipv4 and ipv6 route tables\n",
+                          hw_lpm_used_at_init[unit]);
+        }
+        ovs_mutex_unlock(&hw_table_mutex);
+    }
+
+} // ops_hw_table_dump
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2015 Hewlett-Packard Development Company, L.P.
+ * All Rights Reserved.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *   not use this file except in compliance with the License. You may obtain
+ *   a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *   WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *   License for the specific language governing permissions and limitations
+ *   under the License.
+ *
+ * File: ops-switch-control.c
+ *
+ * Purpose: This file contains a shadow cache of the OpenNSL switch controls
+ *          owned by the plugin, so that reads are served from memory and
+ *          writes of an unchanged value never reach the hardware.
+ */
+
+#include <string.h>
+
+#include <openvswitch/vlog.h>
+#include <ovs/util.h>
+#include <ovs-thread.h>
+
+#include <opennsl/error.h>
+#include <opennsl/switch.h>
+
+#include "platform-defines.h"
+#include "ops-switch-control.h"
+
+VLOG_DEFINE_THIS_MODULE(ops_switch_control);
+
+// Switch controls owned by the plugin.  Nothing else programs them,
+// so once read at init the cached value is authoritative.
+static const struct {
+    opennsl_switch_control_t type;
+    const char *name;
+} switch_controls[] = {
+    { opennslSwitchL3IngressMode,                 "L3IngressMode" },
+    { opennslSwitchL3EgressMode,                  "L3EgressMode" },
+    { opennslSwitchArpRequestToCpu,               "ArpRequestToCpu" },
+    { opennslSwitchArpReplyToCpu,                 "ArpReplyToCpu" },
+    { opennslSwitchDhcpPktToCpu,                  "DhcpPktToCpu" },
+    { opennslSwitchNdPktToCpu,                    "NdPktToCpu" },
+    { opennslSwitchUnknownL3DestToCpu,            "UnknownL3DestToCpu" },
+    { opennslSwitchV6L3DstMissToCpu,              "V6L3DstMissToCpu" },
+    { opennslSwitchHashControl,                   "HashControl" },
+    { opennslSwitchHashMultipath,                 "HashMultipath" },
+    { opennslSwitchHashIP4TcpUdpPortsEqualField0, "HashIP4TcpUdpPortsEqualField0" },
+    { opennslSwitchHashIP4TcpUdpField0,           "HashIP4TcpUdpField0" },
+    { opennslSwitchHashIP4Field0,                 "HashIP4Field0" },
+    { opennslSwitchHashIP6TcpUdpPortsEqualField0, "HashIP6TcpUdpPortsEqualField0" },
+    { opennslSwitchHashIP6TcpUdpField0,           "HashIP6TcpUdpField0" },
+    { opennslSwitchHashIP6Field0,                 "HashIP6Field0" },
+    { opennslSwitchHashSeed0,                     "HashSeed0" },
+    { opennslSwitchHashField0PreProcessEnable,    "HashField0PreProcessEnable" },
+    { opennslSwitchHashField0Config,              "HashField0Config" },
+    { opennslSwitchHashField0Config1,             "HashField0Config1" },
+    { opennslSwitchECMPHashSet0Offset,            "ECMPHashSet0Offset" },
+    { opennslSwitchHashSelectControl,             "HashSelectControl" },
+    { opennslSwitchBstEnable,                     "BstEnable" },
+    { opennslSwitchBstTrackingMode,               "BstTrackingMode" },
+};
+
+#define N_SWITCH_CONTROLS ARRAY_SIZE(switch_controls)
+
+struct switch_control_shadow {
+    int value;
+    bool valid;                 // Value is known to match the hardware.
+    unsigned int hw_writes;     // Writes sent to the hardware.
+    unsigned int suppressed;    // Writes dropped as unchanged.
+};
+
+// The BST event callback updates controls from the SDK thread, so the
+// cache is shared with the main thread.  The lock is held across the
+// hardware call to keep the shadow and the hardware in step.
+static struct ovs_mutex switch_control_mutex = OVS_MUTEX_INITIALIZER;
+static struct switch_control_shadow
+    switch_control_cache[MAX_SWITCH_UNITS][N_SWITCH_CONTROLS];
+
+static int
+switch_control_index(opennsl_switch_control_t type)
+{
+    int i;
+
+    for (i = 0; i < N_SWITCH_CONTROLS; i++) {
+        if (switch_controls[i].type == type) {
+            return i;
+        }
+    }
+    return -1;
+
+} // switch_control_index
+
+int
+ops_switch_control_init(int hw_unit)
+{
+    struct switch_control_shadow *shadow;
+    opennsl_error_t rc;
+    int i;
+
+    if (!VALID_HW_UNIT(hw_unit)) {
+        return 1;
+    }
+
+    ovs_mutex_lock(&switch_control_mutex);
+    for (i = 0; i < N_SWITCH_CONTROLS; i++) {
+        shadow = &switch_control_cache[hw_unit][i];
+        memset(shadow, 0, sizeof *shadow);
+
+        // A control the chip does not support stays invalid and every
+        // access to it goes to the hardware.
+        rc = opennsl_switch_control_get(hw_unit, switch_controls[i].type,
+                                        &shadow->value);
+        if (OPENNSL_SUCCESS(rc)) {
+            shadow->valid = true;
+        } else {
+            VLOG_DBG("Switch control %s not cached: unit=%d rc=%s",
+                     switch_controls[i].name, hw_unit, opennsl_errmsg(rc));
+        }
+    }
+    ovs_mutex_unlock(&switch_control_mutex);
+
+    return 0;
+
+} // ops_switch_control_init
+
+int
+ops_switch_control_get(int hw_unit, opennsl_switch_control_t type, int *value)
+{
+    struct switch_control_shadow *shadow;
+    opennsl_error_t rc;
+    int idx;
+
+    idx = switch_control_index(type);
+    if (!VALID_HW_UNIT(hw_unit) || (idx < 0)) {
+        return opennsl_switch_control_get(hw_unit, type, value);
+    }
+
+    shadow = &switch_control_cache[hw_unit][idx];
+    ovs_mutex_lock(&switch_control_mutex);
+    if (shadow->valid) {
+        *value = shadow->value;
+        rc = OPENNSL_E_NONE;
+    } else {
+        rc = opennsl_switch_control_get(hw_unit, type, value);
+        if (OPENNSL_SUCCESS(rc)) {
+            shadow->value = *value;
+            shadow->valid = true;
+        }
+    }
+    ovs_mutex_unlock(&switch_control_mutex);
+
+    return rc;
+
+} // ops_switch_control_get
+
+int
+ops_switch_control_set(int hw_unit, opennsl_switch_control_t type, int value)
+{
+    struct switch_control_shadow *shadow;
+    opennsl_error_t rc;
+    int idx;
+
+    idx = switch_control_index(type);
+    if (!VALID_HW_UNIT(hw_unit) || (idx < 0)) {
+        return opennsl_switch_control_set(hw_unit, type, value);
+    }
+
+    shadow = &switch_control_cache[hw_unit][idx];
+    ovs_mutex_lock(&switch_control_mutex);
+    if (shadow->valid && (shadow->value == value)) {
+        shadow->suppressed++;
+        rc = OPENNSL_E_NONE;
+    } else {
+        rc = opennsl_switch_control_set(hw_unit, type, value);
+        shadow->hw_writes++;
+        if (OPENNSL_SUCCESS(rc)) {
+            shadow->value = value;
+            shadow->valid = true;
+        } else {
+            // The hardware state is unknown after a failed write.
+            shadow->valid = false;
+        }
+    }
+    ovs_mutex_unlock(&switch_control_mutex);
+
+    return rc;
+
+} // ops_switch_control_set
+
+void
+ops_switch_control_dump(struct ds *ds)
+{
+    struct switch_control_shadow *shadow;
+    int unit, i;
+
+    ds_put_format(ds, "%-4s %-30s %10s %10s %10s\n",
+                  "Unit", "Control", "Value", "HW writes", "Suppressed");
+    ds_put_format(ds, "-----------------------------------------------"
+                  "-------------------------\n");
+
+    ovs_mutex_lock(&switch_control_mutex);
+    for (unit = 0; unit <= MAX_SWITCH_UNIT_ID; unit++) {
+        for (i = 0; i < N_SWITCH_CONTROLS; i++) {
+            shadow = &switch_control_cache[unit][i];
+            if (shadow->valid) {
+                ds_put_format(ds, "%-4d %-30s 0x%08x %10u %10u\n",
+                              unit, switch_controls[i].name, shadow->value,
+                              shadow->hw_writes, shadow->suppressed);
+            } else {
+                ds_put_format(ds, "%-4d %-30s %10s %10u %10u\n",
+                              unit, switch_controls[i].name, "-",
+                              shadow->hw_writes, shadow->suppressed);
+            }
+        }
+    }
+    ovs_mutex_unlock(&switch_control_mutex);
+
+} // ops_switch_control_dump
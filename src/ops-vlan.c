@@ -30,9 +30,11 @@
 
 #include "platform-defines.h"
 #include "ops-debug.h"
+#include "ops-hw-queue.h"
 #include "ops-pbmp.h"
 #include "ops-port.h"
 #include "ops-vlan.h"
+#include "ops-stats.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_vlan);
 
@@ -251,6 +253,8 @@ native_vlan_set(int unit, int vid, opennsl_pbmp_t bmp, int strictly_untagged)
     }
 
     OPENNSL_PBMP_ITER(bmp, hw_port) {
+        // A membership change still queued on the port runs first.
+        ops_hw_queue_sync(ops_hw_obj_port(unit, hw_port));
         rc = opennsl_port_untagged_vlan_set(unit, hw_port, vid);
         if (OPENNSL_FAILURE(rc)) {
             VLOG_ERR("Error setting native vlan on unit=%d "
@@ -299,6 +303,8 @@ native_vlan_clear(int unit, opennsl_pbmp_t bmp, int strictly_untagged)
     }
 
     OPENNSL_PBMP_ITER(bmp, hw_port) {
+        // The port must leave the VLAN before its PVID moves off it.
+        ops_hw_queue_sync(ops_hw_obj_port(unit, hw_port));
         rc = opennsl_port_untagged_vlan_set(unit, hw_port, def_vid);
         if (OPENNSL_FAILURE(rc)) {
             VLOG_ERR("Error setting native vlan on unit=%d "
@@ -327,11 +333,14 @@ hw_create_vlan(int unit, int vid)
 
     SW_VLAN_DBG("entry: unit=%d, vid=%d", unit, vid);
 
+    ops_hw_queue_sync(ops_hw_obj_vlan(unit, vid));
     rc = opennsl_vlan_create(unit, vid);
     if (OPENNSL_FAILURE(rc) && (rc != OPENNSL_E_EXISTS)) {
         // Ignore duplicated create requests.
         VLOG_ERR("Unit %d VLAN %d create error, rc=%d (%s)",
                  unit, vid, rc, opennsl_errmsg(rc));
+    } else if (OPENNSL_SUCCESS(rc)) {
+        ops_hw_table_update(unit, OPS_HW_TABLE_VLAN, 1);
     }
 
     SW_VLAN_DBG("done: rc=%s", opennsl_errmsg(rc));
@@ -345,21 +354,37 @@ hw_destroy_vlan(int unit, int vid)
 
     SW_VLAN_DBG("entry: unit=%d, vid=%d", unit, vid);
 
+    // Port changes still queued must not land on a later VLAN.
+    ops_hw_queue_sync(ops_hw_obj_vlan(unit, vid));
     rc = opennsl_vlan_destroy(unit, vid);
     if (OPENNSL_FAILURE(rc)) {
         VLOG_ERR("Unit %d, VLAN %d destroy error, rc=%d (%s)",
                  unit, vid, rc, opennsl_errmsg(rc));
+    } else {
+        ops_hw_table_update(unit, OPS_HW_TABLE_VLAN, -1);
     }
 
     SW_VLAN_DBG("done: rc=%s", opennsl_errmsg(rc));
 
 } // hw_destroy_vlan
 
+static void
+hw_vlan_ports_done(struct ops_hw_cmd *cmd)
+{
+    if (OPENNSL_FAILURE(cmd->rc)) {
+        VLOG_ERR("Error %s vlan vid=%d, rc=%s",
+                 (cmd->type == OPS_HW_CMD_VLAN_PORT_ADD) ?
+                 "adding ports to" : "removing ports from",
+                 cmd->vlan.vid, opennsl_errmsg(cmd->rc));
+    }
+
+} // hw_vlan_ports_done
+
 static void
 hw_add_ports_to_vlan(int unit, opennsl_pbmp_t all_bmp, opennsl_pbmp_t untagged_bmp,
                      int vid, int strictly_untagged)
 {
-    opennsl_error_t rc = OPENNSL_E_NONE;
+    struct ops_hw_cmd cmd;
 
     if (SW_VLAN_DBG_ENABLED()) {
         char a_pfmt[_SHR_PBMP_FMT_LEN];
@@ -376,13 +401,14 @@ hw_add_ports_to_vlan(int unit, opennsl_pbmp_t all_bmp, opennsl_pbmp_t untagged_b
         native_vlan_set(unit, vid, untagged_bmp, strictly_untagged);
     }
 
-    // Finally, add ports to VLAN.
+    // Finally, add ports to VLAN.  The programming thread does it.
     if (OPENNSL_PBMP_NOT_NULL(all_bmp)) {
-        rc = opennsl_vlan_port_add(unit, vid, all_bmp, untagged_bmp);
-        if (OPENNSL_FAILURE(rc)) {
-            VLOG_ERR("Error adding ports to vlan vid=%d, rc=%s",
-                     vid, opennsl_errmsg(rc));
-        }
+        ops_hw_cmd_init(&cmd, OPS_HW_CMD_VLAN_PORT_ADD, unit);
+        cmd.vlan.vid = vid;
+        cmd.vlan.pbmp = all_bmp;
+        cmd.vlan.ubmp = untagged_bmp;
+        cmd.done = hw_vlan_ports_done;
+        ops_hw_queue_submit(&cmd);
     }
 
     SW_VLAN_DBG("done");
@@ -393,7 +419,7 @@ static void
 hw_del_ports_from_vlan(int unit, opennsl_pbmp_t all_bmp, opennsl_pbmp_t untagged_bmp,
                        int vid, int strictly_untagged)
 {
-    opennsl_error_t rc = OPENNSL_E_NONE;
+    struct ops_hw_cmd cmd;
 
     if (SW_VLAN_DBG_ENABLED()) {
         char a_pfmt[_SHR_PBMP_FMT_LEN];
@@ -405,13 +431,13 @@ hw_del_ports_from_vlan(int unit, opennsl_pbmp_t all_bmp, opennsl_pbmp_t untagged
                     strictly_untagged);
     }
 
-    // Remove ports from VLAN.
+    // Remove ports from VLAN.  The programming thread does it.
     if (OPENNSL_PBMP_NOT_NULL(all_bmp)) {
-        rc = opennsl_vlan_port_remove(unit, vid, all_bmp);
-        if (OPENNSL_FAILURE(rc)) {
-            VLOG_ERR("Error removing ports from vlan vid=%d, rc=%s",
-                     vid, opennsl_errmsg(rc));
-        }
+        ops_hw_cmd_init(&cmd, OPS_HW_CMD_VLAN_PORT_REMOVE, unit);
+        cmd.vlan.vid = vid;
+        cmd.vlan.pbmp = all_bmp;
+        cmd.done = hw_vlan_ports_done;
+        ops_hw_queue_submit(&cmd);
     }
 
     // Update default VLAN ID of the ports if untagged.
@@ -813,8 +839,16 @@ bcmsdk_del_access_ports(int vid, opennsl_pbmp_t *pbm)
 void
 bcmsdk_add_trunk_ports(int vid, opennsl_pbmp_t *pbm)
 {
-    int unit;
+    bcmsdk_add_trunk_ports_range(vid, vid, pbm);
+
+} // bcmsdk_add_trunk_ports
+
+void
+bcmsdk_add_trunk_ports_range(int first_vid, int last_vid, opennsl_pbmp_t *pbm)
+{
+    int unit, vid;
     ops_vlan_data_t *vlanp = NULL;
+    opennsl_pbmp_t link_pbm[MAX_SWITCH_UNITS];
 
     // A TRUNK port carries packets on one or more specified
     // VLANs specified in the trunks column (often,  on  every
@@ -829,38 +863,40 @@ bcmsdk_add_trunk_ports(int vid, opennsl_pbmp_t *pbm)
     //
     // OpenSwitch NOTE: h/w switches does not support VLAN 0.
 
-    SW_VLAN_DBG("%s entry: vid=%d", __FUNCTION__, vid);
-
-    vlanp = get_vlan_data(vid, false);
-    if (!vlanp) {
-        VLOG_ERR("Failed to allocate & save trunk ports "
-                 "for VID %d", vid);
-        return;
-    }
+    SW_VLAN_DBG("%s entry: vid=%d-%d", __FUNCTION__, first_vid, last_vid);
 
+    // Link state is the same for every VLAN of the range.
     for (unit = 0; unit <= MAX_SWITCH_UNIT_ID; unit++) {
-        opennsl_pbmp_t bcm_pbm;
-
-        // Save trunk port membership info.
-        bcm_pbm = pbm[unit];
-        OPENNSL_PBMP_OR(vlanp->cfg_trunk_ports[unit], bcm_pbm);
+        link_pbm[unit] = pbm[unit];
+        OPENNSL_PBMP_AND(link_pbm[unit], ops_get_link_up_pbm(unit));
+    }
 
-        // Filter out ports that are not linked up.
-        OPENNSL_PBMP_AND(bcm_pbm, ops_get_link_up_pbm(unit));
+    for (vid = first_vid; vid <= last_vid; vid++) {
+        vlanp = get_vlan_data(vid, false);
+        if (!vlanp) {
+            VLOG_ERR("Failed to allocate & save trunk ports "
+                     "for VID %d", vid);
+            continue;
+        }
 
-        // If any port is left, and VLAN is already created
-        // in h/w, go ahead and configure it.
-        VLOG_DBG("vlanp->hw_created = %d\n", vlanp->hw_created);
-        if (vlanp->hw_created && OPENNSL_PBMP_NOT_NULL(bcm_pbm)) {
-            // Add the ports as tagged members of the VLAN.
-            hw_add_ports_to_vlan(unit, bcm_pbm, g_empty_pbm, vid, 0);
-            OPENNSL_PBMP_OR(vlanp->hw_trunk_ports[unit], bcm_pbm);
+        for (unit = 0; unit <= MAX_SWITCH_UNIT_ID; unit++) {
+            // Save trunk port membership info.
+            OPENNSL_PBMP_OR(vlanp->cfg_trunk_ports[unit], pbm[unit]);
+
+            // If any port is linked up, and VLAN is already created
+            // in h/w, go ahead and configure it.
+            if (vlanp->hw_created && OPENNSL_PBMP_NOT_NULL(link_pbm[unit])) {
+                // Add the ports as tagged members of the VLAN.
+                hw_add_ports_to_vlan(unit, link_pbm[unit], g_empty_pbm,
+                                     vid, 0);
+                OPENNSL_PBMP_OR(vlanp->hw_trunk_ports[unit], link_pbm[unit]);
+            }
         }
     }
 
     SW_VLAN_DBG("done");
 
-} // bcmsdk_add_trunk_ports
+} // bcmsdk_add_trunk_ports_range
 
 void
 bcmsdk_add_subinterface_ports(int vid, opennsl_pbmp_t *pbm)
@@ -949,11 +985,25 @@ bcmsdk_del_subinterface_ports(int vid, opennsl_pbmp_t *pbm)
 void
 bcmsdk_del_trunk_ports(int vid, opennsl_pbmp_t *pbm)
 {
-    SW_VLAN_DBG("%s entry: vid=%d", __FUNCTION__, vid);
+    bcmsdk_del_trunk_ports_range(vid, vid, pbm);
 
-    if (ops_vlans[vid] != NULL) {
-        int unit;
-        ops_vlan_data_t *vlanp = ops_vlans[vid];
+} // bcmsdk_del_trunk_ports
+
+void
+bcmsdk_del_trunk_ports_range(int first_vid, int last_vid, opennsl_pbmp_t *pbm)
+{
+    int unit, vid;
+    ops_vlan_data_t *vlanp;
+
+    SW_VLAN_DBG("%s entry: vid=%d-%d", __FUNCTION__, first_vid, last_vid);
+
+    for (vid = first_vid; vid <= last_vid; vid++) {
+        vlanp = ops_vlans[vid];
+        if (!vlanp) {
+            VLOG_WARN("Trying to delete trunk port on VLAN %d, "
+                      "but VLAN does not exist.", vid);
+            continue;
+        }
 
         for (unit = 0; unit <= MAX_SWITCH_UNIT_ID; unit++) {
             opennsl_pbmp_t bcm_pbm;
@@ -973,15 +1023,11 @@ bcmsdk_del_trunk_ports(int vid, opennsl_pbmp_t *pbm)
 
         // Free VLAN data if necessary.
         free_vlan_data(vid, false);
-
-    } else {
-        VLOG_WARN("Trying to delete trunk port on VLAN %d, "
-                  "but VLAN does not exist.", vid);
     }
 
     SW_VLAN_DBG("done");
 
-} // bcmsdk_del_trunk_ports
+} // bcmsdk_del_trunk_ports_range
 
 void
 bcmsdk_add_native_tagged_ports(int vid, opennsl_pbmp_t *pbm)
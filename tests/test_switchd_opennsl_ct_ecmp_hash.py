@@ -15,6 +15,7 @@
 # License for the specific language governing permissions and limitations
 # under the License.
 
+import time
 import pytest
 from opstestfw import *
 from opstestfw.switch.CLI import *
@@ -24,8 +25,11 @@ from opstestfw.switch.OVS import *
 topoDict = {"topoExecution": 1000,
             "topoType": "physical",
             "topoTarget": "dut01",
-            "topoDevices": "dut01",
-            "topoFilters": "dut01:system-category:switch"}
+            "topoDevices": "dut01 wrkston01 wrkston02",
+            "topoLinks": "lnk01:dut01:wrkston01,lnk02:dut01:wrkston02",
+            "topoFilters": "dut01:system-category:switch, \
+                            wrkston01:system-category:workstation, \
+                            wrkston02:system-category:workstation"}
 
 
 def ecmp_hash_check_status(switch, is_ipv4, is_enabled):
@@ -92,6 +96,112 @@ def ecmp_hash_test(**kwargs):
     ecmp_hash_check_status(switch, False, True)
 
 
+def ecmp_resilient_status(switch):
+
+    appctl_command = "ovs-appctl plugin/debug l3ecmp"
+    retStruct = switch.DeviceInteract(command=appctl_command)
+    buf = retStruct.get('buffer')
+    ids = set()
+    n_resilient = 0
+    for curLine in buf.split('\n'):
+        if "Multipath Egress Object" in curLine:
+            ids.add(int(curLine.split()[3]))
+        if "Resilient hashing" in curLine:
+            n_resilient += 1
+    return ids, n_resilient
+
+
+def ecmp_resilient_test(**kwargs):
+
+    switch = kwargs.get('switch', None)
+    host1 = kwargs.get('host1', None)
+    host2 = kwargs.get('host2', None)
+
+    LogOutput('info', "Configure routed interfaces on switch")
+    retStruct = InterfaceEnable(deviceObj=switch, enable=True,
+                                interface=switch.linkPortMapping['lnk01'])
+    assert retStruct.returnCode() == 0, "Unable to enable interface1"
+    retStruct = InterfaceEnable(deviceObj=switch, enable=True,
+                                interface=switch.linkPortMapping['lnk02'])
+    assert retStruct.returnCode() == 0, "Unable to enable interface2"
+
+    retStruct = InterfaceIpConfig(deviceObj=switch,
+                                  interface=switch.linkPortMapping['lnk01'],
+                                  addr="10.0.10.1", mask=24, config=True)
+    assert retStruct.returnCode() == 0, "Failed to configure interface1 ip"
+    retStruct = InterfaceIpConfig(deviceObj=switch,
+                                  interface=switch.linkPortMapping['lnk02'],
+                                  addr="10.0.20.1", mask=24, config=True)
+    assert retStruct.returnCode() == 0, "Failed to configure interface2 ip"
+
+    LogOutput('info', "Configure hosts")
+    retStruct = host1.NetworkConfig(ipAddr="10.0.10.2",
+                                    netMask="255.255.255.0",
+                                    interface=host1.linkPortMapping['lnk01'],
+                                    broadcast="10.0.10.255", config=True)
+    assert retStruct.returnCode() == 0, "Failed to configure host1 ip"
+    retStruct = host2.NetworkConfig(ipAddr="10.0.20.2",
+                                    netMask="255.255.255.0",
+                                    interface=host2.linkPortMapping['lnk02'],
+                                    broadcast="10.0.20.255", config=True)
+    assert retStruct.returnCode() == 0, "Failed to configure host2 ip"
+
+    # Resolve both nexthops so that the route gets an ecmp group
+    retStruct = host1.Ping(ipAddr="10.0.10.1", packetCount=1)
+    assert retStruct.returnCode() == 0, "Failed to ping from host1"
+    retStruct = host2.Ping(ipAddr="10.0.20.1", packetCount=1)
+    assert retStruct.returnCode() == 0, "Failed to ping from host2"
+
+    LogOutput('info', "Configure an ecmp route with resilient hashing off")
+    switch.VtyshShell(enter=True)
+    switch.ConfigVtyShell(enter=True)
+    switch.DeviceInteract(command="ip ecmp load-balance resilient disable")
+    switch.DeviceInteract(command="ip route 70.0.0.0/24 10.0.10.2")
+    switch.DeviceInteract(command="ip route 70.0.0.0/24 10.0.20.2")
+    switch.ConfigVtyShell(enter=False)
+    switch.VtyshShell(enter=False)
+    time.sleep(5)
+
+    ecmp_ids, n_resilient = ecmp_resilient_status(switch)
+    assert len(ecmp_ids) > 0, "No ecmp object in ASIC for the route"
+    assert n_resilient == 0, "Ecmp groups in resilient mode while disabled"
+
+    LogOutput('info', "Enable resilient hashing")
+    switch.VtyshShell(enter=True)
+    switch.ConfigVtyShell(enter=True)
+    switch.DeviceInteract(command="no ip ecmp load-balance resilient disable")
+    switch.ConfigVtyShell(enter=False)
+    switch.VtyshShell(enter=False)
+    time.sleep(5)
+
+    # Every group is converted in place, keeping its ecmp object id
+    resilient_ids, n_resilient = ecmp_resilient_status(switch)
+    assert resilient_ids == ecmp_ids, \
+        "Ecmp objects %s were replaced by %s" % (ecmp_ids, resilient_ids)
+    assert n_resilient == len(ecmp_ids), \
+        "Only %d of %d ecmp groups in resilient mode" % (n_resilient,
+                                                        len(ecmp_ids))
+
+    retStruct = host1.Ping(ipAddr="10.0.20.2", packetCount=1)
+    assert retStruct.returnCode() == 0, "Failed to route in resilient mode"
+
+    LogOutput('info', "Disable resilient hashing")
+    switch.VtyshShell(enter=True)
+    switch.ConfigVtyShell(enter=True)
+    switch.DeviceInteract(command="ip ecmp load-balance resilient disable")
+    switch.ConfigVtyShell(enter=False)
+    switch.VtyshShell(enter=False)
+    time.sleep(5)
+
+    resilient_ids, n_resilient = ecmp_resilient_status(switch)
+    assert resilient_ids == ecmp_ids, \
+        "Ecmp objects %s were replaced by %s" % (ecmp_ids, resilient_ids)
+    assert n_resilient == 0, "Ecmp groups left in resilient mode"
+
+    retStruct = host1.Ping(ipAddr="10.0.20.2", packetCount=1)
+    assert retStruct.returnCode() == 0, "Failed to route after resilient mode"
+
+
 class Test_ecmp_hash_ct:
 
     def setup_class(cls):
@@ -110,3 +220,10 @@ class Test_ecmp_hash_ct:
             assert "Test failed"
         else:
             LogOutput('info', "\n### Test Passed ###\n")
+
+    def test_ecmp_resilient_ct(self):
+        dut01Obj = self.topoObj.deviceObjGet(device="dut01")
+        wrkston01Obj = self.topoObj.deviceObjGet(device="wrkston01")
+        wrkston02Obj = self.topoObj.deviceObjGet(device="wrkston02")
+        ecmp_resilient_test(switch=dut01Obj, host1=wrkston01Obj,
+                            host2=wrkston02Obj)
@@ -15,6 +15,7 @@
 # License for the specific language governing permissions and limitations
 # under the License.
 
+import time
 import pytest
 from opstestfw import *
 from opstestfw.switch.CLI import *
@@ -443,6 +444,44 @@ def mac_move(**kwargs):
     assert retCode == 0, "\n#### FAIL: IPv6 ping from host2 to host3. ####"
     LogOutput('info', "\n#### PASS: IPv6 ping from host2 to host3. ####")
 
+    # Flap the mac between interface1 and interface2. The egress objects of
+    # the neighbor are rewritten once the mac settled, so traffic must
+    # follow the last move.
+    for _ in range(3):
+        for (up, down, host) in (('lnk01', 'lnk02', host1),
+                                 ('lnk02', 'lnk01', host2)):
+            retStruct = InterfaceEnable(
+                deviceObj=switch,
+                enable=False,
+                interface=switch.linkPortMapping[down])
+            retCode = retStruct.returnCode()
+            assert retCode == 0, "Unable to shutdown %s on switch1" % down
+
+            retStruct = InterfaceEnable(
+                deviceObj=switch,
+                enable=True,
+                interface=switch.linkPortMapping[up])
+            retCode = retStruct.returnCode()
+            assert retCode == 0, "Unable to no-shutdown %s on switch1" % up
+
+            retStruct = host.Ping(ipAddr="11.0.0.2", packetCount=1)
+
+    # Let the last move settle
+    time.sleep(1)
+
+    # TEST: IPv4 and IPv6 Ping from host2 to host3 after the mac flapped
+    LogOutput('info', "\n\n\nTEST: IPv4 ping from host2 to host3 after flaps")
+    retStruct = host2.Ping(ipAddr="11.0.0.2", packetCount=1)
+    retCode = retStruct.returnCode()
+    assert retCode == 0, "\n#### FAIL: IPv4 ping after mac flaps. ####"
+    LogOutput('info', "\n#### PASS: IPv4 ping after mac flaps. ####")
+
+    LogOutput('info', "\n\n\nTEST: IPv6 ping from host2 to host3 after flaps")
+    retStruct = host2.Ping(ipAddr="2000::2", packetCount=1, ipv6Flag=True)
+    retCode = retStruct.returnCode()
+    assert retCode == 0, "\n#### FAIL: IPv6 ping after mac flaps. ####"
+    LogOutput('info', "\n#### PASS: IPv6 ping after mac flaps. ####")
+
 
 @pytest.mark.timeout(1000)
 class Test_mac_move:
@@ -0,0 +1,160 @@
+#!/usr/bin/python
+
+# (c) Copyright 2015 Hewlett Packard Enterprise Development LP
+#
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may
+# not use this file except in compliance with the License. You may obtain
+# a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+# License for the specific language governing permissions and limitations
+# under the License.
+
+import time
+import pytest
+from opstestfw import *
+from opstestfw.switch.CLI import *
+from opstestfw.switch.OVS import *
+
+# Topology definition
+topoDict = {"topoExecution": 1000,
+            "topoType": "physical",
+            "topoTarget": "dut01",
+            "topoDevices": "dut01 wrkston01 wrkston02",
+            "topoLinks": "lnk01:dut01:wrkston01,lnk02:dut01:wrkston02",
+            "topoFilters": "dut01:system-category:switch, \
+                            wrkston01:system-category:workstation, \
+                            wrkston02:system-category:workstation"}
+
+# OPENNSL_BOOT_FLAGS value asking the SDK for a warm boot
+WARM_BOOT_FLAGS = "0x200000"
+
+
+def ecmp_object_ids(switch):
+
+    appctl_command = "ovs-appctl plugin/debug l3ecmp"
+    retStruct = switch.DeviceInteract(command=appctl_command)
+    buf = retStruct.get('buffer')
+    ids = set()
+    for curLine in buf.split('\n'):
+        if "Multipath Egress Object" in curLine:
+            ids.add(int(curLine.split()[3]))
+    return ids
+
+
+def reconcile_counters(switch):
+
+    appctl_command = "ovs-appctl plugin/debug l3warm"
+    retStruct = switch.DeviceInteract(command=appctl_command)
+    buf = retStruct.get('buffer')
+    counters = {}
+    for curLine in buf.split('\n'):
+        if "ECMP taken over" in curLine:
+            counters['taken'] = int(curLine.split(':')[1])
+        if "ECMP reused" in curLine:
+            counters['reused'] = int(curLine.split(':')[1])
+    return counters
+
+
+def warm_boot_test(**kwargs):
+
+    switch = kwargs.get('switch', None)
+    host1 = kwargs.get('host1', None)
+    host2 = kwargs.get('host2', None)
+
+    LogOutput('info', "Configure routed interfaces on switch")
+    retStruct = InterfaceEnable(deviceObj=switch, enable=True,
+                                interface=switch.linkPortMapping['lnk01'])
+    assert retStruct.returnCode() == 0, "Unable to enable interface1"
+    retStruct = InterfaceEnable(deviceObj=switch, enable=True,
+                                interface=switch.linkPortMapping['lnk02'])
+    assert retStruct.returnCode() == 0, "Unable to enable interface2"
+
+    retStruct = InterfaceIpConfig(deviceObj=switch,
+                                  interface=switch.linkPortMapping['lnk01'],
+                                  addr="10.0.10.1", mask=24, config=True)
+    assert retStruct.returnCode() == 0, "Failed to configure interface1 ip"
+    retStruct = InterfaceIpConfig(deviceObj=switch,
+                                  interface=switch.linkPortMapping['lnk02'],
+                                  addr="10.0.20.1", mask=24, config=True)
+    assert retStruct.returnCode() == 0, "Failed to configure interface2 ip"
+
+    LogOutput('info', "Configure hosts")
+    retStruct = host1.NetworkConfig(ipAddr="10.0.10.2",
+                                    netMask="255.255.255.0",
+                                    interface=host1.linkPortMapping['lnk01'],
+                                    broadcast="10.0.10.255", config=True)
+    assert retStruct.returnCode() == 0, "Failed to configure host1 ip"
+    retStruct = host2.NetworkConfig(ipAddr="10.0.20.2",
+                                    netMask="255.255.255.0",
+                                    interface=host2.linkPortMapping['lnk02'],
+                                    broadcast="10.0.20.255", config=True)
+    assert retStruct.returnCode() == 0, "Failed to configure host2 ip"
+
+    # Resolve both nexthops so that the route gets an ecmp group
+    retStruct = host1.Ping(ipAddr="10.0.10.1", packetCount=1)
+    assert retStruct.returnCode() == 0, "Failed to ping from host1"
+    retStruct = host2.Ping(ipAddr="10.0.20.1", packetCount=1)
+    assert retStruct.returnCode() == 0, "Failed to ping from host2"
+
+    LogOutput('info', "Configure an ecmp route")
+    switch.VtyshShell(enter=True)
+    switch.ConfigVtyShell(enter=True)
+    switch.DeviceInteract(command="ip route 70.0.0.0/24 10.0.10.2")
+    switch.DeviceInteract(command="ip route 70.0.0.0/24 10.0.20.2")
+    switch.ConfigVtyShell(enter=False)
+    switch.VtyshShell(enter=False)
+    time.sleep(5)
+
+    ecmp_before = ecmp_object_ids(switch)
+    assert len(ecmp_before) > 0, "No ecmp object in ASIC for the route"
+
+    LogOutput('info', "Warm restart of switchd")
+    switch.DeviceInteract(command="systemctl set-environment "
+                                  "OPENNSL_BOOT_FLAGS=%s" % WARM_BOOT_FLAGS)
+    switch.DeviceInteract(command="systemctl restart switchd")
+    switch.DeviceInteract(command="systemctl unset-environment "
+                                  "OPENNSL_BOOT_FLAGS")
+    time.sleep(30)
+
+    # End the reconciliation now rather than waiting for it to time out
+    switch.DeviceInteract(command="ovs-appctl plugin/debug l3warm done")
+
+    counters = reconcile_counters(switch)
+    assert counters.get('taken', 0) >= len(ecmp_before), \
+        "Ecmp groups of the previous run were not taken over"
+    assert counters.get('reused', 0) >= len(ecmp_before), \
+        "Ecmp groups taken over were not reused by the route"
+
+    ecmp_after = ecmp_object_ids(switch)
+    assert ecmp_before <= ecmp_after, \
+        "Ecmp objects %s were replaced by %s" % (ecmp_before, ecmp_after)
+    LogOutput('info', "Ecmp groups reused across the warm restart")
+
+    retStruct = host1.Ping(ipAddr="10.0.20.2", packetCount=1)
+    assert retStruct.returnCode() == 0, "Failed to route after warm restart"
+
+
+@pytest.mark.timeout(1000)
+class Test_warm_boot_ct:
+
+    def setup_class(cls):
+        # Test object will parse command line and formulate the env
+        Test_warm_boot_ct.testObj = testEnviron(topoDict=topoDict)
+        # Get topology object
+        Test_warm_boot_ct.topoObj = Test_warm_boot_ct.testObj.topoObjGet()
+
+    def teardown_class(cls):
+        Test_warm_boot_ct.topoObj.terminate_nodes()
+
+    def test_warm_boot_ct(self):
+        dut01Obj = self.topoObj.deviceObjGet(device="dut01")
+        wrkston01Obj = self.topoObj.deviceObjGet(device="wrkston01")
+        wrkston02Obj = self.topoObj.deviceObjGet(device="wrkston02")
+        warm_boot_test(switch=dut01Obj, host1=wrkston01Obj,
+                       host2=wrkston02Obj)